@@ -14,6 +14,7 @@
 //  Version: 1/20/26
 //
 #include "App.h"
+#include "AudioController.h"
 
 using namespace cugl;
 using namespace cugl::graphics;
@@ -74,8 +75,12 @@ void DemoApp::onStartup() {
     _batch  = SpriteBatch::alloc();
     auto cam = OrthographicCamera::alloc(getDisplaySize());
     
-    // Start-up basic input (DESKTOP ONLY)
+    // Start-up basic input
+#ifdef CU_TOUCH_SCREEN
+    Input::activate<Touchscreen>();
+#else
     Input::activate<Mouse>();
+#endif
     Input::activate<Keyboard>();
 
     _assets->attach<Texture>(TextureLoader::alloc()->getHook());
@@ -96,7 +101,7 @@ void DemoApp::onStartup() {
     // Queue up the other assets
     _loading.start();
 
-    AudioEngine::start();
+    AudioController::init(_assets);
     Application::onStartup(); // YOU MUST END with call to parent
 }
 
@@ -114,14 +119,19 @@ void DemoApp::onStartup() {
 void DemoApp::onShutdown() {
     _loading.dispose();
     _gameplay.dispose();
+    _calibration.dispose();
     _assets = nullptr;
     _batch = nullptr;
 
     // Shutdown input
     Input::deactivate<Keyboard>();
+#ifdef CU_TOUCH_SCREEN
+    Input::deactivate<Touchscreen>();
+#else
     Input::deactivate<Mouse>();
+#endif
 
-    AudioEngine::stop();
+    AudioController::shutdown();
     Application::onShutdown();  // YOU MUST END with call to parent
 }
 
@@ -138,6 +148,9 @@ void DemoApp::onShutdown() {
  */
 void DemoApp::onSuspend() {
     AudioEngine::get()->pause();
+    if (_loaded) {
+        _gameplay.flushLog();
+    }
 }
 
 /**
@@ -173,9 +186,25 @@ void DemoApp::update(float dt) {
         _loading.dispose(); // Disables the input listeners in this mode
         _gameplay.init(_assets);
         _gameplay.setSpriteBatch(_batch);
+        _calibration.init(_assets);
+        _calibration.setSpriteBatch(_batch);
         _loaded = true;
+        // Calibrate new devices before playing
+        if (!AudioController::hasCalibration()) {
+            _gameplay.setPaused(true);
+            _calibration.start();
+        }
+    } else if (_calibration.isRunning()) {
+        _calibration.update(dt);
+        if (!_calibration.isRunning()) {
+            _gameplay.setPaused(false);
+        }
     } else {
         _gameplay.update(dt);
+        if (_gameplay.didRequestCalibration()) {
+            _gameplay.setPaused(true);
+            _calibration.start();
+        }
     }
 }
 
@@ -192,6 +221,8 @@ void DemoApp::update(float dt) {
 void DemoApp::draw() {
     if (!_loaded) {
         _loading.render();
+    } else if (_calibration.isRunning()) {
+        _calibration.render();
     } else {
         _gameplay.render();
     }
@@ -17,6 +17,7 @@
 #define __APP_H__
 #include <cugl/cugl.h>
 #include "GameScene.h"
+#include "CalibrationScene.h"
 
 /**
  * This class represents the application root for the ship demo.
@@ -33,6 +34,8 @@ protected:
     GameScene _gameplay;
     /** The controller for the loading screen */
     cugl::scene2::LoadingScene _loading;
+    /** The controller for the tap calibration */
+    CalibrationScene _calibration;
 
     /** Whether or not we have finished loading all assets */
     bool _loaded;
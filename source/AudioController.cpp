@@ -8,14 +8,50 @@
 using namespace cugl;
 using namespace cugl::audio;
 
+/**
+ * The number of device buffers between the engine and the speaker: the one
+ * being played and the one being filled.
+ */
+#define OUTPUT_BUFFERS  2
+/** The file in the save directory with the offset of each device */
+#define CALIBRATION_FILE    "calibration.json"
+
 std::shared_ptr<AssetManager> AudioController::_assets = nullptr;
 std::shared_ptr<AudioQueue> AudioController::_queue = nullptr;
+AudioController::DeviceProbe AudioController::_probe = nullptr;
+AudioController::OutputInfo AudioController::_output = {"", 0, 0};
+SongTime AudioController::_latency;
+SongTime AudioController::_calibration;
+bool AudioController::_calibrated = false;
+
+/**
+ * Reads the output of the AudioEngine.
+ */
+static bool readEngineOutput(AudioController::OutputInfo& info) {
+    AudioEngine* engine = AudioEngine::get();
+    std::shared_ptr<AudioOutput> output = engine == nullptr ? nullptr : engine->getOutput();
+    if (output == nullptr) {
+        return false;
+    }
+    info.device = output->getDevice();
+    info.rate = output->getRate();
+    info.frames = output->getReadSize();
+    return true;
+}
+
+/**
+ * Returns the key of a device in the calibration file.
+ */
+static std::string deviceKey(const AudioController::OutputInfo& info) {
+    return info.device.empty() ? "default" : info.device;
+}
 
 void AudioController::init(const std::shared_ptr<AssetManager>& assets) {
     _assets = assets;
     
     AudioEngine::start();
     _queue = AudioEngine::get()->getMusicQueue();
+    measureLatency();
 }
 
 void AudioController::shutdown() {
@@ -41,3 +77,106 @@ void AudioController::playSFX(const std::string& key) {
     auto sfx = _assets->get<cugl::audio::Sound>(key);
     AudioEngine::get()->play(key, sfx);
 }
+
+#pragma mark -
+#pragma mark Output Latency
+/**
+ * Measures the output latency of the current device.
+ */
+void AudioController::measureLatency() {
+    OutputInfo info = {"", 0, 0};
+    bool active = _probe ? _probe(info) : readEngineOutput(info);
+    _output = info;
+    _latency = active ? computeLatency(info) : SongTime();
+    CULog("Audio output '%s' latency %.1f ms", info.device.c_str(), _latency.toMillis());
+    loadCalibration();
+}
+
+/**
+ * Remeasures the output latency if the output device has changed.
+ */
+bool AudioController::checkDevice() {
+    OutputInfo info = {"", 0, 0};
+    bool active = _probe ? _probe(info) : readEngineOutput(info);
+    if (!active) {
+        info = {"", 0, 0};
+    }
+    if (info.device == _output.device && info.rate == _output.rate && info.frames == _output.frames) {
+        return false;
+    }
+    measureLatency();
+    return true;
+}
+
+/**
+ * Replaces the function used to read the output device.
+ */
+void AudioController::setDeviceProbe(const DeviceProbe& probe) {
+    _probe = probe;
+    measureLatency();
+}
+
+/**
+ * Returns the output latency of a device.
+ */
+SongTime AudioController::computeLatency(const OutputInfo& info) {
+    if (info.rate == 0) {
+        return SongTime();
+    }
+    return SongTime::fromSamples((Sint64)info.frames*OUTPUT_BUFFERS, info.rate);
+}
+
+#pragma mark -
+#pragma mark Calibration
+/**
+ * Loads the input offset of the current device.
+ */
+void AudioController::loadCalibration() {
+    _calibration = SongTime();
+    _calibrated = false;
+
+    std::string path = Application::get()->getSaveDirectory() + CALIBRATION_FILE;
+    std::shared_ptr<JsonReader> reader = JsonReader::alloc(path);
+    if (reader == nullptr) {
+        return;
+    }
+    std::shared_ptr<JsonValue> json = reader->readJson();
+    reader->close();
+    if (json != nullptr && json->has(deviceKey(_output))) {
+        _calibration = SongTime::fromMillis(json->get(deviceKey(_output))->asDouble());
+        _calibrated = true;
+    }
+}
+
+/**
+ * Sets and saves the input offset of the current device.
+ */
+void AudioController::setCalibration(SongTime offset) {
+    _calibration = offset;
+    _calibrated = true;
+
+    // Keep the offsets of the other devices
+    std::string path = Application::get()->getSaveDirectory() + CALIBRATION_FILE;
+    std::shared_ptr<JsonValue> json = nullptr;
+    std::shared_ptr<JsonReader> reader = JsonReader::alloc(path);
+    if (reader != nullptr) {
+        json = reader->readJson();
+        reader->close();
+    }
+    if (json == nullptr) {
+        json = JsonValue::allocObject();
+    }
+    if (json->has(deviceKey(_output))) {
+        json->removeChild(deviceKey(_output));
+    }
+    json->appendValue(deviceKey(_output), offset.toMillis());
+
+    std::shared_ptr<JsonWriter> writer = JsonWriter::alloc(path);
+    if (writer == nullptr) {
+        CULog("Failed to create %s", path.c_str());
+        return;
+    }
+    writer->writeJson(json);
+    writer->close();
+    CULog("Calibrated '%s' to %.1f ms", deviceKey(_output).c_str(), offset.toMillis());
+}
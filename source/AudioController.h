@@ -3,15 +3,58 @@
 //
 //  Created by Felicia Chen on 2/23/26.
 //
+//  Notes:
+//  - The output latency is the time between a sample being queued by the
+//    AudioEngine and it reaching the speaker. It is measured when the
+//    engine starts and again whenever the output device changes
+//  - The device is read through a probe function, so a fake device can be
+//    substituted when testing
+//  - The tap calibration offset is also per device. It is saved in the
+//    save directory and reloaded whenever the device changes
+//
 
 #ifndef __AUDIO_CONTROLLER_H__
 #define __AUDIO_CONTROLLER_H__
 #include <cugl/cugl.h>
+#include <functional>
+#include "SongTime.h"
 
 class AudioController {
+    public:
+    /**
+     * The properties of an audio output device.
+     */
+    struct OutputInfo {
+        /** The device name (empty for the default device) */
+        std::string device;
+        /** The sample rate of the device */
+        Uint32 rate;
+        /** The number of sample frames in one device buffer */
+        Uint32 frames;
+    };
+    
+    /**
+     * A function that reads the current output device, returning false if
+     * there is no active device.
+     */
+    typedef std::function<bool(OutputInfo& info)> DeviceProbe;
+    
     private:
         static std::shared_ptr<cugl::AssetManager> _assets;
         static std::shared_ptr<cugl::audio::AudioQueue> _queue;
+        /** The function used to read the output device */
+        static DeviceProbe _probe;
+        /** The output device at the last measurement */
+        static OutputInfo _output;
+        /** The measured output latency */
+        static SongTime _latency;
+        /** The input offset of the current device */
+        static SongTime _calibration;
+        /** Whether the current device has been calibrated */
+        static bool _calibrated;
+    
+        /** Loads the input offset of the current device */
+        static void loadCalibration();
     
     //hard coded, delete later
     int _bpm = 70;
@@ -27,5 +70,87 @@ class AudioController {
     
         static void playSFX(const std::string& key);
     
+#pragma mark -
+#pragma mark Output Latency
+    /**
+     * Returns the measured output latency.
+     *
+     * This is how long after the AudioEngine plays a sample that it is
+     * heard, so the audible song position is the engine position minus
+     * this value.
+     *
+     * @return the measured output latency
+     */
+    static SongTime getLatency() { return _latency; }
+    
+    /**
+     * Returns the output device at the last measurement.
+     *
+     * @return the output device at the last measurement
+     */
+    static const OutputInfo& getOutput() { return _output; }
+    
+    /**
+     * Measures the output latency of the current device.
+     *
+     * This is called automatically by init. It can be called again at any
+     * time to force a new measurement.
+     */
+    static void measureLatency();
+    
+    /**
+     * Remeasures the output latency if the output device has changed.
+     *
+     * This should be called once per frame.
+     *
+     * @return true if the device changed
+     */
+    static bool checkDevice();
+    
+    /**
+     * Replaces the function used to read the output device.
+     *
+     * Passing nullptr restores the default, which reads the output of the
+     * AudioEngine. The latency is remeasured immediately.
+     *
+     * @param probe The function to read the output device
+     */
+    static void setDeviceProbe(const DeviceProbe& probe);
+    
+    /**
+     * Returns the output latency of a device.
+     *
+     * @param info  The output device
+     *
+     * @return the output latency of a device
+     */
+    static SongTime computeLatency(const OutputInfo& info);
+    
+#pragma mark -
+#pragma mark Calibration
+    /**
+     * Returns true if the current device has been calibrated.
+     *
+     * @return true if the current device has been calibrated
+     */
+    static bool hasCalibration() { return _calibrated; }
+    
+    /**
+     * Returns the input offset of the current device.
+     *
+     * This is how late the player's inputs are relative to the audible beat,
+     * as measured by the tap calibration. It is zero if the device has not
+     * been calibrated.
+     *
+     * @return the input offset of the current device
+     */
+    static SongTime getCalibration() { return _calibration; }
+    
+    /**
+     * Sets and saves the input offset of the current device.
+     *
+     * @param offset    The input offset of the current device
+     */
+    static void setCalibration(SongTime offset);
 };
 #endif /*__AUDIO_CONTROLLER_H__*/
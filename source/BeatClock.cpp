@@ -0,0 +1,116 @@
+//
+//  BeatClock.cpp
+//  Demo
+//
+//  This is the implementation for the BeatClock class.
+//
+#include "BeatClock.h"
+
+using namespace cugl;
+using namespace cugl::audio;
+
+/** Differences larger than this are applied at once instead of smoothed */
+constexpr SongTime SNAP_THRESHOLD = SongTime::fromMillis(50);
+/** The reciprocal of the fraction of the audio/frame error corrected each frame */
+#define SMOOTHING       10
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates a new beat clock with the default values.
+ */
+BeatClock::BeatClock() :
+    _loops(0),
+    _playing(false) {
+}
+
+/**
+ * Initializes this clock to follow the given voice.
+ */
+bool BeatClock::init(const std::string& voice, const std::shared_ptr<Sound>& sound, const TempoMap& tempo) {
+    if (sound == nullptr) {
+        return false;
+    }
+    _voice = voice;
+    _duration = SongTime::fromSamples(sound->getLength(), sound->getRate());
+    _tempo = tempo;
+    reset();
+    return true;
+}
+
+/**
+ * Resets this clock to the start of the song.
+ */
+void BeatClock::reset() {
+    _loops = 0;
+    _rawPosition = SongTime();
+    _position = SongTime();
+    _beat = BeatPosition();
+    _cursor = TempoMap::Cursor();
+    _playing = false;
+    _frameStamp.mark();
+}
+
+#pragma mark -
+#pragma mark Clock Update
+/**
+ * Advances the clock one frame.
+ */
+void BeatClock::update(float dt) {
+    _frameStamp.mark();
+
+    AudioEngine* engine = AudioEngine::get();
+    _playing = engine != nullptr && engine->getState(_voice) == AudioEngine::State::PLAYING;
+    if (!_playing) {
+        // Hold still while paused so we do not run ahead of the music
+        return;
+    }
+
+    // Unwrap the position if the track looped since the last frame
+    SongTime raw = SongTime::fromSeconds(engine->getTimeElapsed(_voice)) + _duration*_loops;
+    if (_duration > SongTime() && raw < _rawPosition - _duration/2) {
+        _loops++;
+        raw += _duration;
+    }
+    _rawPosition = raw;
+    // Samples are heard one output latency after the engine plays them
+    raw -= _latency;
+
+    SongTime predicted = _position + SongTime::fromSeconds(dt);
+    SongTime error = raw - predicted;
+    SongTime next = error.abs() > SNAP_THRESHOLD ? raw : predicted + error/SMOOTHING;
+    _position = std::max(next, _position);
+    _beat = _tempo.toBeat(_position, _cursor);
+}
+
+/**
+ * Sets the output latency of the audio device.
+ */
+void BeatClock::setLatency(SongTime latency) {
+    if (latency == _latency) {
+        return;
+    }
+    _position = std::max(_position - (latency - _latency), SongTime());
+    _beat = _tempo.toBeat(_position, _cursor);
+    _latency = latency;
+}
+
+#pragma mark -
+#pragma mark Song Position
+/**
+ * Returns the song time of a wall-clock timestamp.
+ */
+SongTime BeatClock::toSongTime(const Timestamp& stamp) const {
+    if (!_playing) {
+        return _position - _inputOffset;
+    }
+    return _position + ellapsed(_frameStamp, stamp) - _inputOffset;
+}
+
+/**
+ * Returns the signed time from start to end.
+ */
+SongTime BeatClock::ellapsed(const Timestamp& start, const Timestamp& end) {
+    // The unsigned nanosecond count wraps when end is before start
+    return SongTime::fromNanos((Sint64)Timestamp::ellapsedNanos(start, end));
+}
@@ -0,0 +1,222 @@
+//
+//  BeatClock.h
+//  Demo
+//
+//  This class is the authoritative song clock for the game. Instead of
+//  measuring time with wall-clock Timestamps, it reads the playback position
+//  of the music voice from the AudioEngine, so that beats line up with what
+//  the audio device is actually playing.
+//
+//  Notes:
+//  - The audio position only advances once per audio buffer, so the raw
+//    value is smoothed against the frame clock
+//  - The song position never moves backwards (loops are unwrapped)
+//  - While the voice is paused (e.g. on suspend) the clock holds still
+//  - All times are fixed-point SongTimes, so there is no accumulated drift
+//  - Beats are measured through a TempoMap, so the tempo may change
+//  - The output latency of the device is subtracted, so the position is
+//    what the player is hearing rather than what the engine has queued
+//  - Input times are corrected by the calibrated input offset
+//
+#ifndef __BEAT_CLOCK_H__
+#define __BEAT_CLOCK_H__
+#include <cugl/cugl.h>
+#include "SongTime.h"
+#include "TempoMap.h"
+
+/**
+ * A song clock driven by the audio playback position.
+ *
+ * The clock should be updated once per frame. Every other timing query
+ * (beat number, beat phase, the song time of an input event) is answered
+ * relative to the most recent update.
+ */
+class BeatClock {
+private:
+    /** The key of the audio voice that drives this clock */
+    std::string _voice;
+    /** The length of one pass through the track, used to unwrap loops */
+    SongTime _duration;
+    /** The tempo and meter of the song */
+    TempoMap _tempo;
+    /** The cursor into the tempo map for the song position */
+    TempoMap::Cursor _cursor;
+    /** The number of times the track has looped */
+    int _loops;
+    /** The last unwrapped position reported by the audio engine */
+    SongTime _rawPosition;
+    /** The smoothed, monotonic song position */
+    SongTime _position;
+    /** The time from the engine playing a sample to it being heard */
+    SongTime _latency;
+    /** How late the player's inputs are relative to the audible beat */
+    SongTime _inputOffset;
+    /** The song position measured in beats */
+    BeatPosition _beat;
+    /** The wall-clock time of the last update */
+    cugl::Timestamp _frameStamp;
+    /** Whether the voice was playing at the last update */
+    bool _playing;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates a new beat clock with the default values.
+     *
+     * This constructor does not attach the clock to a voice. You must call
+     * init before using it.
+     */
+    BeatClock();
+
+    /**
+     * Initializes this clock to follow the given voice.
+     *
+     * The sound should be the asset that was played on the voice. It is used
+     * to determine the track length so that looping music does not cause
+     * the clock to jump backwards.
+     *
+     * @param voice The key of the voice in the AudioEngine
+     * @param sound The sound playing on that voice
+     * @param tempo The tempo map of the song
+     *
+     * @return true if initialization was successful
+     */
+    bool init(const std::string& voice, const std::shared_ptr<cugl::audio::Sound>& sound, const TempoMap& tempo);
+
+    /**
+     * Resets this clock to the start of the song.
+     */
+    void reset();
+
+#pragma mark -
+#pragma mark Clock Update
+    /**
+     * Advances the clock one frame.
+     *
+     * The clock is advanced by dt and then nudged towards the position
+     * reported by the audio engine. Large differences (a seek, or a resume
+     * after suspension) are applied immediately.
+     *
+     * @param dt    The amount of time (in seconds) since the last frame
+     */
+    void update(float dt);
+
+    /**
+     * Sets the output latency of the audio device.
+     *
+     * The song position is moved immediately by the change in latency. This
+     * is the only time the position may move backwards.
+     *
+     * @param latency   The output latency of the audio device
+     */
+    void setLatency(SongTime latency);
+
+    /**
+     * Returns the output latency of the audio device.
+     *
+     * @return the output latency of the audio device
+     */
+    SongTime getLatency() const { return _latency; }
+
+    /**
+     * Sets the calibrated input offset.
+     *
+     * This is subtracted from the song time of every input, so that a player
+     * who consistently taps late (or a device that reports touches late) is
+     * judged against their own sense of the beat.
+     *
+     * @param offset    The calibrated input offset
+     */
+    void setInputOffset(SongTime offset) { _inputOffset = offset; }
+
+    /**
+     * Returns the calibrated input offset.
+     *
+     * @return the calibrated input offset
+     */
+    SongTime getInputOffset() const { return _inputOffset; }
+
+#pragma mark -
+#pragma mark Song Position
+    /**
+     * Returns the current song position.
+     *
+     * This is the audible position, after the output latency.
+     *
+     * @return the current song position
+     */
+    SongTime getPosition() const { return _position; }
+
+    /**
+     * Returns the tempo map of the song.
+     *
+     * @return the tempo map of the song
+     */
+    const TempoMap& getTempo() const { return _tempo; }
+
+    /**
+     * Returns the length of the beat currently in progress.
+     *
+     * @return the length of the beat currently in progress
+     */
+    SongTime getInterval() const { return _tempo.getInterval(getBeatIndex()); }
+
+    /**
+     * Returns the current song position measured in beats.
+     *
+     * @return the current song position measured in beats
+     */
+    BeatPosition getBeat() const { return _beat; }
+
+    /**
+     * Returns the index of the beat currently in progress.
+     *
+     * @return the index of the beat currently in progress
+     */
+    int getBeatIndex() const { return (int)getBeat().getBeat(); }
+
+    /**
+     * Returns how far we are through the current beat, in [0,1).
+     *
+     * @return how far we are through the current beat
+     */
+    double getBeatPhase() const { return getBeat().getPhase(); }
+
+    /**
+     * Returns the song time at which the given beat falls.
+     *
+     * @param beat  The beat index
+     *
+     * @return the song time at which the given beat falls
+     */
+    SongTime getBeatTime(int beat) const { return _tempo.getBeatTime(beat); }
+
+    /**
+     * Returns the song time of a wall-clock timestamp.
+     *
+     * This converts input event timestamps into the clock of the music.
+     * The timestamp may be before or after the last update. The input
+     * offset is subtracted.
+     *
+     * @param stamp The wall-clock timestamp
+     *
+     * @return the song time of a wall-clock timestamp
+     */
+    SongTime toSongTime(const cugl::Timestamp& stamp) const;
+
+    /**
+     * Returns the signed time from start to end.
+     *
+     * Timestamp::ellapsedMillis is unsigned and truncates, so it cannot be
+     * used when end might come before start.
+     *
+     * @param start The starting timestamp
+     * @param end   The ending timestamp
+     *
+     * @return the signed time from start to end
+     */
+    static SongTime ellapsed(const cugl::Timestamp& start, const cugl::Timestamp& end);
+};
+
+#endif /* __BEAT_CLOCK_H__ */
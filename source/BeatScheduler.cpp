@@ -0,0 +1,289 @@
+//
+//  BeatScheduler.cpp
+//  Demo
+//
+//  This is the implementation for the BeatScheduler class.
+//
+#include "BeatScheduler.h"
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace cugl;
+
+/** The length of one wheel tick */
+constexpr SongTime WHEEL_TICK = SongTime::fromMillis(1);
+
+/**
+ * Returns the index of the lowest set bit (value must be non-zero).
+ */
+static int lowestBit(Uint64 value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (int)index;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates an empty scheduler at the start of the song.
+ */
+BeatScheduler::BeatScheduler() :
+    _tick(0),
+    _order(0) {
+    reset();
+}
+
+/**
+ * Removes all events and moves the scheduler to the given time.
+ */
+void BeatScheduler::reset(SongTime now) {
+    _events.clear();
+    _free.clear();
+    _overflow.clear();
+    _late.clear();
+    _due.clear();
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        _occupied[level] = 0;
+        for (int slot = 0; slot < WHEEL_SLOTS; slot++) {
+            _heads[level][slot] = -1;
+        }
+    }
+    _tick = toTick(now);
+}
+
+#pragma mark -
+#pragma mark Event Pool
+/**
+ * Returns an unused event from the pool.
+ */
+int BeatScheduler::allocate() {
+    if (_free.empty()) {
+        _events.push_back(Event());
+        _events.back().generation = 0;
+        return (int)_events.size()-1;
+    }
+    int index = _free.back();
+    _free.pop_back();
+    return index;
+}
+
+/**
+ * Returns an event to the pool.
+ */
+void BeatScheduler::release(int index) {
+    Event& event = _events[index];
+    event.active = false;
+    event.callback = nullptr;
+    event.generation++;
+    _free.push_back(index);
+}
+
+#pragma mark -
+#pragma mark Timer Wheel
+/**
+ * Returns the wheel tick for a song time.
+ */
+Sint64 BeatScheduler::toTick(SongTime time) {
+    Sint64 tick = time/WHEEL_TICK;
+    return (time < SongTime() && time % WHEEL_TICK != SongTime()) ? tick-1 : tick;
+}
+
+/**
+ * Places an event in the wheel according to its time.
+ *
+ * Level L holds events less than 64^(L+1) ticks away, in the slot given by
+ * bits 6L..6L+5 of their tick. They move down a level when the wheel
+ * reaches their slot.
+ */
+void BeatScheduler::insert(int index) {
+    Event& event = _events[index];
+    Sint64 tick = toTick(event.time);
+    if (tick < _tick) {
+        _late.push_back(index);
+        return;
+    }
+
+    Sint64 delta = tick-_tick;
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        if (delta < ((Sint64)1 << (WHEEL_BITS*(level+1)))) {
+            int slot = (int)((tick >> (WHEEL_BITS*level)) & (WHEEL_SLOTS-1));
+            event.next = _heads[level][slot];
+            _heads[level][slot] = index;
+            _occupied[level] |= (Uint64)1 << slot;
+            return;
+        }
+    }
+    _overflow.push_back(index);
+}
+
+/**
+ * Moves all events in a slot of a higher level down the wheel.
+ */
+void BeatScheduler::cascade(int level) {
+    int slot = (int)((_tick >> (WHEEL_BITS*level)) & (WHEEL_SLOTS-1));
+    int index = _heads[level][slot];
+    _heads[level][slot] = -1;
+    _occupied[level] &= ~((Uint64)1 << slot);
+    while (index != -1) {
+        int next = _events[index].next;
+        insert(index);
+        index = next;
+    }
+}
+
+/**
+ * Moves the late events and every tick up to target to the due list.
+ */
+void BeatScheduler::collect(Sint64 target, SongTime now) {
+    // Events that missed their tick, or were too early within it
+    size_t kept = 0;
+    for (size_t ii = 0; ii < _late.size(); ii++) {
+        int index = _late[ii];
+        if (!_events[index].active) {
+            release(index);
+        } else if (_events[index].time <= now) {
+            _due.push_back(index);
+        } else {
+            _late[kept++] = index;
+        }
+    }
+    _late.resize(kept);
+
+    while (_tick <= target) {
+        int slot = (int)(_tick & (WHEEL_SLOTS-1));
+        int index = _heads[0][slot];
+        _heads[0][slot] = -1;
+        _occupied[0] &= ~((Uint64)1 << slot);
+        while (index != -1) {
+            int next = _events[index].next;
+            if (!_events[index].active) {
+                release(index);
+            } else if (_events[index].time <= now) {
+                _due.push_back(index);
+            } else {
+                _late.push_back(index);
+            }
+            index = next;
+        }
+
+        // Skip straight to the next occupied slot or the next rotation
+        Uint64 later = slot+1 < WHEEL_SLOTS ? _occupied[0] & (~(Uint64)0 << (slot+1)) : 0;
+        Sint64 next = later ? (_tick & ~(Sint64)(WHEEL_SLOTS-1)) + lowestBit(later) : (_tick | (WHEEL_SLOTS-1))+1;
+        _tick = std::min(next, target+1);
+
+        if ((_tick & (WHEEL_SLOTS-1)) == 0) {
+            int top = 1;
+            while (top < WHEEL_LEVELS-1 && (_tick & (((Sint64)1 << (WHEEL_BITS*(top+1)))-1)) == 0) {
+                top++;
+            }
+            if (top == WHEEL_LEVELS-1 && !_overflow.empty()) {
+                std::vector<int> overflow;
+                overflow.swap(_overflow);
+                for (int ii : overflow) {
+                    insert(ii);
+                }
+            }
+            for (int level = top; level >= 1; level--) {
+                cascade(level);
+            }
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Scheduling
+/**
+ * Schedules a callback once at the given song time.
+ */
+Uint64 BeatScheduler::scheduleAt(SongTime time, const Callback& callback) {
+    int index = allocate();
+    Event& event = _events[index];
+    event.time = time;
+    event.order = _order++;
+    event.callback = callback;
+    event.subdivision = 0;
+    event.index = 0;
+    event.active = true;
+    event.next = -1;
+    insert(index);
+    return makeId(index);
+}
+
+/**
+ * Schedules a callback on every subdivision of the beat.
+ */
+Uint64 BeatScheduler::scheduleBeats(const TempoMap& tempo, SongTime from, int subdivision, const Callback& callback) {
+    CUAssertLog(subdivision > 0, "subdivision must be positive");
+    Sint64 first = tempo.toBeat(from).getBeat()*subdivision;
+    while (tempo.toTime(BeatPosition::fromFraction(first, subdivision)) < from) {
+        first++;
+    }
+
+    int index = allocate();
+    Event& event = _events[index];
+    event.time = tempo.toTime(BeatPosition::fromFraction(first, subdivision));
+    event.order = _order++;
+    event.callback = callback;
+    event.subdivision = subdivision;
+    event.index = first;
+    event.active = true;
+    event.next = -1;
+    insert(index);
+    return makeId(index);
+}
+
+/**
+ * Cancels a scheduled event.
+ */
+void BeatScheduler::cancel(Uint64 id) {
+    size_t index = (size_t)(id & 0xFFFFFFFF);
+    Uint32 generation = (Uint32)(id >> 32);
+    if (index < _events.size() && _events[index].generation == generation) {
+        // Removed lazily when the wheel reaches it
+        _events[index].active = false;
+    }
+}
+
+#pragma mark -
+#pragma mark Advancing
+/**
+ * Fires every event scheduled at or before the given time.
+ */
+void BeatScheduler::advance(SongTime now, const TempoMap& tempo) {
+    Sint64 target = toTick(now);
+    while (true) {
+        _due.clear();
+        collect(target, now);
+        if (_due.empty()) {
+            return;
+        }
+
+        std::sort(_due.begin(), _due.end(), [this](int a, int b) {
+            const Event& ea = _events[a];
+            const Event& eb = _events[b];
+            return ea.time < eb.time || (ea.time == eb.time && ea.order < eb.order);
+        });
+
+        for (int index : _due) {
+            Event& event = _events[index];
+            if (event.active) {
+                event.callback(event.time, event.index);
+            }
+            if (event.active && event.subdivision > 0) {
+                // Repeating events that are already due again fire next pass
+                event.index++;
+                event.time = tempo.toTime(BeatPosition::fromFraction(event.index, event.subdivision));
+                event.order = _order++;
+                insert(index);
+            } else {
+                release(index);
+            }
+        }
+    }
+}
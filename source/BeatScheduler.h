@@ -0,0 +1,175 @@
+//
+//  BeatScheduler.h
+//  Demo
+//
+//  This class lets systems register callbacks for song times: a single
+//  absolute time, or every beat, half-beat, triplet, etc. Instead of every
+//  system polling the beat each frame, the scheduler is advanced once per
+//  frame and fires only the events that have expired.
+//
+//  Notes:
+//  - Events are stored in a hierarchical timer wheel with 1 ms ticks
+//  - Advancing costs O(expired events), and empty ticks are skipped
+//  - Events that expire in the same frame fire in time order, and each
+//    callback is given the exact time it was scheduled for
+//
+#ifndef __BEAT_SCHEDULER_H__
+#define __BEAT_SCHEDULER_H__
+#include <cugl/cugl.h>
+#include <functional>
+#include <deque>
+#include <vector>
+#include "SongTime.h"
+#include "TempoMap.h"
+
+/** The number of levels in the timer wheel */
+#define WHEEL_LEVELS    4
+/** The number of bits of the tick used by each level */
+#define WHEEL_BITS      6
+/** The number of slots in each level */
+#define WHEEL_SLOTS     (1 << WHEEL_BITS)
+
+/**
+ * A scheduler of song-time events backed by a hierarchical timer wheel.
+ */
+class BeatScheduler {
+public:
+    /**
+     * The function called when an event fires.
+     *
+     * The time is the song time the event was scheduled for, which may be
+     * slightly before the current frame. For repeating events the index is
+     * the number of the subdivision since the start of the song (so for a
+     * beat event, it is the beat number). For single events it is 0.
+     */
+    typedef std::function<void(SongTime time, Sint64 index)> Callback;
+
+private:
+    /**
+     * A single scheduled event.
+     */
+    struct Event {
+        /** The time this event fires */
+        SongTime time;
+        /** The order this event was scheduled in, to break ties */
+        Uint64 order;
+        /** The function to call */
+        Callback callback;
+        /** The subdivisions per beat if repeating, or 0 for a single event */
+        int subdivision;
+        /** The subdivision index of the next firing */
+        Sint64 index;
+        /** The generation of this slot in the pool, to detect stale ids */
+        Uint32 generation;
+        /** Whether this event is still scheduled */
+        bool active;
+        /** The next event in the same wheel slot, or -1 */
+        int next;
+    };
+
+    /** The pool of all events (a deque, so callbacks may schedule safely) */
+    std::deque<Event> _events;
+    /** The unused entries of the pool */
+    std::vector<int> _free;
+    /** The first event in each slot of each level, or -1 */
+    int _heads[WHEEL_LEVELS][WHEEL_SLOTS];
+    /** Which slots of each level are non-empty */
+    Uint64 _occupied[WHEEL_LEVELS];
+    /** Events too far in the future for the wheel */
+    std::vector<int> _overflow;
+    /** Events whose tick has already passed but have not fired */
+    std::vector<int> _late;
+    /** The events due this frame (kept to avoid allocation) */
+    std::vector<int> _due;
+    /** The next tick to process */
+    Sint64 _tick;
+    /** The number of events scheduled so far */
+    Uint64 _order;
+
+    /** Returns the wheel tick for a song time */
+    static Sint64 toTick(SongTime time);
+    /** Places an event in the wheel according to its time */
+    void insert(int index);
+    /** Moves all events in a slot of a higher level down the wheel */
+    void cascade(int level);
+    /** Moves the late events and every tick up to target to the due list */
+    void collect(Sint64 target, SongTime now);
+    /** Returns an unused event from the pool */
+    int allocate();
+    /** Returns an event to the pool */
+    void release(int index);
+    /** Returns the id of the given pool entry */
+    Uint64 makeId(int index) const {
+        return ((Uint64)_events[index].generation << 32) | (Uint32)index;
+    }
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates an empty scheduler at the start of the song.
+     */
+    BeatScheduler();
+
+    /**
+     * Removes all events and moves the scheduler to the given time.
+     *
+     * @param now   The current song time
+     */
+    void reset(SongTime now = SongTime());
+
+#pragma mark -
+#pragma mark Scheduling
+    /**
+     * Schedules a callback once at the given song time.
+     *
+     * If the time has already passed, the callback fires on the next advance.
+     *
+     * @param time      The song time to fire at
+     * @param callback  The function to call
+     *
+     * @return an id that can be used to cancel the event
+     */
+    Uint64 scheduleAt(SongTime time, const Callback& callback);
+
+    /**
+     * Schedules a callback on every subdivision of the beat.
+     *
+     * A subdivision of 1 fires on every beat, 2 on every half-beat, 3 on
+     * every triplet, and so on. The first firing is the first subdivision
+     * at or after the given time.
+     *
+     * @param tempo         The tempo map of the song
+     * @param from          The song time to start at
+     * @param subdivision   The number of firings per beat
+     * @param callback      The function to call
+     *
+     * @return an id that can be used to cancel the event
+     */
+    Uint64 scheduleBeats(const TempoMap& tempo, SongTime from, int subdivision, const Callback& callback);
+
+    /**
+     * Cancels a scheduled event.
+     *
+     * It is safe to cancel an event that has already fired, or to cancel an
+     * event from inside a callback.
+     *
+     * @param id    The id returned when the event was scheduled
+     */
+    void cancel(Uint64 id);
+
+#pragma mark -
+#pragma mark Advancing
+    /**
+     * Fires every event scheduled at or before the given time.
+     *
+     * This should be called once per frame with the position of the beat
+     * clock. The tempo map is used to reschedule repeating events.
+     *
+     * @param now   The current song time
+     * @param tempo The tempo map of the song
+     */
+    void advance(SongTime now, const TempoMap& tempo);
+};
+
+#endif /* __BEAT_SCHEDULER_H__ */
@@ -0,0 +1,167 @@
+//
+//  CalibrationScene.cpp
+//  Demo
+//
+//  This is the implementation for the CalibrationScene class.
+//
+#include "CalibrationScene.h"
+#include "AudioController.h"
+#include <sstream>
+#include <iomanip>
+
+using namespace cugl;
+using namespace cugl::graphics;
+using namespace cugl::audio;
+
+// Lock the screen size to fixed height regardless of aspect ratio
+#define SCENE_HEIGHT 720
+/** The voice the metronome is played on */
+#define METRONOME_VOICE "calibration"
+/** How much of each beat the text flashes for */
+#define FLASH_PHASE     0.15
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Initializes the controller contents.
+ */
+bool CalibrationScene::init(const std::shared_ptr<AssetManager>& assets) {
+    if (assets == nullptr) {
+        return false;
+    } else if (!Scene2::initWithHint(Size(0,SCENE_HEIGHT))) {
+        return false;
+    }
+
+    _assets = assets;
+    auto json = assets->get<JsonValue>("constants")->get("calibration");
+    _metronome = assets->get<Sound>(json->get("music")->asString());
+    _tempo.init(SongTime::fromBPM(json->get("bpm")->asFloat(120.0f)));
+    _taps = json->get("taps")->asInt(24);
+    _countIn = json->get("count-in")->asInt(4);
+
+    auto font = assets->get<Font>("pixel32");
+    _title = TextLayout::allocWithText("Tap along with the clicks", font);
+    _title->setHorizontalAlignment(HorizontalAlign::CENTER);
+    _title->layout();
+    _status = TextLayout::allocWithText("", font);
+    _status->setHorizontalAlignment(HorizontalAlign::CENTER);
+    _running = false;
+    updateStatus();
+    _input.init();
+    return true;
+}
+
+/**
+ * Disposes of all (non-static) resources allocated to this mode.
+ */
+void CalibrationScene::dispose() {
+    if (_active) {
+        if (_running) {
+            AudioEngine::get()->clear(METRONOME_VOICE);
+            _running = false;
+        }
+        _input.dispose();
+        _title = nullptr;
+        _status = nullptr;
+        _metronome = nullptr;
+        _assets = nullptr;
+        _active = false;
+    }
+}
+
+#pragma mark -
+#pragma mark Calibration
+/**
+ * Starts the metronome and a new calibration.
+ */
+void CalibrationScene::start() {
+    AudioEngine::get()->play(METRONOME_VOICE, _metronome, true);
+    _clock.init(METRONOME_VOICE, _metronome, _tempo);
+    _clock.setLatency(AudioController::getLatency());
+    _input.clearGestures();
+    _estimator.reset();
+    _running = true;
+    updateStatus();
+}
+
+/**
+ * Stops the metronome, saving the offset if there is an estimate.
+ */
+void CalibrationScene::stop() {
+    AudioEngine::get()->clear(METRONOME_VOICE);
+    if (_estimator.isReady()) {
+        AudioController::setCalibration(_estimator.getOffset());
+    }
+    _running = false;
+}
+
+/**
+ * Updates the status text for the current estimate.
+ */
+void CalibrationScene::updateStatus() {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    if (_estimator.isReady()) {
+        ss << "Offset " << _estimator.getOffset().toMillis() << " ms";
+        ss << " +/- " << _estimator.getSpread().toMillis() << " ms";
+    } else {
+        ss << "Listening...";
+    }
+    ss << "   (" << _estimator.getCount() << "/" << _taps << ")";
+    _status->setText(ss.str());
+    _status->layout();
+}
+
+#pragma mark -
+#pragma mark Gameplay Handling
+/**
+ * The method called to update the calibration.
+ */
+void CalibrationScene::update(float dt) {
+    if (!_running) {
+        return;
+    }
+    if (AudioController::checkDevice()) {
+        // The offset belongs to the old device, so start over
+        _clock.setLatency(AudioController::getLatency());
+        _estimator.reset();
+        updateStatus();
+    }
+    _clock.update(dt);
+    _input.readInput(_clock);
+    if (_input.didCalibrate()) {
+        stop();
+        return;
+    }
+
+    const Gesture* gesture;
+    while ((gesture = _input.peekGesture()) != nullptr) {
+        SongTime press = gesture->startTime;
+        _input.popGesture();
+        if (_tempo.toBeat(press).getNearestBeat() >= _countIn) {
+            _estimator.addSample(_tempo.getBeatError(press));
+            updateStatus();
+        }
+    }
+    if (_estimator.getCount() >= _taps) {
+        stop();
+    }
+}
+
+/**
+ * Draws the calibration status to the scene's SpriteBatch.
+ */
+void CalibrationScene::render() {
+    _batch->setPerspective(getCamera()->getCombined());
+    _batch->begin();
+
+    Size size = getSize();
+    // Flash on the beat, as heard
+    bool flash = _clock.getBeatPhase() < FLASH_PHASE && _clock.getBeatIndex() >= 0;
+    _batch->setColor(flash ? Color4::YELLOW : Color4::WHITE);
+    _batch->drawText(_title, Vec2(size.width/2, size.height*0.6f));
+    _batch->setColor(Color4::WHITE);
+    _batch->drawText(_status, Vec2(size.width/2, size.height*0.4f));
+
+    _batch->end();
+}
@@ -0,0 +1,120 @@
+//
+//  CalibrationScene.h
+//  Demo
+//
+//  This is the scene for the tap calibration. The player taps along with a
+//  metronome, and the scene estimates how late their taps are relative to
+//  the audible beat. The result is saved as the input offset of the current
+//  audio device, which shifts every judgement window.
+//
+//  Notes:
+//  - The scene has its own beat clock, following the metronome voice
+//  - The first few beats are a count-in and are not measured
+//  - Pressing the calibration button again ends the scene early; the offset
+//    is only saved if there were enough taps for an estimate
+//
+#ifndef __CALIBRATION_SCENE_H__
+#define __CALIBRATION_SCENE_H__
+#include <cugl/cugl.h>
+#include "InputController.h"
+#include "BeatClock.h"
+#include "OffsetEstimator.h"
+
+/**
+ * This class is the tap calibration mode.
+ */
+class CalibrationScene : public cugl::scene2::Scene2 {
+protected:
+    /** The asset manager for this mode */
+    std::shared_ptr<cugl::AssetManager> _assets;
+    /** The controller to read the taps */
+    InputController _input;
+    /** The song clock, driven by the metronome */
+    BeatClock _clock;
+    /** The running estimate of the input offset */
+    OffsetEstimator _estimator;
+    /** The metronome sound */
+    std::shared_ptr<cugl::audio::Sound> _metronome;
+    /** The tempo of the metronome */
+    TempoMap _tempo;
+    /** The number of taps to measure */
+    int _taps;
+    /** The number of beats before taps are measured */
+    int _countIn;
+    /** Whether the calibration is in progress */
+    bool _running;
+
+    /** The instructions */
+    std::shared_ptr<cugl::graphics::TextLayout> _title;
+    /** The current estimate */
+    std::shared_ptr<cugl::graphics::TextLayout> _status;
+
+    /** Updates the status text for the current estimate */
+    void updateStatus();
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates a new calibration mode with the default values.
+     *
+     * This constructor does not allocate any objects or start the mode.
+     */
+    CalibrationScene() : cugl::scene2::Scene2(), _taps(0), _countIn(0), _running(false) {}
+
+    /**
+     * Disposes of all (non-static) resources allocated to this mode.
+     */
+    ~CalibrationScene() { dispose(); }
+
+    /**
+     * Disposes of all (non-static) resources allocated to this mode.
+     */
+    void dispose() override;
+
+    /**
+     * Initializes the controller contents.
+     *
+     * This does not start the calibration. Call start for that.
+     *
+     * @param assets    The (loaded) assets for this mode
+     *
+     * @return true if the controller is initialized properly, false otherwise.
+     */
+    bool init(const std::shared_ptr<cugl::AssetManager>& assets);
+
+#pragma mark -
+#pragma mark Calibration
+    /**
+     * Starts the metronome and a new calibration.
+     */
+    void start();
+
+    /**
+     * Stops the metronome, saving the offset if there is an estimate.
+     */
+    void stop();
+
+    /**
+     * Returns true if the calibration is in progress.
+     *
+     * @return true if the calibration is in progress
+     */
+    bool isRunning() const { return _running; }
+
+#pragma mark -
+#pragma mark Gameplay Handling
+    /**
+     * The method called to update the calibration.
+     *
+     * @param dt    The amount of time (in seconds) since the last frame
+     */
+    void update(float dt) override;
+
+    /**
+     * Draws the calibration status to the scene's SpriteBatch.
+     */
+    void render() override;
+};
+
+#endif /* __CALIBRATION_SCENE_H__ */
@@ -0,0 +1,124 @@
+//
+//  Chart.cpp
+//  Demo
+//
+//  This is the implementation for the Chart class.
+//
+#include "Chart.h"
+#include <algorithm>
+#include <fstream>
+
+using namespace cugl;
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Initializes this chart from a binary chart file.
+ */
+bool Chart::initWithFile(const std::string& path) {
+    std::shared_ptr<BinaryReader> reader = BinaryReader::alloc(path);
+    if (reader == nullptr) {
+        return false;
+    }
+
+    ChartHeader header;
+    if (reader->read((char*)&header, sizeof(ChartHeader)) != sizeof(ChartHeader) ||
+        header.magic != CHART_MAGIC || header.version != CHART_VERSION || header.beatLength <= 0) {
+        CULog("Invalid chart file %s", path.c_str());
+        reader->close();
+        return false;
+    }
+
+    // The note records are used as-is, so these are bulk reads. They are
+    // read a block at a time, so a bad count cannot allocate past the file.
+    std::vector<ChartNote> notes;
+    while (notes.size() < header.noteCount) {
+        size_t first = notes.size();
+        size_t count = std::min((size_t)header.noteCount-first, (size_t)CHART_READ_BLOCK);
+        notes.resize(first+count);
+        size_t bytes = count*sizeof(ChartNote);
+        if (reader->read((char*)(notes.data()+first), bytes) != bytes) {
+            CULog("Truncated chart file %s", path.c_str());
+            reader->close();
+            return false;
+        }
+    }
+    reader->close();
+
+    // Notes are searched by time and index the beat inputs by beat
+    for (size_t ii = 0; ii < notes.size(); ii++) {
+        if (notes[ii].beat < 0 || (ii > 0 && notes[ii].time < notes[ii-1].time)) {
+            CULog("Invalid note %zu in chart file %s", ii, path.c_str());
+            return false;
+        }
+    }
+
+    _interval = SongTime::fromNanos(header.beatLength);
+    _notes = std::move(notes);
+    return true;
+}
+
+/**
+ * Initializes this chart with one note on every beat.
+ */
+bool Chart::initWithTempo(const TempoMap& tempo, SongTime length) {
+    _interval = tempo.getInterval(0);
+    _notes.clear();
+    extendWithTempo(tempo, length);
+    return true;
+}
+
+/**
+ * Adds one note on every beat after the last note, up to the given time.
+ */
+void Chart::extendWithTempo(const TempoMap& tempo, SongTime length) {
+    if (!_notes.empty() && _notes.back().time >= length.toNanos()) {
+        return;
+    }
+    Sint32 first = _notes.empty() ? 0 : _notes.back().beat+1;
+    Sint32 count = (Sint32)tempo.toBeat(length).getBeat();
+    for (Sint32 beat = first; beat <= count; beat++) {
+        _notes.push_back({tempo.getBeatTime(beat).toNanos(), beat, 0, 0});
+    }
+}
+
+/**
+ * Writes this chart to a binary chart file.
+ */
+bool Chart::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        CULog("Failed to create %s", path.c_str());
+        return false;
+    }
+
+    ChartHeader header = {CHART_MAGIC, CHART_VERSION, 0, (Uint32)_notes.size(), 0, _interval.toNanos()};
+    out.write((const char*)&header, sizeof(ChartHeader));
+    out.write((const char*)_notes.data(), _notes.size()*sizeof(ChartNote));
+    return out.good();
+}
+
+#pragma mark -
+#pragma mark Notes
+/**
+ * Returns the index of the note closest in time to the given time.
+ */
+int Chart::findNearest(SongTime time) const {
+    if (_notes.empty()) {
+        return -1;
+    }
+
+    // First note at or after the time
+    auto next = std::lower_bound(_notes.begin(), _notes.end(), time.toNanos(),
+                                 [](const ChartNote& note, Sint64 nanos) { return note.time < nanos; });
+    if (next == _notes.end()) {
+        return (int)_notes.size()-1;
+    } else if (next == _notes.begin()) {
+        return 0;
+    }
+
+    auto prev = next-1;
+    Sint64 after  = next->time-time.toNanos();
+    Sint64 before = time.toNanos()-prev->time;
+    return (int)((before <= after ? prev : next)-_notes.begin());
+}
@@ -0,0 +1,183 @@
+//
+//  Chart.h
+//  Demo
+//
+//  This class represents a beatmap (chart): the list of timed notes that the
+//  player is judged against. Charts are stored in a compact binary file whose
+//  layout matches the in-memory note array, so a file is loaded with a single
+//  read and then used in place.
+//
+//  File layout (little-endian):
+//  - ChartHeader (24 bytes)
+//  - noteCount ChartNote records (16 bytes each), sorted by time, with no
+//    negative beats
+//
+#ifndef __CHART_H__
+#define __CHART_H__
+#include <cugl/cugl.h>
+#include <vector>
+#include "SongTime.h"
+#include "TempoMap.h"
+
+/** The magic number at the start of every chart file ("NCCH") */
+#define CHART_MAGIC     0x4843434E
+/** The current chart file version */
+#define CHART_VERSION   1
+/** The most notes read from a chart file at once */
+#define CHART_READ_BLOCK    4096
+
+/**
+ * The header of a chart file.
+ */
+struct ChartHeader {
+    /** Must be CHART_MAGIC */
+    Uint32 magic;
+    /** The file format version */
+    Uint16 version;
+    /** Reserved for future use */
+    Uint16 flags;
+    /** The number of notes following the header */
+    Uint32 noteCount;
+    /** Reserved for future use */
+    Uint32 reserved;
+    /** The length of one beat in nanoseconds */
+    Sint64 beatLength;
+};
+
+/**
+ * A single note in a chart.
+ */
+struct ChartNote {
+    /** The song time of this note in nanoseconds */
+    Sint64 time;
+    /** The beat number of this note */
+    Sint32 beat;
+    /** The kind of note (reserved, 0 for a plain beat) */
+    Uint16 type;
+    /** Reserved for future use */
+    Uint16 flags;
+
+    /** Returns the song time of this note */
+    SongTime getTime() const { return SongTime::fromNanos(time); }
+};
+
+static_assert(sizeof(ChartHeader) == 24, "ChartHeader must match the file layout");
+static_assert(sizeof(ChartNote) == 16, "ChartNote must match the file layout");
+
+/**
+ * A beatmap of timed notes.
+ *
+ * Notes are kept sorted by time, so the note nearest to any input can be
+ * found with a binary search. The cost of judging does not depend on the
+ * length of the song.
+ */
+class Chart {
+private:
+    /** The length of the first beat */
+    SongTime _interval;
+    /** The notes, sorted by time */
+    std::vector<ChartNote> _notes;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates an empty chart.
+     *
+     * You must initialize this chart before use.
+     */
+    Chart() {}
+
+    /**
+     * Initializes this chart from a binary chart file.
+     *
+     * If this method is called a second time, it will replace all notes.
+     *
+     * @param path  The path to the chart file
+     *
+     * @return true if the file was loaded successfully
+     */
+    bool initWithFile(const std::string& path);
+
+    /**
+     * Initializes this chart with one note on every beat.
+     *
+     * This is the chart used when a song does not have a chart file.
+     *
+     * @param tempo     The tempo map of the song
+     * @param length    The length of the song
+     *
+     * @return true if initialization was successful
+     */
+    bool initWithTempo(const TempoMap& tempo, SongTime length);
+
+    /**
+     * Adds one note on every beat after the last note, up to the given time.
+     *
+     * This lets a chart made by initWithTempo grow with the song, rather
+     * than being generated for the longest session up front. It does
+     * nothing if the chart already reaches the given time.
+     *
+     * @param tempo     The tempo map of the song
+     * @param length    The time the chart must reach
+     */
+    void extendWithTempo(const TempoMap& tempo, SongTime length);
+
+    /**
+     * Writes this chart to a binary chart file.
+     *
+     * @param path  The path to the chart file
+     *
+     * @return true if the file was written successfully
+     */
+    bool save(const std::string& path) const;
+
+#pragma mark -
+#pragma mark Notes
+    /**
+     * Returns the number of notes in this chart.
+     *
+     * @return the number of notes in this chart
+     */
+    size_t size() const { return _notes.size(); }
+
+    /**
+     * Returns true if this chart has no notes.
+     *
+     * @return true if this chart has no notes
+     */
+    bool isEmpty() const { return _notes.empty(); }
+
+    /**
+     * Returns the note at the given index.
+     *
+     * @param index The note index
+     *
+     * @return the note at the given index
+     */
+    const ChartNote& get(size_t index) const { return _notes[index]; }
+
+    /**
+     * Returns the length of the first beat.
+     *
+     * The tempo of the song may change; use a TempoMap for anything after
+     * the first beat.
+     *
+     * @return the length of the first beat
+     */
+    SongTime getInterval() const { return _interval; }
+
+    /**
+     * Returns the index of the note closest in time to the given time.
+     *
+     * This is a binary search, so it is O(log n) in the number of notes.
+     * It returns -1 if the chart is empty.
+     *
+     * @param time  The song time to search for
+     *
+     * @return the index of the note closest in time to the given time
+     */
+    int findNearest(SongTime time) const;
+};
+
+#endif /* __CHART_H__ */
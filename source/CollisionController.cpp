@@ -26,46 +26,36 @@ using namespace cugl;
  * @return true if there is a ship-asteroid collision
  */
 bool CollisionController::resolveCollisions(const std::shared_ptr<Player>& player, ValuableSet& vset) {
-    bool collision = false;
     std::cout<<"enter resolveCollisions"<<std::endl;
-    for (size_t i = 0; i < vset.current.size(); ++i) {
-        std::shared_ptr<ValuableSet::Valuable> val = vset.current[i];
-        // Calculate the normal of the (possible) point of collision
-        // Calculate the grid the player is in
-        int x_player = static_cast<int>((player->getPosition().x - 30.0f) / 100.0f);
-        int y_player = static_cast<int>((player->getPosition().y) / 100.0f);
-        // Calculate the grid the valuable is in
-        int x_val = static_cast<int>((val->position.x - 30.0f) / 100.0f);
-        int y_val = static_cast<int>((val->position.y) / 100.0f);
-        // Pick up automatically when in the same grid, should add stealing process later
-        if (x_player == x_val && y_player == y_val && !player->isCarrying()) {
-            CULog("picking up");
-            val->setState(ValuableSet::Valuable::CARRIED, player->getPlayerID());
-            player->setCarrying(true, i);
-            collision = true;
-        }
-    }
-    return collision;
+    return pickUpInCell(player, vset);
 }
 
 bool CollisionController::hackyAttemptToPickUP(const std::shared_ptr<Player>& player, ValuableSet& vset) {
-    bool collision = false;
-    for (size_t i = 0; i < vset.current.size(); ++i) {
-        std::shared_ptr<ValuableSet::Valuable> val = vset.current[i];
-        // Calculate the normal of the (possible) point of collision
-        // Calculate the grid the player is in
-        int x_player = static_cast<int>((player->getPosition().x - 30.0f) / 100.0f);
-        int y_player = static_cast<int>((player->getPosition().y) / 100.0f);
-        // Calculate the grid the valuable is in
-        int x_val = static_cast<int>((val->position.x - 30.0f) / 100.0f);
-        int y_val = static_cast<int>((val->position.y) / 100.0f);
-        // Pick up automatically when in the same grid, should add stealing process later
-        if (x_player == x_val && y_player == y_val && !player->isCarrying()) {
-            CULog("picking up");
-            val->setState(ValuableSet::Valuable::CARRIED, player->getPlayerID());
-            player->setCarrying(true, i);
-            collision = true;
-        }
+    return pickUpInCell(player, vset);
+}
+
+/**
+ * Picks up the first free valuable in the player's cell.
+ *
+ * The valuables are indexed by cell, so this does not depend on how many
+ * valuables there are.
+ *
+ * @param player    The player
+ * @param vset      The valuable set
+ *
+ * @return true if a valuable was picked up
+ */
+bool CollisionController::pickUpInCell(const std::shared_ptr<Player>& player, ValuableSet& vset) {
+    // Pick up automatically when in the same grid, should add stealing process later
+    if (player->isCarrying()) {
+        return false;
+    }
+    ValuableId id = vset.findFree(player->getPosition());
+    if (id == NO_VALUABLE) {
+        return false;
     }
-    return collision;
+    CULog("picking up");
+    vset.set_val_carried(id, player->getPlayerID());
+    player->setCarrying(true, id);
+    return true;
 }
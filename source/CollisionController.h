@@ -40,6 +40,8 @@ class CollisionController {
     private:
         /** The window size (to support wrap-around collisions) */
         cugl::Size _size;
+        /** Picks up the first free valuable in the player's cell */
+        bool pickUpInCell(const std::shared_ptr<Player>& player, ValuableSet& vset);
         
     public:
         /**
@@ -10,4 +10,26 @@ enum class Direction {
     None
 };
 
+/**
+ * Returns the opposite of a direction (None stays None).
+ *
+ * @param dir   The direction
+ *
+ * @return the opposite of a direction
+ */
+inline Direction opposite(Direction dir) {
+    switch (dir) {
+        case Direction::Up:
+            return Direction::Down;
+        case Direction::Down:
+            return Direction::Up;
+        case Direction::Left:
+            return Direction::Right;
+        case Direction::Right:
+            return Direction::Left;
+        default:
+            return Direction::None;
+    }
+}
+
 #endif // !__DIRECTION_H__
@@ -0,0 +1,73 @@
+//
+//  DistanceTable.cpp
+//  Demo
+//
+//  This is the implementation for the DistanceTable class.
+//
+#include "DistanceTable.h"
+
+using namespace cugl;
+
+/** The directions tried from each cell, in tie-breaking order */
+static const Direction SEARCH_ORDER[] = {
+    Direction::Up, Direction::Down, Direction::Left, Direction::Right
+};
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Initializes the table for a map.
+ */
+bool DistanceTable::init(const TileGrid& grid) {
+    if (grid.size() == 0 || grid.size() > NAV_TABLE_CELLS) {
+        _cells = 0;
+        _distances.clear();
+        return false;
+    }
+    _cells = (int)grid.size();
+    _revision = grid.getRevision();
+    _distances.assign((size_t)_cells*_cells, TABLE_UNREACHABLE);
+
+    // One breadth-first search from every walkable cell
+    for (int source = 0; source < _cells; source++) {
+        if (!grid.isWalkable((size_t)source)) {
+            continue;
+        }
+        Uint16* row = _distances.data()+(size_t)source*_cells;
+        _queue.clear();
+        _queue.push_back(source);
+        row[source] = 0;
+        for (size_t head = 0; head < _queue.size(); head++) {
+            int cell = _queue[head];
+            for (Direction dir : SEARCH_ORDER) {
+                int next = grid.neighbor(cell, dir);
+                if (next == -1 || row[next] != TABLE_UNREACHABLE || !grid.isWalkable((size_t)next)) {
+                    continue;
+                }
+                row[next] = row[cell]+1;
+                _queue.push_back(next);
+            }
+        }
+    }
+    return true;
+}
+
+#pragma mark -
+#pragma mark Queries
+/**
+ * Returns the first step on a shortest path between two cells.
+ */
+Direction DistanceTable::getStep(const TileGrid& grid, int from, int to) const {
+    int distance = getDistance(from, to);
+    if (distance == 0 || distance == TABLE_UNREACHABLE) {
+        return Direction::None;
+    }
+    // Paths are symmetric, so any neighbor one step closer to the end will do
+    for (Direction dir : SEARCH_ORDER) {
+        int next = grid.neighbor(from, dir);
+        if (next != -1 && getDistance(to, next) == distance-1) {
+            return dir;
+        }
+    }
+    return Direction::None;
+}
@@ -0,0 +1,104 @@
+//
+//  DistanceTable.h
+//  Demo
+//
+//  This class holds the shortest walking distance between every pair of
+//  cells of a small map. It costs one search per cell up front, but after
+//  that a guard can head for any cell at all (not just the targets of the
+//  flow fields) with a few table lookups, and nothing is ever recomputed
+//  while the walls stay the same.
+//
+//  Notes:
+//  - The table is cells x cells, so it is only built for maps of at most
+//    NAV_TABLE_CELLS cells
+//  - Distances are 16 bits, which is plenty for a map that small
+//
+#ifndef __DISTANCE_TABLE_H__
+#define __DISTANCE_TABLE_H__
+#include <cugl/cugl.h>
+#include <vector>
+#include "Direction.h"
+#include "TileGrid.h"
+
+/** The largest map (in cells) that gets a distance table */
+#define NAV_TABLE_CELLS     256
+/** The distance between cells that cannot reach each other */
+#define TABLE_UNREACHABLE   0xFFFF
+
+/**
+ * The all-pairs walking distances of a small map.
+ */
+class DistanceTable {
+private:
+    /** The number of cells */
+    int _cells;
+    /** The tile revision the table was built for */
+    Uint32 _revision;
+    /** The distance from each cell (row) to each cell (column) */
+    std::vector<Uint16> _distances;
+    /** The search queue */
+    std::vector<int> _queue;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates an empty table.
+     */
+    DistanceTable() : _cells(0), _revision(0) {}
+
+    /**
+     * Initializes the table for a map.
+     *
+     * This fails (and leaves the table empty) if the map has more than
+     * NAV_TABLE_CELLS cells.
+     *
+     * @param grid  The tile map
+     *
+     * @return true if initialization was successful
+     */
+    bool init(const TileGrid& grid);
+
+    /**
+     * Returns true if the table was built for the current walls of a map.
+     *
+     * @param grid  The tile map
+     *
+     * @return true if the table is up to date
+     */
+    bool isCurrent(const TileGrid& grid) const {
+        return _cells > 0 && _cells == (int)grid.size() && _revision == grid.getRevision();
+    }
+
+#pragma mark -
+#pragma mark Queries
+    /**
+     * Returns the number of steps between two cells.
+     *
+     * @param from  The start cell
+     * @param to    The end cell
+     *
+     * @return the number of steps, or TABLE_UNREACHABLE
+     */
+    int getDistance(int from, int to) const {
+        if ((unsigned)from >= (unsigned)_cells || (unsigned)to >= (unsigned)_cells) {
+            return TABLE_UNREACHABLE;
+        }
+        return _distances[(size_t)from*_cells+to];
+    }
+
+    /**
+     * Returns the first step on a shortest path between two cells.
+     *
+     * This is None if the cells are the same, or cannot reach each other.
+     *
+     * @param grid  The tile map
+     * @param from  The start cell
+     * @param to    The end cell
+     *
+     * @return the first step on a shortest path
+     */
+    Direction getStep(const TileGrid& grid, int from, int to) const;
+};
+
+#endif /* __DISTANCE_TABLE_H__ */
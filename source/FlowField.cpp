@@ -0,0 +1,57 @@
+//
+//  FlowField.cpp
+//  Demo
+//
+//  This is the implementation for the FlowField class.
+//
+#include "FlowField.h"
+
+using namespace cugl;
+
+/** The directions searched from each cell, in tie-breaking order */
+static const Direction SEARCH_ORDER[] = {
+    Direction::Up, Direction::Down, Direction::Left, Direction::Right
+};
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Sets the target cell, rebuilding the field if it changed.
+ */
+bool FlowField::setTarget(const TileGrid& grid, int target) {
+    if (target == _target && _revision == grid.getRevision() && _steps.size() == grid.size()) {
+        return false;
+    }
+    _target = target;
+    rebuild(grid);
+    return true;
+}
+
+/**
+ * Rebuilds the field for its current target.
+ */
+void FlowField::rebuild(const TileGrid& grid) {
+    _revision = grid.getRevision();
+    _distances.assign(grid.size(), FLOW_UNREACHABLE);
+    _steps.assign(grid.size(), (Uint8)Direction::None);
+    if (_target < 0 || _target >= (int)grid.size() || !grid.isWalkable((size_t)_target)) {
+        return;
+    }
+
+    // Search out from the target; each cell steps back the way it was reached
+    _queue.clear();
+    _queue.push_back(_target);
+    _distances[_target] = 0;
+    for (size_t head = 0; head < _queue.size(); head++) {
+        int cell = _queue[head];
+        for (Direction dir : SEARCH_ORDER) {
+            int next = grid.neighbor(cell, dir);
+            if (next == -1 || _distances[next] != FLOW_UNREACHABLE || !grid.isWalkable((size_t)next)) {
+                continue;
+            }
+            _distances[next] = _distances[cell]+1;
+            _steps[next] = (Uint8)opposite(dir);
+            _queue.push_back(next);
+        }
+    }
+}
@@ -0,0 +1,105 @@
+//
+//  FlowField.h
+//  Demo
+//
+//  This class is a flow field toward one target cell of the tile grid. A
+//  breadth-first search out from the target stores, in every cell, the
+//  direction of the first step on a shortest path to the target. So any
+//  number of guards heading for the same cell steer with one array lookup
+//  each, instead of searching for a path every beat.
+//
+//  Notes:
+//  - The field is only recomputed when its target changes (or the walls do)
+//  - Ties between equally short paths are broken in a fixed direction
+//    order, so the field does not depend on anything but the map
+//  - The search queue is kept between rebuilds, so a rebuild on a map that
+//    has not grown does not allocate
+//
+#ifndef __FLOW_FIELD_H__
+#define __FLOW_FIELD_H__
+#include <cugl/cugl.h>
+#include <vector>
+#include "Direction.h"
+#include "TileGrid.h"
+
+/** The distance of a cell that cannot reach the target */
+#define FLOW_UNREACHABLE    0xFFFFFFFF
+
+/**
+ * The shortest-path directions from every cell toward one target.
+ */
+class FlowField {
+private:
+    /** The target cell, or -1 */
+    int _target;
+    /** The tile revision the field was built for */
+    Uint32 _revision;
+    /** The number of steps from each cell to the target */
+    std::vector<Uint32> _distances;
+    /** The first step from each cell toward the target (a Direction) */
+    std::vector<Uint8> _steps;
+    /** The search queue */
+    std::vector<int> _queue;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates a field with no target.
+     */
+    FlowField() : _target(-1), _revision(0) {}
+
+    /**
+     * Sets the target cell, rebuilding the field if it changed.
+     *
+     * The field is also rebuilt if the walls changed since it was built.
+     *
+     * @param grid      The tile map
+     * @param target    The target cell
+     *
+     * @return true if the field was rebuilt
+     */
+    bool setTarget(const TileGrid& grid, int target);
+
+    /**
+     * Rebuilds the field for its current target.
+     *
+     * @param grid  The tile map
+     */
+    void rebuild(const TileGrid& grid);
+
+#pragma mark -
+#pragma mark Queries
+    /**
+     * Returns the target cell, or -1 if there is none.
+     *
+     * @return the target cell
+     */
+    int getTarget() const { return _target; }
+
+    /**
+     * Returns the first step from a cell toward the target.
+     *
+     * This is None at the target, and in cells that cannot reach it.
+     *
+     * @param cell  The cell index
+     *
+     * @return the first step from a cell toward the target
+     */
+    Direction getStep(int cell) const {
+        return (unsigned)cell < _steps.size() ? (Direction)_steps[cell] : Direction::None;
+    }
+
+    /**
+     * Returns the number of steps from a cell to the target.
+     *
+     * @param cell  The cell index
+     *
+     * @return the number of steps, or FLOW_UNREACHABLE
+     */
+    Uint32 getDistance(int cell) const {
+        return (unsigned)cell < _distances.size() ? _distances[cell] : FLOW_UNREACHABLE;
+    }
+};
+
+#endif /* __FLOW_FIELD_H__ */
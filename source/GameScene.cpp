@@ -16,6 +16,7 @@
 #include <iostream>
 #include <sstream>
 #include <filesystem>
+#include <ctime>
 #include "GameScene.h"
 //#include "SLCollisionController.h"
 #include "AudioController.h"
@@ -31,78 +32,29 @@ using namespace std;
 
 // Lock the screen size to fixed height regardless of aspect ratio
 #define SCENE_HEIGHT 720
+// The most simulation steps to take in one frame before dropping time
+#define MAX_SIM_STEPS 8
 
 #pragma mark -
 #pragma mark Helper
 
+/** The binary hit log, written by a background thread */
+#define HIT_LOG_FILE    "hitlog.bin"
+/** The CSV export of the hit log */
+#define HIT_LOG_CSV     "hitlog.csv"
+/** The latency histograms */
+#define LATENCY_FILE    "latency.csv"
+/** The recording of the inputs since the last reset */
+#define REPLAY_FILE     "replay.bin"
 
-struct HitLog {
-    double timeMs;     // Absolute time since song start
-    int beatIndex;     // Nearest beat number
-    int errorMs;       // Signed timing error in milliseconds
-    int direction;     // Direction enum as int
-};
-
-std::vector<HitLog> _hitLog;
-
-double _songTimeMs = 3.429f*1000.0f;
-float  bpm = 70.0f;
-
-#include <fstream>
-#include <iomanip>
-
-void initHitLog() {
-    std::string path =
-        cugl::Application::get()->getSaveDirectory() + "hitlog.csv";
-
-    // If file already exists, do nothing
-    std::ifstream check(path);
-    if (check.good()) {
-        return;  // file already exists
-    }
-
-    std::ofstream out(path);
-    if (!out.is_open()) {
-        CULog("Failed to create %s", path.c_str());
-        return;
-    }
-
-    out << "time_ms,beat,error_ms,direction\n";
-    out.close();
-
-}
-
-void appendHitLog(Direction dir, bool logOn){
+void appendHitLog(HitLogWriter& log, SongTime songTime, const TempoMap& tempo, Direction dir, bool logOn){
     if (!logOn){
         return;
     }
-    //things for the log
-    double msPerBeat = 60000.0f / bpm;
-    double beatPos = _songTimeMs / msPerBeat;
-    int nearestBeat = (int)std::llround(beatPos);
-    double errorMsDouble = (beatPos - nearestBeat) * msPerBeat;
-    int errorMs = (int)std::round(errorMsDouble);
-    _hitLog.push_back({
-            _songTimeMs,
-            nearestBeat,
-            errorMs,
-            (int)dir
-        });
-    std::string path =
-            cugl::Application::get()->getSaveDirectory() + "hitlog.csv";
-
-    CULog("Apending at hitlog.csv at %s", path.c_str());
-    std::ofstream out(path, std::ios::app);
-
-        if (!out.is_open()) {
-            CULog("Failed to append to %s", path.c_str());
-            return;
-        }
-
-        out << (int)_songTimeMs << ","
-            << nearestBeat << ","
-            << errorMs << ","
-            << (int)dir << "\n";
+    //things for the log (the file is written off the game thread)
+    int nearestBeat = (int)tempo.toBeat(songTime).getNearestBeat();
+    SongTime error = tempo.getBeatError(songTime);
+    log.push({songTime.toNanos(), error.toNanos(), nearestBeat, (int)dir});
 }
 
 
@@ -137,9 +89,15 @@ bool GameScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
     _miniBackground = assets->get<Texture>("miniGame_background 1");
     _constants = assets->get<JsonValue>("constants");
 
+    // The tile map (a 6x9 room of floor if the level has none)
+    if (!_grid.initWithJson(_constants->get("level"))) {
+        _grid.init(6, 9, 100.0f);
+    }
+
     // Initialize valuables
-    _valuables.init(_constants->get("valuables"));
-    _valuables.setTexture(assets->get<Texture>("valuable1"));
+    ValuableSet valuables;
+    valuables.init(_constants->get("valuables"), _grid);
+    valuables.setTexture(assets->get<Texture>("valuable1"));
     
     auto pjson = _constants->get("player")->get("pos");
     cugl::Vec2 start(
@@ -149,18 +107,62 @@ bool GameScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
     _player = std::make_shared<Player>(start);
     _player->setTexture(assets->get<Texture>("player"));
     _player->setCarry(assets->get<Texture>("carry"));
+    _guardTexture = assets->get<Texture>("player");
+
+    // The guards that cannot be placed are left out of the level
+    std::vector<Guard> guards;
+    auto level = _constants->get("level");
+    if (level != nullptr && level->get("guards") != nullptr) {
+        auto json = level->get("guards");
+        for (int ii = 0; ii < (int)json->size(); ii++) {
+            Guard guard = Guard::fromJson(ii, json->get(ii), _grid);
+            if (guard.getCell() != -1) {
+                guards.push_back(guard);
+            }
+        }
+    }
     
-    _collisions.init(getSize());
-    _gameState = GameState::INPUT;
-    
+    // Load the tempo map and chart, falling back to a note on every beat
+    auto song = _constants->get("song");
+    TempoMap tempo;
+    if (!tempo.initWithJson(song->get("tempo"))) {
+        CULog("Missing or invalid tempo map, using the default tempo");
+    }
+    std::string chart = Application::get()->getAssetDirectory() + song->get("chart")->asString();
+    _sim.init(_constants, _grid, tempo, chart);
+    _sim.setStart(_player->getPlayerID(), start, guards, valuables);
+    _sim.setJudgeListener([this](const Gesture& gesture, Judgement judgement) {
+        if (_showLatency && judgement != Judgement::Miss) {
+            // The feedback is only sounded while measuring it
+            AudioEngine::get()->play("bang", _bang, false, _bang->getVolume(), true);
+            Uint64 output = AudioController::getLatency().toNanos()/1000;
+            _latency.record(LatencyStage::Sound, Timestamp::ellapsedMicros(gesture.start.timestamp, Timestamp()) + output);
+        }
+    });
+    _sim.setMoveListener([this](const Timestamp& stamp) {
+        _moveLatencyHelper(stamp);
+    });
+    _sim.setMinigameListener([this](SongTime time, Direction dir) {
+        appendHitLog(_hitLog, time, _sim.getTempo(), dir, _input.isLogOn());
+    });
+    _sim.setCountdownListener([this]() {
+        AudioEngine::get()->play("bang", _bang, false, _bang->getVolume(), true);
+    });
+
     // Play background music
-    auto bgm = assets->get<Sound>("bgm2-2");
+    auto bgm = assets->get<Sound>(song->get("music")->asString());
     AudioEngine::get()->play("bgm", bgm, true);
-    global_start_stamp.mark();
-    timestamp_by_beat = { global_start_stamp,global_start_stamp + 60000000 / bpm ,global_start_stamp ,global_start_stamp};
-    inputs_by_beat = { 4,GameScene::InputType::NO_INPUT };
-    //hard coded, change later in ms
-    _interval = 1000*60.0f/bpm ;
+    _clock.init("bgm", bgm, tempo);
+    _clock.setLatency(AudioController::getLatency());
+    // A rate of 0 steps the simulation once per frame
+    float rate = _constants->get("simulation")->get("rate")->asFloat(0.0f);
+    _simStep = rate > 0 ? SongTime::fromSeconds(1.0/rate) : SongTime();
+    _simTime = SongTime();
+    _simAlpha = 1.0f;
+    _pendingOverlay = false;
+    _showLatency = false;
+    _movePending = false;
+    _latencyText = TextLayout::allocWithText("", assets->get<Font>("pixel32"));
     _bang = assets->get<Sound>("bang");
     
     
@@ -201,8 +203,6 @@ bool GameScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
 
     /* loading in the mini game scene -- START */
 
-    _showOverlay = false;
-    _inputStep = 0;
     _overlay = _assets->get<scene2::SceneNode>("miniGame");
     if (_overlay == nullptr) {
         std::cout << "[DEBUG] _overlay is NULL - scene2s not loaded" << endl;
@@ -217,8 +217,15 @@ bool GameScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
     /* ~~~~~~~~~~~ MINI GAME SCENE END ~~~~~~ */
     
     /*addChild(_minigame);*/
-    //initHitLog();
+    _hitLog.start(Application::get()->getSaveDirectory() + HIT_LOG_FILE);
+    _input.init();
     reset();
+
+    // Replays a recorded session at startup (the name is in the save directory)
+    std::string recording = _constants->get("simulation")->getString("replay", "");
+    if (!recording.empty()) {
+        replay(Application::get()->getSaveDirectory() + recording);
+    }
     return true;
 }
 
@@ -228,6 +235,19 @@ bool GameScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
  */
 void GameScene::dispose() {
     if (_active) {
+        // Convert the log now that nothing else is writing it
+        _input.dispose();
+        _hitLog.stop();
+        std::string dir = Application::get()->getSaveDirectory();
+        if (_hitLog.getLogged() > 0) {
+            HitLogWriter::exportCSV(dir + HIT_LOG_FILE, dir + HIT_LOG_CSV);
+        }
+        if (_latency.getTotal(LatencyStage::Judge) > 0) {
+            _latency.dump(dir + LATENCY_FILE);
+        }
+        if (_recording.size() > 0) {
+            _recording.save(dir + REPLAY_FILE);
+        }
         removeAllChildren();
         _active = false;
         _assets = nullptr;
@@ -241,8 +261,14 @@ void GameScene::dispose() {
  * Resets the status of the game so that we can play again.
  */
 void GameScene::reset() {
-    _gameState = GameState::INPUT;
-    _valuables.init(_constants->get("valuables"));
+    // Every session has its own seed, kept with its recording
+    _seed = (Uint32)time(nullptr);
+    _recording.start(_seed, _simTime);
+    _sim.reset(_seed, _simTime);
+    _pendingOverlay = false;
+    _player->setPosition(_sim.getPosition());
+    _player->setCarrying(false, NO_VALUABLE);
+    _overlayHelper();
 }
 
 
@@ -255,324 +281,172 @@ void GameScene::reset() {
  * @param dt    The amount of time (in seconds) since the last frame
  */
 void GameScene::update(float dt) {
-    // Read the keyboard for each controller.
-    Timestamp current_time = Timestamp();
-    Uint64 elapsedMs = Timestamp::ellapsedMillis(global_start_stamp, current_time);
-    int updatedBeatNumber = (int) (elapsedMs / _interval) % 4;
-    bool beat_change = false;
-    if (global_beat != updatedBeatNumber) {
-        beat_change = true;
-        CULog("%d beat", global_beat);
-        global_beat = updatedBeatNumber;
-        timestamp_by_beat[global_beat].mark();
-        timestamp_by_beat[(global_beat + 1) % 4] = current_time + _interval * 1000000;
-        if (_gameState == GameState::OUTPUT || _gameState == GameState::INPUT) {
-            _gameState = global_beat >= 2 ? GameState::OUTPUT : GameState::INPUT;
-        }
-        if (global_beat == 3 and _gameState == GameState::OUTPUT) {
-            inputs_by_beat[0] = InputType::NO_INPUT;
-            inputs_by_beat[1] = InputType::NO_INPUT;
-        }
-        //CULog("recorded actions: %d %d %d %d", inputs_by_beat[0], inputs_by_beat[1], inputs_by_beat[2], inputs_by_beat[3]);
-        //CULog("global beat %d, actie time stamp %llu", global_beat, timestamp_by_beat[global_beat].getTime());
-        //CULog("%llu",  timestamp_by_beat[global_beat].getTime());
+    // Follow the music, not the wall clock (as heard through this device)
+    if (AudioController::checkDevice()) {
+        _clock.setLatency(AudioController::getLatency());
     }
-    
-    //records for the log
-    _songTimeMs += dt * 1000.0;
+    _clock.setInputOffset(AudioController::getCalibration());
+    _clock.update(dt);
     
     //for reading proper input, we need to know when it was entered
     // when it was entered relative to the beat, on what beat it was entered on 
-    _input.readInput();
-    _gestureInputProcesserHelper();
+    _input.readInput(_clock);
     if (_input.didPressReset()) {
         reset();
     }
-    //CULog("start %d", _input.queryStartEventReady());
-    //CULog("end %d", _input.queryEndEventReady());
-    if (_input.isLogOn()){
-        //initHitLog();
+    if (_input.didToggleOverlay()) {
+        _pendingOverlay = true;
+    }
+    if (_input.didToggleLatency()) {
+        _showLatency = !_showLatency;
     }
 
-    
-//    if (_step <= 0.3 * _interval || _step >= 0.7 * _interval) {
-//        // Toggle mini-game overlay with M key
-//        cugl::Keyboard* keys = cugl::Input::get<cugl::Keyboard>();
-//        if (keys->keyPressed(cugl::KeyCode::M)) {
-//            _showOverlay = !_showOverlay;
-//            _inputStep = 0;
-//            if (_overlay) _overlay->setVisible(_showOverlay);
-
-
-    bool attempt_pickup = false;
-    //CULog("press ready %d, output ready %d", _input.peekStartEvent().pressure, _input.peekEndEvent().pressure);
-    if (_gameState == GameState::OUTPUT) {
-        //CULog("recorded actions: %d %d %d %d", inputs_by_beat[0], inputs_by_beat[1], inputs_by_beat[2], inputs_by_beat[3]);
-        if (inputs_by_beat[0] == inputs_by_beat[1]) {
-            switch (inputs_by_beat[0])
-            {
-            case InputType::UP_SWIPE:
-                _player->move(Direction::Up, _gridSize, _nRow, _nCol);
-                break;
-            case InputType::DOWN_SWIPE:
-                _player->move(Direction::Down, _gridSize, _nRow, _nCol);
-                break;
-            case InputType::LEFT_SWIPE:
-                _player->move(Direction::Left, _gridSize, _nRow, _nCol);
-                break;
-            case InputType::RIGHT_SWIPE:
-                _player->move(Direction::Right, _gridSize, _nRow, _nCol);
-                break;
-            case InputType::TAP:
-                if (_player->getCarried() != -1) {
-                    _valuables.set_val_dropped(_player->getCarried());
-                    _player->setCarrying(false, -1);
-                }
-                else {
-                    attempt_pickup = true;
-                }
-                inputs_by_beat[2] = InputType::NO_INPUT;
-                inputs_by_beat[3] = InputType::NO_INPUT;
-                break;
-            default:
-                break;
-                /**
-                if (_input.didDrop() and _player->isCarrying()) {
-                    _valuables.set_val_dropped(_player->getCarried());
-                    _player->setCarrying(false, -1);
-                } */
-            }
-            inputs_by_beat[0] = InputType::NO_INPUT;
-            inputs_by_beat[1] = InputType::NO_INPUT;
-        }
-
+    SongTime now = _clock.getPosition();
+    if (_simStep <= SongTime()) {
+        // Variable step: one simulation step per frame
+        _simTime = now;
+        fixedUpdate();
+        _simAlpha = 1.0f;
+        return;
     }
 
-    if (_input.didToggleOverlay()) {
-        _showOverlay = !_showOverlay;
-        _inputStep = 0;
-        if (_overlay) _overlay->setVisible(_showOverlay);
-        _gameState = GameState::MBS;
-        attempt_pickup = true;
+    // Step the simulation in fixed increments of song time
+    int steps = 0;
+    while (_simTime + _simStep <= now && steps < MAX_SIM_STEPS) {
+        _simTime += _simStep;
+        fixedUpdate();
+        steps++;
     }
-    if (attempt_pickup || _gameState == GameState::MBS) {
-        if (_gameState != GameState::MBS && _collisions.hackyAttemptToPickUP(_player, _valuables)) {
-            _gameState = GameState::MBS;
-            _countDownMini = -1;
-        }
-        _inWindow = true;
-        if (_gameState == GameState::MBS) {
-            if (_showOverlay == false) {
-                _showOverlay = true;
-                _overlay->setVisible(true);
-            }
-            if (_showOverlay) {
-                // Must enter Up, Left, Right, Down in order to dismiss
-                /*static const Direction sequence[] = {
-                    Direction::Up, Direction::Left, Direction::Right, Direction::Down
-                };*/
-                if (directionSequence.empty()) { // Random generate directions
-                    for (int i = 0; i < 4; i++) {
-                        int r = rand() % 4;
-                        Direction dir = static_cast<Direction>(r);
-                        directionSequence.push_back(dir);
-                        auto button = _overlay->getChild(i + 2);
-                        if (button && button->getChildren().size() > 0) {
-                            auto img = button->getChild(0);
-                            if (img) {
-                                float degree = 0.0f;
-                                switch (dir) {
-                                    case Direction::Right: degree = -90; break;
-                                    case Direction::Up:    degree = 0; break;
-                                    case Direction::Left:  degree = 90; break;
-                                    case Direction::Down:  degree = 180; break;
-                                    default: break;
-                                }
-                                img->setAngle(degree * M_PI / 180.0f);
-                            }
-                        }
-                    }
-                }
-//                Direction dir = _input.getDirection();
-//                if (dir != Direction::None && _countDownMini == 0) {
-//                
-//                    //appendHitLog(dir,_input.isLogOn());
-                //CULog("eval inputs");
-                GameScene::InputType active_input = inputs_by_beat[global_beat];
-                //CULog("inputs %d, %d, %d, %d", inputs_by_beat[0], inputs_by_beat[1], inputs_by_beat[2], inputs_by_beat[3]);
-                //CULog("input %d", active_input);
-                if (active_input != InputType::NO_INPUT && (_countDownMini >= 0 && _countDownMini < 4)) {
-                    CULog("ENTERED----------------");
-                    inputs_by_beat[global_beat] = InputType::NO_INPUT;
-                    Direction dir = Direction::None;
-                    if (active_input == InputType::UP_SWIPE) {
-                        dir = Direction::Up;
-                    }
-                    else if (active_input == InputType::DOWN_SWIPE) {
-                        dir = Direction::Down;
-                    }
-                    else if (active_input == InputType::LEFT_SWIPE) {
-                        dir = Direction::Left;
-                    }
-                    else if (active_input == InputType::RIGHT_SWIPE) {
-                        dir = Direction::Right;
-                    }
-                    appendHitLog(dir, _input.isLogOn());
-                    CULog("identified with %d", active_input);
-                    _inputOnBeat = true;
-                    if (dir == directionSequence[_inputStep]) {
-                        CULog("on beat");
-                        _inputStep++;
-                        if (_inputStep == 4) {
-                            // Full sequence entered  dismiss overlay
-                            _showOverlay = false;
-                            _inputStep = 0;
-                            if (_overlay) _overlay->setVisible(false);
-                            _countDownMini = 5;
-                            directionSequence.clear();
-                            _gameState = GameState::INPUT;
-                        }
-                    }
-                    else {
-                        // Wrong input  fail the minigame
-                        CULog("in fail block");
-                        _inputStep = 0;
-                        _showOverlay = false;
-                        _valuables.set_val_dropped(_player->getCarried());
-                        _player->setCarrying(false, -1);
-                        if (_overlay) _overlay->setVisible(false);
-                        _countDownMini = 5;
-                        directionSequence.clear();
-                        _gameState = GameState::INPUT;
-                    }
-                }
-            }
-//            else {
-////                CULog("in update loop");
-//                // the update loop
-//                if (_input.getDirection() != Direction::None) {
-//                    //appendHitLog(_input.getDirection(),_input.isLogOn());
-//                    _player->move(_input.getDirection(), _gridSize, _nRow, _nCol);
-//                }
-//                std::vector<cugl::Vec2> player_pos;
-//                player_pos.push_back(_player->getPosition());
-//                _valuables.update(getSize(), player_pos);
-//
-//            }
+    if (_simTime + _simStep <= now) {
+        // Too far behind (a hitch), so drop the backlog instead of spiralling
+        _simTime = now - (now - _simTime) % _simStep;
+    }
+    // The clock can move back (a latency change), so never extrapolate
+    _simAlpha = (float)(now - _simTime).toNanos() / _simStep.toNanos();
+    _simAlpha = std::max(0.0f, std::min(_simAlpha, 1.0f));
+}
+
+/**
+ * Advances the simulation one step to the current simulation time.
+ *
+ * All gameplay logic is in the simulation. This feeds it the inputs due by
+ * this step, in the order they were decided, and records them for replays.
+ */
+void GameScene::fixedUpdate() {
+    _player->storePosition();
+    const Gesture* gesture;
+    while ((gesture = _input.peekGesture()) != nullptr && gesture->endTime <= _simTime) {
+        if (gesture->type != GestureType::HoldEnd) {
+            _latency.record(LatencyStage::Classify, gesture->start.timestamp, gesture->end.timestamp);
+            _latency.record(LatencyStage::Judge, gesture->start.timestamp, Timestamp());
         }
-        _countDownMini = 0;
+        _sim.addGesture(*gesture);
+        _recording.addGesture(*gesture);
+        _input.popGesture();
     }
-    else {
-        _inWindow = false;
-        if (_gameState == GameState::INPUT || _gameState == GameState::OUTPUT) {
-            if (!_inWindow && _wasInWindow) { // Exit an input window
-                if (!_inputOnBeat && _countDownMini == 0 && _showOverlay) {
-                    CULog("off beat");
-                    _inputStep = 0;
-                    _showOverlay = false;
-                    _valuables.set_val_dropped(_player->getCarried());
-                    _player->setCarrying(false, -1);
-                    if (_overlay) _overlay->setVisible(false);
-                    _countDownMini = 5;
-                    directionSequence.clear();
-                }
-                if (_showOverlay) { // Check again
-                    if (_countDownMini == 1) AudioEngine::get()->play("bang", _bang, false, _bang->getVolume(), true);
-                    _countDownMini = max(_countDownMini - 1, 0);
-                    CULog("%d", _countDownMini);
+    if (_pendingOverlay) {
+        _sim.toggleOverlay();
+        _recording.addOverlay(_simTime);
+        _pendingOverlay = false;
+    }
+    _sim.step(_simTime);
+
+    _player->stepTo(_sim.getPosition());
+    _player->setCarrying(_sim.getCarried() != NO_VALUABLE, _sim.getCarried());
+    _overlayHelper();
+}
+
+/**
+ * Shows the minigame overlay of the simulation.
+ *
+ * The arrows are only turned when the simulation picks a new sequence.
+ */
+void GameScene::_overlayHelper() {
+    if (_overlay == nullptr) {
+        return;
+    }
+    _overlay->setVisible(_sim.isOverlayShown());
+    const std::vector<Direction>& sequence = _sim.getSequence();
+    if (sequence == _arrows) {
+        return;
+    }
+    _arrows = sequence;
+    for (int i = 0; i < (int)_arrows.size(); i++) {
+        auto button = _overlay->getChild(i + 2);
+        if (button && button->getChildren().size() > 0) {
+            auto img = button->getChild(0);
+            if (img) {
+                float degree = 0.0f;
+                switch (_arrows[i]) {
+                    case Direction::Right: degree = -90; break;
+                    case Direction::Up:    degree = 0; break;
+                    case Direction::Left:  degree = 90; break;
+                    case Direction::Down:  degree = 180; break;
+                    default: break;
                 }
-                
+                img->setAngle(degree * M_PI / 180.0f);
             }
         }
     }
+}
 
-    std::vector<cugl::Vec2> player_pos;
-    player_pos.push_back(_player->getPosition());
-    _valuables.update(getSize(), player_pos);
-    if (_inWindow && !_wasInWindow) { // Enter a new input window
-        _inputOnBeat = false;
+/**
+ * Replays a recorded session as fast as possible.
+ */
+bool GameScene::replay(const std::string& path) {
+    if (!_replay.load(path)) {
+        return false;
     }
+    Timestamp began;
+    SongTime step = _simStep > SongTime() ? _simStep : SongTime::fromSeconds(1.0/60);
+    _sim.replay(_replay, step);
+    CULog("Replayed %zu inputs in %llu ms: score %llu, max combo %u, mean error %.1f ms",
+          _replay.size(), (unsigned long long)Timestamp::ellapsedMillis(began, Timestamp()),
+          (unsigned long long)_sim.getJudge().getScore(), _sim.getJudge().getMaxCombo(),
+          _sim.getStats().getMean().toMillis());
+
+    // Back to live play where the music is
+    _simTime = _clock.getPosition();
+    _sim.scheduleBeats(_simTime);
+    reset();
+    return true;
 }
 
-void GameScene::_gestureInputProcesserHelper() {
-    //need current beat filled to compare against
-    //hard coded epsilon errors, should pull out later
-    
-    // the following ranges exist from percentages and are compared against the milli delta b/n expected and actual input:
-    float poor = .35;     // poor * _interval = +-300 ms
-    float ok = .25;       // ok * _interval = +-214.285714286 ms
-    float good = .15;     // good * _interval = +-128.571428571  ms
-    float perfect = 10; // perfect * _interval = +-85.7142857143 ms
-    //pixel deadzone radius to prevent interpreting taps as slides
-    if (_input.queryInputReady()) {
-        //need to account for holding action
-        std::pair<TouchEvent, TouchEvent> pairing = _input.peekCompletedEvent();
-        TouchEvent first = pairing.first;
-        TouchEvent second = pairing.second;
-        Timestamp press = first.timestamp;
-        Timestamp release = second.timestamp;
-
-        //CULog("press time,   %llu", press.getTime());
-        //CULog("release time, %llu", release.getTime());
-        //CULog("delta %llu", Timestamp::ellapsedMillis(press,release));
-        float smallest_delta = 10000;
-        //press = press - global_start_stamp
-        int smallest_beat_index = -1;
-        for (int i = 0; i < 4; i++) {
-            float delta1 = Timestamp::ellapsedMillis(timestamp_by_beat[i], press);
-            float delta2 = Timestamp::ellapsedMillis(press, timestamp_by_beat[i]);
-            float delta = delta1 < delta2 ? delta1 : delta2;
-            CULog("delta: %f", delta);
-            if (delta < smallest_delta) {
-                smallest_delta = delta;
-                smallest_beat_index = i;
-            }
-        }
-        CULog("Closest delta: %f ms (beat index %d)", smallest_delta, smallest_beat_index);
-
-        string beat_feedback = "";
-        if (smallest_delta > _interval * poor) {
-            beat_feedback = "miss";
-        }
-        else if (smallest_delta > _interval * ok) {
-            beat_feedback = "poor";
-        }
-        else if (smallest_delta > _interval * good) {
-            beat_feedback = "ok";
-        }
-        else if (smallest_delta > _interval * perfect) {
-            beat_feedback = "good";
-        }
-        else {
-            beat_feedback = "perfect";
-        }
-        //CULog("temp");
-        if (inputs_by_beat[smallest_beat_index] == InputType::NO_INPUT and beat_feedback != "miss") {
-            InputType interpreted_action = _interpretActionHelper(first, second);
-            inputs_by_beat[smallest_beat_index] = interpreted_action;
-        }
-        //AudioEngine::get()->play("bang", _bang, false, _bang->getVolume(), true);
-        CULog(beat_feedback.c_str());
-        _input.clearTouchEvents();
+/**
+ * Records the latency of a move caused by an input with the given touch.
+ */
+void GameScene::_moveLatencyHelper(const Timestamp& stamp) {
+    // The move is timed from the input that completed it
+    _moveStamp = stamp;
+    _latency.record(LatencyStage::Move, _moveStamp, Timestamp());
+    _movePending = true;
+}
 
+/**
+ * Writes the hit log (and the latency histograms) to disk.
+ */
+void GameScene::flushLog() {
+    _hitLog.flush();
+    if (_recording.size() > 0) {
+        _recording.save(Application::get()->getSaveDirectory() + REPLAY_FILE);
+    }
+    if (_latency.getTotal(LatencyStage::Judge) > 0) {
+        _latency.dump(Application::get()->getSaveDirectory() + LATENCY_FILE);
     }
 }
 
-GameScene::InputType GameScene::_interpretActionHelper(TouchEvent first, TouchEvent second ) {
-    int input_deadzone = 225; //15^2
-    if (first.position.distanceSquared(second.position) <= input_deadzone) {
-        return InputType::TAP;
-    }
-    else {
-        Vec2 displacment = second.position - first.position;
-        if (abs(displacment.x) > abs(displacment.y)) {
-            return displacment.x <= 0 ? GameScene::InputType::RIGHT_SWIPE : GameScene::InputType::LEFT_SWIPE;
-        }
-        else {
-            return displacment.y <= 0 ? GameScene::InputType::UP_SWIPE : GameScene::InputType::DOWN_SWIPE;
-        }
+/**
+ * Pauses or resumes the background music (and so the game).
+ */
+void GameScene::setPaused(bool value) {
+    if (value) {
+        AudioEngine::get()->pause("bgm");
+    } else {
+        // Anything pressed while paused was not meant for the game
+        _input.clearGestures();
+        _sim.clearHolds();
+        AudioEngine::get()->resume("bgm");
     }
-    _wasInWindow = _inWindow;
 }
 
 /**
@@ -590,13 +464,33 @@ void GameScene::render() {
     
     _batch->draw(_background,Rect(Vec2::ZERO,getSize()));
     //draw things here
-    _valuables.draw(_batch, getSize());
-    _player->draw(_batch);
+    _sim.getValuables().draw(_batch, getSize());
+    _player->draw(_batch, _simAlpha);
+    for (const Guard& guard : _sim.getGuards()) {
+        guard.draw(_batch, _guardTexture, _grid, _player->getScale());
+    }
     _batch->setColor(Color4::BLACK);
     
 
     _batch->end();
 
     Scene2::render();
+
+    if (_movePending) {
+        _latency.record(LatencyStage::Render, _moveStamp, Timestamp());
+        _movePending = false;
+    }
+    if (_showLatency && _latencyText != nullptr) {
+        std::string text;
+        for (int ii = 0; ii < LATENCY_STAGES; ii++) {
+            text += _latency.getSummary((LatencyStage)ii) + "\n";
+        }
+        _latencyText->setText(text);
+        _latencyText->layout();
+        _batch->begin();
+        _batch->setColor(Color4::WHITE);
+        _batch->drawText(_latencyText, Vec2(_leftOffeset, getSize().height-_leftOffeset));
+        _batch->end();
+    }
 }
 
@@ -18,9 +18,14 @@
 #include <vector>
 #include <unordered_set>
 #include "InputController.h"
-#include "CollisionController.h"
 #include "ValuableSet.h"
 #include "Player.h"
+#include "BeatClock.h"
+#include "HitLogWriter.h"
+#include "LatencyMonitor.h"
+#include "InputRecording.h"
+#include "TileGrid.h"
+#include "GameSimulation.h"
 #include <fstream>
 
 
@@ -41,43 +46,56 @@ protected:
     std::ofstream _logOut;
     bool _logging = false;
 
-    int _nRow = 6;
-    int _nCol = 9;
+    /** The tile map of the level */
+    TileGrid _grid;
     int _rowNum;
     int _colNum;
     float _leftOffeset = 30.0f;
     float _topOffeset = 120.0f;
     float _rightOffeset = 350.0f;
-    float _gridSize = 100.0f;
-    float _interval;
-    int global_beat = 0;
-    Timestamp global_start_stamp;
-    std::vector< Timestamp> timestamp_by_beat;
     
     // CONTROLLERS are attached directly to the scene (no pointers)
     /** The controller to manage the ship */
     InputController _input;
-    /** The controller for managing collisions */
-    CollisionController _collisions;
+    /** The gameplay, stepped in song time (everything but the view) */
+    GameSimulation _sim;
+    /** The song clock, driven by the background music */
+    BeatClock _clock;
+
+    /** The length of one simulation step (zero to step once per frame) */
+    SongTime _simStep;
+    /** The song time the simulation has been advanced to */
+    SongTime _simTime;
+    /** How far the clock is between the last step and the next, for rendering */
+    float _simAlpha;
+    /** Whether the overlay toggle was pressed since the last step */
+    bool _pendingOverlay;
     
     
     // MODELS should be shared pointers or a data structure of shared pointers
     /** The JSON value with all of the constants */
     std::shared_ptr<cugl::JsonValue> _constants;
-    /** The location of all of the active valuables */
-    ValuableSet _valuables;
+    /** The hit log, written on a background thread */
+    HitLogWriter _hitLog;
+    /** The latency of each stage of the input path */
+    LatencyMonitor _latency;
+    /** Whether to show the latency overlay (and sound the input feedback) */
+    bool _showLatency;
+    /** The touch of the last move, until a frame shows it */
+    cugl::Timestamp _moveStamp;
+    /** Whether a move has not been drawn yet */
+    bool _movePending;
+    /** The text of the latency overlay */
+    std::shared_ptr<cugl::graphics::TextLayout> _latencyText;
+    /** The seed of rand() since the last reset */
+    Uint32 _seed;
+    /** The inputs consumed since the last reset */
+    InputRecording _recording;
+    /** The session being replayed */
+    InputRecording _replay;
     /** mini game scene*/
     /*std::shared_ptr<cugl::scene2::SceneNode> _minigame;*/
     
-    /** The location of all of the active asteroids */
-    enum class GameState {
-        INPUT,
-        OUTPUT,
-        MBS,
-        WON,
-        LOST
-    };
-    GameState _gameState;
     std::shared_ptr<cugl::graphics::TextLayout> _endMessage;
 
     // VIEW items are going to be individual variables
@@ -95,7 +113,10 @@ protected:
 
     std::shared_ptr<cugl::audio::Sound> _blast;
     
+    /** The player sprite, following the simulation */
     std::shared_ptr<Player> _player;
+    /** The texture of a guard */
+    std::shared_ptr<cugl::graphics::Texture> _guardTexture;
     
     std::shared_ptr<cugl::scene2::Button> _upButton;
     
@@ -109,35 +130,13 @@ protected:
     /* this method of adding in mini game layer is TEMP */
     /* The mini-game overlay node loaded from miniGame.json */
     std::shared_ptr<cugl::scene2::SceneNode> _overlay;
-    /* Whether the overlay is currently showing */
-    bool _showOverlay;
-    /* Current progress through the unlock sequence (Up, Left, Right, Down) */
-    int _inputStep;
-    /* Count down for mini game (4 beats before starting the game) */
-    int _countDownMini = 5;
-    /* Whether the player input something on the current input window for mini game */
-    bool _inputOnBeat = false;
-    /* Currently in the input window (used to track enter and exit of input window) */
-    bool _inWindow = false;
-    /* Was in the input window during last update (used to track enter and exit of input window) */
-    bool _wasInWindow = false;
-    /* Random generated sequence for mini game*/
-    std::vector<Direction> directionSequence;
-    
-
-    enum class InputType {
-        UP_SWIPE,
-        DOWN_SWIPE,
-        LEFT_SWIPE,
-        RIGHT_SWIPE,
-        TAP,
-        HOLD,
-        NO_INPUT,
-        FAILED_INPUT
-    };
-    std::vector< InputType> inputs_by_beat;
-    void _gestureInputProcesserHelper();
-    InputType _interpretActionHelper(TouchEvent, TouchEvent);
+    /* The minigame sequence the overlay arrows show */
+    std::vector<Direction> _arrows;
+
+    /* Records the latency of a move caused by an input with the given touch */
+    void _moveLatencyHelper(const cugl::Timestamp& stamp);
+    /* Shows the minigame overlay of the simulation */
+    void _overlayHelper();
     
 public:
 
@@ -190,6 +189,16 @@ public:
      */
     void update(float dt) override;
 
+    /**
+     * Advances the simulation one step to the current simulation time.
+     *
+     * This feeds the inputs due by then to the simulation, steps it, and
+     * updates the view to match. It is called by update zero or more times
+     * per frame, in fixed increments of song time, so that gameplay is the
+     * same at any frame rate.
+     */
+    void fixedUpdate();
+
     /**
      * Draws all this scene to the scene's SpriteBatch.
      *
@@ -203,6 +212,68 @@ public:
      * Resets the status of the game so that we can play again.
      */
     void reset() override;
+
+    /**
+     * Returns true if the player asked to calibrate this frame.
+     *
+     * @return true if the player asked to calibrate this frame
+     */
+    bool didRequestCalibration() const { return _input.didCalibrate(); }
+
+    /**
+     * Returns the timing statistics of every judged input since the reset.
+     *
+     * @return the timing statistics of every judged input
+     */
+    const HitStats& getStats() const { return _sim.getStats(); }
+
+    /**
+     * Returns the judge of every input, with the combo and score.
+     *
+     * @return the judge of every input
+     */
+    const JudgementEngine& getJudge() const { return _sim.getJudge(); }
+
+    /**
+     * Pauses or resumes the background music (and so the game).
+     *
+     * The song clock holds still while the music is paused.
+     *
+     * @param value Whether to pause the game
+     */
+    void setPaused(bool value);
+
+    /**
+     * Replays a recorded session as fast as possible.
+     *
+     * The simulation is reset to the start of the session with its seed,
+     * and the recorded inputs are fed to it at their song times without the
+     * devices, the music or the renderer (see GameSimulation::replay). The
+     * result is logged, and the game is then reset for live play at the
+     * current song position.
+     *
+     * @param path  The path to the recording file
+     *
+     * @return true if the recording was loaded and replayed
+     */
+    bool replay(const std::string& path);
+
+    /**
+     * Writes the inputs since the last reset to a recording file.
+     *
+     * @param path  The path to the recording file
+     *
+     * @return true if the file was written successfully
+     */
+    bool saveRecording(const std::string& path) const { return _recording.save(path); }
+
+    /**
+     * Writes the hit log (and the latency histograms and recording) to disk.
+     *
+     * This blocks until the log writer has caught up, so it should only be
+     * called when the application is suspended.
+     */
+    void flushLog();
 };
 
 #endif /*__GAME_SCENE_H__*/
@@ -0,0 +1,548 @@
+//
+//  GameSimulation.cpp
+//  Demo
+//
+//  This is the implementation for the GameSimulation class.
+//
+#include "GameSimulation.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace cugl;
+
+/** How far ahead of the simulation a generated chart is kept */
+constexpr SongTime CHART_LOOKAHEAD = SongTime::fromSeconds(60);
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates an empty simulation.
+ */
+GameSimulation::GameSimulation() :
+    _grid(nullptr),
+    _chartGenerated(false),
+    _footstepNoise(0),
+    _dropNoise(0),
+    _failNoise(0),
+    _hearing(1.0f),
+    _player(0),
+    _carried(NO_VALUABLE),
+    _guardsDue(false),
+    _pendingOverlay(false),
+    _replaying(false),
+    _gameState(GameState::INPUT),
+    global_beat(0),
+    _showOverlay(false),
+    _inputStep(0),
+    _countDownMini(5),
+    _inputOnBeat(false),
+    _inWindow(false),
+    _wasInWindow(false) {
+}
+
+/**
+ * Initializes the simulation of a level.
+ */
+bool GameSimulation::init(const std::shared_ptr<JsonValue>& constants, const TileGrid& grid,
+                          const TempoMap& tempo, const std::string& chart) {
+    _grid = &grid;
+    _tempo = tempo;
+
+    auto nav = constants->get("navigation");
+    _nav.init(grid, nav == nullptr || nav->getBool("distance tables", true));
+    auto vision = constants->get("vision");
+    _vision.init(grid, vision == nullptr ? 5 : vision->getInt("range", 5));
+    auto noise = constants->get("noise");
+    if (noise != nullptr) {
+        _noise.init(grid, noise->getFloat("decay", 0.5f), noise->getInt("wall cost", 3), noise->getInt("budget", 4096));
+        _footstepNoise = noise->getInt("footstep", 2);
+        _dropNoise = noise->getInt("drop", 5);
+        _failNoise = noise->getInt("fail", 8);
+        _hearing = noise->getFloat("hearing", 1.0f);
+    } else {
+        _noise.init(grid, 0.5f, 3, 4096);
+    }
+    auto judgement = constants->get("judgement");
+    if (judgement != nullptr) {
+        _judge.setDifficulty(JudgementEngine::difficultyFromName(judgement->getString("difficulty", "normal")));
+    }
+
+    // A missing chart falls back to a note on every beat
+    _chartGenerated = chart.empty() || !_chart.initWithFile(chart);
+    if (_chartGenerated) {
+        _chart.initWithTempo(tempo, CHART_LOOKAHEAD);
+    }
+
+    inputs_by_beat = std::vector<InputType>(std::max(4, tempo.getMaxBeatsPerMeasure()), InputType::NO_INPUT);
+    _inputStamps = std::vector<Timestamp>(inputs_by_beat.size());
+    _inputTimes = std::vector<SongTime>(inputs_by_beat.size());
+    _tickInputs = std::vector<bool>(inputs_by_beat.size(), false);
+    _time = SongTime();
+    scheduleBeats(_time);
+    return true;
+}
+
+/**
+ * Sets the state that reset returns to.
+ */
+void GameSimulation::setStart(int player, const Vec2& position, const std::vector<Guard>& guards,
+                              const ValuableSet& valuables) {
+    _player = player;
+    _start = position;
+    _startGuards = guards;
+    _startValuables = valuables;
+    _playerPositions.assign(player+1, Vec2::ZERO);
+}
+
+/**
+ * Restarts the level at the given song time.
+ */
+void GameSimulation::reset(Uint32 seed, SongTime time) {
+    _time = time;
+    _gameState = GameState::INPUT;
+    _valuables = _startValuables;
+    _stats.reset();
+    _judge.reset();
+    _holds.reset();
+
+    // Everything a replay depends on starts over
+    _position = _start;
+    _carried = NO_VALUABLE;
+    _guards = _startGuards;
+    _guardsDue = false;
+    _vision.clear();
+    _noise.clear();
+    _guardSensesHelper();
+    _gestures.clear();
+    std::fill(inputs_by_beat.begin(), inputs_by_beat.end(), InputType::NO_INPUT);
+    std::fill(_tickInputs.begin(), _tickInputs.end(), false);
+    global_beat = _tempo.getBeatInMeasure(_tempo.toBeat(time).getBeat());
+    _pendingOverlay = false;
+    _showOverlay = false;
+    _inputStep = 0;
+    _countDownMini = 5;
+    _inputOnBeat = false;
+    _inWindow = false;
+    directionSequence.clear();
+    srand(seed);
+}
+
+/**
+ * Restarts the beat callbacks at the given time.
+ */
+void GameSimulation::scheduleBeats(SongTime from) {
+    _scheduler.reset(from);
+    _scheduler.scheduleBeats(_tempo, from, 1, [this](SongTime time, Sint64 beat) {
+        _beatChangeHelper((int)beat);
+    });
+}
+
+#pragma mark -
+#pragma mark Stepping
+/**
+ * Advances the simulation one step to the given song time.
+ */
+void GameSimulation::step(SongTime time) {
+    _time = time;
+    // Fires the beat callbacks (and anything else due by this step)
+    _scheduler.advance(time, _tempo);
+    // A generated chart grows with the song, well ahead of any press
+    if (_chartGenerated) {
+        _chart.extendWithTempo(_tempo, time+CHART_LOOKAHEAD);
+    }
+    // Judge every gesture, in the order they were decided
+    for (const Gesture& gesture : _gestures) {
+        // Holds tick up to the gesture, so a release ends them at the right beat
+        _holdTickHelper(gesture.endTime);
+        if (gesture.type == GestureType::HoldEnd) {
+            _holdEndHelper(gesture);
+        } else {
+            if (gesture.type == GestureType::Hold) {
+                _holds.begin(gesture.start.touch, gesture.startTime, _tempo);
+            }
+            _gestureInputProcesserHelper(gesture);
+        }
+    }
+    _gestures.clear();
+    _holdTickHelper(time);
+
+    bool attempt_pickup = false;
+    Direction intent = Direction::None;
+    if (_gameState == GameState::OUTPUT) {
+        if (inputs_by_beat[0] == inputs_by_beat[1]) {
+            switch (inputs_by_beat[0])
+            {
+            case InputType::UP_SWIPE:
+                intent = Direction::Up;
+                break;
+            case InputType::DOWN_SWIPE:
+                intent = Direction::Down;
+                break;
+            case InputType::LEFT_SWIPE:
+                intent = Direction::Left;
+                break;
+            case InputType::RIGHT_SWIPE:
+                intent = Direction::Right;
+                break;
+            case InputType::TAP:
+                if (_carried != NO_VALUABLE) {
+                    _dropHelper(_dropNoise);
+                }
+                else {
+                    attempt_pickup = true;
+                }
+                inputs_by_beat[2] = InputType::NO_INPUT;
+                inputs_by_beat[3] = InputType::NO_INPUT;
+                break;
+            default:
+                break;
+            }
+            inputs_by_beat[0] = InputType::NO_INPUT;
+            inputs_by_beat[1] = InputType::NO_INPUT;
+        }
+
+    }
+
+    // Every move this step is decided together, so update order does not matter
+    _moves.clear();
+    size_t playerMove = _moves.add(_player, _grid->toCell(_position), intent, *_grid);
+    for (Guard& guard : _guards) {
+        // Guards take one step on each beat
+        _moves.add(guard.getEntity(), guard.getCell(), _guardsDue ? guard.steer(_nav) : Direction::None, *_grid);
+    }
+    _moves.resolve(*_grid);
+    if (intent != Direction::None) {
+        if (_moves.didMove(playerMove)) {
+            _moveHelper(intent);
+            _noise.emit(_grid->toCell(_position), _footstepNoise);
+        }
+        // The move is timed from the input that completed it
+        if (_onMove && !_replaying) {
+            _onMove(_inputStamps[1]);
+        }
+    }
+    for (size_t ii = 0; ii < _guards.size(); ii++) {
+        if (_moves.didMove(playerMove+1+ii)) {
+            _guards[ii].moveTo(_moves.get(playerMove+1+ii).to, *_grid);
+        }
+    }
+    if (_guardsDue) {
+        _noise.step();
+        _guardSensesHelper();
+    }
+    _guardsDue = false;
+
+    if (_pendingOverlay) {
+        _pendingOverlay = false;
+        _showOverlay = !_showOverlay;
+        _inputStep = 0;
+        _gameState = GameState::MBS;
+        attempt_pickup = true;
+    }
+    if (attempt_pickup || _gameState == GameState::MBS) {
+        if (_gameState != GameState::MBS && _pickUpHelper()) {
+            _gameState = GameState::MBS;
+            _countDownMini = -1;
+        }
+        _inWindow = true;
+        if (_gameState == GameState::MBS) {
+            _showOverlay = true;
+            if (directionSequence.empty()) { // Random generate directions
+                for (int i = 0; i < 4; i++) {
+                    int r = rand() % 4;
+                    directionSequence.push_back(static_cast<Direction>(r));
+                }
+            }
+            InputType active_input = inputs_by_beat[global_beat];
+            if (active_input != InputType::NO_INPUT && (_countDownMini >= 0 && _countDownMini < 4)) {
+                CULog("ENTERED----------------");
+                inputs_by_beat[global_beat] = InputType::NO_INPUT;
+                Direction dir = _inputDirectionHelper(active_input);
+                if (_onMinigame && !_replaying) {
+                    _onMinigame(_inputTimes[global_beat], dir);
+                }
+                CULog("identified with %d", active_input);
+                _inputOnBeat = true;
+                if (dir == directionSequence[_inputStep]) {
+                    CULog("on beat");
+                    _inputStep++;
+                    if (_inputStep == 4) {
+                        // Full sequence entered, so dismiss the overlay
+                        _showOverlay = false;
+                        _inputStep = 0;
+                        _countDownMini = 5;
+                        directionSequence.clear();
+                        _gameState = GameState::INPUT;
+                    }
+                }
+                else {
+                    // Wrong input, so fail the minigame
+                    CULog("in fail block");
+                    _inputStep = 0;
+                    _showOverlay = false;
+                    _dropHelper(_failNoise);
+                    _countDownMini = 5;
+                    directionSequence.clear();
+                    _gameState = GameState::INPUT;
+                }
+            }
+        }
+        _countDownMini = 0;
+    }
+    else {
+        _inWindow = false;
+        if (_gameState == GameState::INPUT || _gameState == GameState::OUTPUT) {
+            if (!_inWindow && _wasInWindow) { // Exit an input window
+                if (!_inputOnBeat && _countDownMini == 0 && _showOverlay) {
+                    CULog("off beat");
+                    _inputStep = 0;
+                    _showOverlay = false;
+                    _dropHelper(_failNoise);
+                    _countDownMini = 5;
+                    directionSequence.clear();
+                }
+                if (_showOverlay) { // Check again
+                    if (_countDownMini == 1 && _onCountdown && !_replaying) {
+                        _onCountdown();
+                    }
+                    _countDownMini = std::max(_countDownMini - 1, 0);
+                    CULog("%d", _countDownMini);
+                }
+            }
+        }
+    }
+
+    _playerPositions[_player] = _position;
+    _valuables.update(_playerPositions);
+    if (_inWindow && !_wasInWindow) { // Enter a new input window
+        _inputOnBeat = false;
+    }
+}
+
+/**
+ * Replays a recorded session as fast as possible.
+ */
+void GameSimulation::replay(const InputRecording& recording, SongTime interval) {
+    _replaying = true;
+    scheduleBeats(recording.getStart());
+    reset(recording.getSeed(), recording.getStart());
+
+    SongTime end = getReplayEnd(recording);
+    SongTime time = recording.getStart();
+    size_t cursor = 0;
+    while (time + interval <= end) {
+        time += interval;
+        // Each input goes to the step that consumed it
+        while (cursor < recording.size() && SongTime::fromNanos(recording.get(cursor).endTime) <= time) {
+            const ReplayRecord& record = recording.get(cursor++);
+            if (record.kind == REPLAY_OVERLAY) {
+                toggleOverlay();
+            } else {
+                addGesture(InputRecording::toGesture(record));
+            }
+        }
+        step(time);
+    }
+    _replaying = false;
+}
+
+/**
+ * Returns the song time a replay of the recording runs to.
+ */
+SongTime GameSimulation::getReplayEnd(const InputRecording& recording) const {
+    // A measure past the last input, so that its moves are played out
+    Sint64 last = _tempo.toBeat(recording.getEnd()).getBeat();
+    return _tempo.getBeatTime(last + _tempo.getBeatsPerMeasure(last) + 1);
+}
+
+#pragma mark -
+#pragma mark Helpers
+void GameSimulation::_beatChangeHelper(int beat) {
+    int beatsPerMeasure = _tempo.getBeatsPerMeasure(beat);
+    global_beat = _tempo.getBeatInMeasure(beat);
+    CULog("%d beat", global_beat);
+    _guardsDue = true;
+    if (_gameState == GameState::OUTPUT || _gameState == GameState::INPUT) {
+        // First half of the measure is input, second half is output
+        _gameState = global_beat >= beatsPerMeasure / 2 ? GameState::OUTPUT : GameState::INPUT;
+    }
+    if (global_beat == beatsPerMeasure - 1 and _gameState == GameState::OUTPUT) {
+        inputs_by_beat[0] = InputType::NO_INPUT;
+        inputs_by_beat[1] = InputType::NO_INPUT;
+    }
+}
+
+void GameSimulation::_holdEndHelper(const Gesture& gesture) {
+    SongTime start;
+    Sint64 ticks = 0;
+    if (!_holds.end(gesture.start.touch, start, ticks)) {
+        // The hold was dropped by a reset
+        return;
+    }
+    if (ticks == 0) {
+        // Released before a beat went by, so it was only a slow tap
+        for (size_t ii = 0; ii < inputs_by_beat.size(); ii++) {
+            if (inputs_by_beat[ii] == InputType::HOLD && !_tickInputs[ii] && _inputTimes[ii] == start) {
+                inputs_by_beat[ii] = InputType::TAP;
+            }
+        }
+        return;
+    }
+    // The release is judged against the nearest beat
+    SongTime error = _tempo.getBeatError(gesture.endTime);
+    Sint64 beat = _tempo.toBeat(gesture.endTime).getNearestBeat();
+    Judgement judgement = _judge.judge(error.abs(), _tempo.getInterval(beat));
+    _judge.record(judgement);
+    _stats.record(error, Direction::None, judgement);
+    CULog("Hold released after %lld beats: %s", (long long)ticks, judgementName(judgement));
+}
+
+void GameSimulation::_holdTickHelper(SongTime time) {
+    // A beat held through counts as a hold input, unless something else was input.
+    // This runs before the gestures released after the beat are judged, so
+    // those gestures may still take the slot over (see _tickInputs).
+    const TempoMap& tempo = _tempo;
+    _holds.update(time, tempo, [this, &tempo](TouchID, Sint64 beat) {
+        int index = tempo.getBeatInMeasure(beat);
+        if (inputs_by_beat[index] == InputType::NO_INPUT) {
+            inputs_by_beat[index] = InputType::HOLD;
+            _inputTimes[index] = tempo.getBeatTime(beat);
+            _tickInputs[index] = true;
+        }
+    });
+}
+
+void GameSimulation::_gestureInputProcesserHelper(const Gesture& gesture) {
+    // a hold is judged here by its press, and by _holdEndHelper on release
+    SongTime press = gesture.startTime;
+    SongTime error = SongTime::fromSeconds(10);
+    SongTime smallest_delta = error;
+    int smallest_beat_index = -1;
+    SongTime interval = _tempo.getInterval(_tempo.toBeat(press).getBeat());
+    int note = _chart.findNearest(press);
+    if (note >= 0) {
+        const ChartNote& target = _chart.get(note);
+        error = press - target.getTime();
+        smallest_delta = error.abs();
+        smallest_beat_index = _tempo.getBeatInMeasure(target.beat);
+        interval = _tempo.getInterval(target.beat);
+    }
+    CULog("Closest delta: %f ms (beat index %d)", smallest_delta.toMillis(), smallest_beat_index);
+
+    // the windows are per difficulty, in fractions of the beat (see JudgementEngine)
+    Judgement judgement = _judge.judge(smallest_delta, interval);
+    _judge.record(judgement);
+    InputType interpreted_action = _interpretActionHelper(gesture);
+    if (judgement != Judgement::Miss and (inputs_by_beat[smallest_beat_index] == InputType::NO_INPUT ||
+                                          _tickInputs[smallest_beat_index])) {
+        inputs_by_beat[smallest_beat_index] = interpreted_action;
+        _tickInputs[smallest_beat_index] = false;
+        _inputStamps[smallest_beat_index] = gesture.start.timestamp;
+        _inputTimes[smallest_beat_index] = press;
+    }
+    if (_onJudge && !_replaying) {
+        _onJudge(gesture, judgement);
+    }
+    _stats.record(error, _inputDirectionHelper(interpreted_action), judgement);
+    CULog("%s (combo %u, score %llu)", judgementName(judgement),
+          _judge.getCombo(), (unsigned long long)_judge.getScore());
+}
+
+Direction GameSimulation::_inputDirectionHelper(InputType input) {
+    switch (input) {
+        case InputType::UP_SWIPE:    return Direction::Up;
+        case InputType::DOWN_SWIPE:  return Direction::Down;
+        case InputType::LEFT_SWIPE:  return Direction::Left;
+        case InputType::RIGHT_SWIPE: return Direction::Right;
+        default:                     return Direction::None;
+    }
+}
+
+GameSimulation::InputType GameSimulation::_interpretActionHelper(const Gesture& gesture) {
+    // The gesture was classified as it was made
+    switch (gesture.type) {
+        case GestureType::Tap:   return InputType::TAP;
+        case GestureType::Up:    return InputType::UP_SWIPE;
+        case GestureType::Down:  return InputType::DOWN_SWIPE;
+        case GestureType::Left:  return InputType::LEFT_SWIPE;
+        case GestureType::Right: return InputType::RIGHT_SWIPE;
+        case GestureType::Hold:  return InputType::HOLD;
+        default:                 return InputType::FAILED_INPUT;
+    }
+}
+
+/**
+ * Updates what the guards see and hear, and sends them after it.
+ *
+ * This runs on beat ticks, after the guards move and the noise spreads.
+ * Only the guards that moved or turned compute a new view. Sight wins
+ * over sound, and a chasing guard ignores new noises.
+ */
+void GameSimulation::_guardSensesHelper() {
+    _vision.update(_guards);
+    int cell = _grid->toCell(_position);
+    bool seen = _vision.isSeen(cell);
+    for (size_t ii = 0; ii < _guards.size(); ii++) {
+        Guard& guard = _guards[ii];
+        if (seen && _vision.canSee(ii, cell)) {
+            guard.chase(cell);
+        } else if (!guard.isChasing() && _noise.getLevel(guard.getCell()) >= _hearing) {
+            guard.chase(_noise.getOrigin(guard.getCell()));
+        } else if (guard.isChasing() && guard.getCell() == guard.getTarget()) {
+            // Nothing more at the last place they were seen or heard
+            guard.patrol();
+        }
+    }
+}
+
+/**
+ * Drops what the player carries, with a noise of the given loudness.
+ *
+ * The noise is made even if the player carries nothing (a failed
+ * minigame is heard either way).
+ */
+void GameSimulation::_dropHelper(int loudness) {
+    _noise.emit(_grid->toCell(_position), loudness);
+    _valuables.set_val_dropped(_carried);
+    _carried = NO_VALUABLE;
+}
+
+/**
+ * Picks up the first free valuable in the player's cell.
+ *
+ * The valuables are indexed by cell, so this does not depend on how many
+ * valuables there are.
+ */
+bool GameSimulation::_pickUpHelper() {
+    if (_carried != NO_VALUABLE) {
+        return false;
+    }
+    ValuableId id = _valuables.findFree(_position);
+    if (id == NO_VALUABLE) {
+        return false;
+    }
+    CULog("picking up");
+    _valuables.set_val_carried(id, _player);
+    _carried = id;
+    return true;
+}
+
+/**
+ * Moves the player one tile in the given direction.
+ *
+ * The player does not move if the next tile is a wall or off the map.
+ */
+void GameSimulation::_moveHelper(Direction dir) {
+    Vec2 step;
+    switch (dir) {
+        case Direction::Up:    step = Vec2(0,1);  break;
+        case Direction::Down:  step = Vec2(0,-1); break;
+        case Direction::Left:  step = Vec2(-1,0); break;
+        case Direction::Right: step = Vec2(1,0);  break;
+        default: break;
+    }
+    Vec2 next = _position+step*_grid->getTileSize();
+    if (_grid->isWalkable(_grid->toRow(next), _grid->toCol(next))) {
+        _position = next;
+    }
+}
@@ -0,0 +1,421 @@
+//
+//  GameSimulation.h
+//  Demo
+//
+//  This class is the gameplay of the game scene, with nothing to draw or
+//  play. It owns the level state (the player, the guards, the valuables),
+//  judges the gestures against the chart, and advances everything one
+//  fixed step of song time at a time. GameScene steps it live and mirrors
+//  it on screen; a replay steps it as fast as it can.
+//
+//  Notes:
+//  - The gestures are fed in before the step that consumes them, in the
+//    order they were decided
+//  - The result of a step only depends on the state, the fed inputs and
+//    the song time, so a recording replays exactly (rand() is reseeded by
+//    reset)
+//  - What only matters to the player (sounds, latency, the hit log) is
+//    reported through listeners, which a replay does not call
+//
+#ifndef __GAME_SIMULATION_H__
+#define __GAME_SIMULATION_H__
+#include <cugl/cugl.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Direction.h"
+#include "SongTime.h"
+#include "TempoMap.h"
+#include "Chart.h"
+#include "BeatScheduler.h"
+#include "GestureRecognizer.h"
+#include "HitStats.h"
+#include "HoldTracker.h"
+#include "JudgementEngine.h"
+#include "InputRecording.h"
+#include "TileGrid.h"
+#include "MoveResolver.h"
+#include "NavigationController.h"
+#include "VisionController.h"
+#include "NoiseField.h"
+#include "Guard.h"
+#include "ValuableSet.h"
+
+/**
+ * The headless gameplay of a level.
+ */
+class GameSimulation {
+public:
+    /** The phase of the game */
+    enum class GameState {
+        INPUT,
+        OUTPUT,
+        MBS,
+        WON,
+        LOST
+    };
+
+    /** A function called on every judged gesture (not the release of a hold) */
+    typedef std::function<void(const Gesture& gesture, Judgement judgement)> JudgeListener;
+    /** A function called when the inputs make the player try to move */
+    typedef std::function<void(const cugl::Timestamp& stamp)> MoveListener;
+    /** A function called on every minigame input */
+    typedef std::function<void(SongTime time, Direction dir)> MinigameListener;
+    /** A function called on the last beat of the minigame countdown */
+    typedef std::function<void()> CountdownListener;
+
+private:
+    enum class InputType {
+        UP_SWIPE,
+        DOWN_SWIPE,
+        LEFT_SWIPE,
+        RIGHT_SWIPE,
+        TAP,
+        HOLD,
+        NO_INPUT,
+        FAILED_INPUT
+    };
+
+    /** The tile map of the level */
+    const TileGrid* _grid;
+    /** The tempo map of the song */
+    TempoMap _tempo;
+    /** The notes the player is judged against */
+    Chart _chart;
+    /** Whether the chart is generated from the tempo map (and so has no end) */
+    bool _chartGenerated;
+    /** The beat callbacks */
+    BeatScheduler _scheduler;
+    /** The song time of the last step */
+    SongTime _time;
+
+    /** The judge of every input, with the combo and score */
+    JudgementEngine _judge;
+    /** The timing statistics of every judged input */
+    HitStats _stats;
+    /** The holds in progress */
+    HoldTracker _holds;
+    /** The moves of this beat, resolved together */
+    MoveResolver _moves;
+    /** The guard steering, over the tile map */
+    NavigationController _nav;
+    /** The guard lines of sight, over the tile map */
+    VisionController _vision;
+    /** The noise the guards can hear, over the tile map */
+    NoiseField _noise;
+    /** How far a footstep is heard, in tiles */
+    int _footstepNoise;
+    /** How far a dropped valuable is heard, in tiles */
+    int _dropNoise;
+    /** How far a failed minigame is heard, in tiles */
+    int _failNoise;
+    /** The noise level a guard reacts to */
+    float _hearing;
+
+    /** The player position at the start of the level */
+    cugl::Vec2 _start;
+    /** The guards at the start of the level */
+    std::vector<Guard> _startGuards;
+    /** The valuables at the start of the level */
+    ValuableSet _startValuables;
+
+    /** The player id */
+    int _player;
+    /** The player position */
+    cugl::Vec2 _position;
+    /** The valuable the player carries, or NO_VALUABLE */
+    ValuableId _carried;
+    /** The player positions, indexed by player id (for carried valuables) */
+    std::vector<cugl::Vec2> _playerPositions;
+    /** The guards of the level */
+    std::vector<Guard> _guards;
+    /** The valuables of the level */
+    ValuableSet _valuables;
+    /** Whether the guards take their step on the next step */
+    bool _guardsDue;
+
+    /** The gestures fed in for the next step */
+    std::vector<Gesture> _gestures;
+    /** Whether the overlay toggle was fed in for the next step */
+    bool _pendingOverlay;
+    /** Whether the listeners are silenced (for a replay) */
+    bool _replaying;
+
+    GameState _gameState;
+    int global_beat;
+    std::vector<InputType> inputs_by_beat;
+    /** The touch of each input in inputs_by_beat, for the latency */
+    std::vector<cugl::Timestamp> _inputStamps;
+    /** The song time of each input in inputs_by_beat, for the hit log */
+    std::vector<SongTime> _inputTimes;
+    /** Whether each input in inputs_by_beat is a hold tick (which gestures override) */
+    std::vector<bool> _tickInputs;
+
+    /* Whether the minigame overlay is showing */
+    bool _showOverlay;
+    /* Current progress through the unlock sequence */
+    int _inputStep;
+    /* Count down for mini game (4 beats before starting the game) */
+    int _countDownMini;
+    /* Whether the player input something on the current input window for mini game */
+    bool _inputOnBeat;
+    /* Currently in the input window (used to track enter and exit of input window) */
+    bool _inWindow;
+    /* Was in the input window during last update (used to track enter and exit of input window) */
+    bool _wasInWindow;
+    /* Random generated sequence for mini game*/
+    std::vector<Direction> directionSequence;
+
+    /** The listener for judged gestures */
+    JudgeListener _onJudge;
+    /** The listener for player moves */
+    MoveListener _onMove;
+    /** The listener for minigame inputs */
+    MinigameListener _onMinigame;
+    /** The listener for the minigame countdown */
+    CountdownListener _onCountdown;
+
+    /* Called by the scheduler at the start of every beat */
+    void _beatChangeHelper(int beat);
+    void _gestureInputProcesserHelper(const Gesture& gesture);
+    /* Judges the release of a hold */
+    void _holdEndHelper(const Gesture& gesture);
+    /* Records a hold input on every beat held through up to the given time */
+    void _holdTickHelper(SongTime time);
+    static InputType _interpretActionHelper(const Gesture& gesture);
+    /* Returns the direction of a swipe, or None */
+    static Direction _inputDirectionHelper(InputType input);
+    /* Updates what the guards see and hear, and sends them after it */
+    void _guardSensesHelper();
+    /* Drops what the player carries, with a noise of the given loudness */
+    void _dropHelper(int loudness);
+    /* Picks up the first free valuable in the player's cell */
+    bool _pickUpHelper();
+    /* Moves the player one tile in the given direction */
+    void _moveHelper(Direction dir);
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates an empty simulation.
+     *
+     * This constructor does not allocate any objects. To use the simulation,
+     * call init and then setStart.
+     */
+    GameSimulation();
+
+    /**
+     * Initializes the simulation of a level.
+     *
+     * The constants are the game constants JSON. Missing sections (for the
+     * navigation, vision, noise and judgement) take their defaults. The
+     * tile map must outlive the simulation.
+     *
+     * @param constants The game constants
+     * @param grid      The tile map of the level
+     * @param tempo     The tempo map of the song
+     * @param chart     The chart file, or empty for a note on every beat
+     *
+     * @return true if the simulation is initialized properly
+     */
+    bool init(const std::shared_ptr<cugl::JsonValue>& constants, const TileGrid& grid,
+              const TempoMap& tempo, const std::string& chart);
+
+    /**
+     * Sets the state that reset returns to.
+     *
+     * @param player    The player id
+     * @param position  The player position
+     * @param guards    The guards of the level
+     * @param valuables The valuables of the level
+     */
+    void setStart(int player, const cugl::Vec2& position, const std::vector<Guard>& guards,
+                  const ValuableSet& valuables);
+
+    /**
+     * Restarts the level at the given song time.
+     *
+     * Everything a replay depends on starts over, and rand() is seeded with
+     * the given seed. The beat callbacks are not moved (see scheduleBeats).
+     *
+     * @param seed  The seed of rand()
+     * @param time  The current song time
+     */
+    void reset(Uint32 seed, SongTime time);
+
+    /**
+     * Restarts the beat callbacks at the given time.
+     *
+     * @param from  The song time of the first beat callback
+     */
+    void scheduleBeats(SongTime from);
+
+#pragma mark -
+#pragma mark Listeners
+    /**
+     * Sets the function called on every judged gesture.
+     *
+     * @param listener  The listener, or nullptr
+     */
+    void setJudgeListener(const JudgeListener& listener) { _onJudge = listener; }
+
+    /**
+     * Sets the function called when the inputs make the player try to move.
+     *
+     * The listener gets the touch of the input that completed the move.
+     *
+     * @param listener  The listener, or nullptr
+     */
+    void setMoveListener(const MoveListener& listener) { _onMove = listener; }
+
+    /**
+     * Sets the function called on every minigame input.
+     *
+     * @param listener  The listener, or nullptr
+     */
+    void setMinigameListener(const MinigameListener& listener) { _onMinigame = listener; }
+
+    /**
+     * Sets the function called on the last beat of the minigame countdown.
+     *
+     * @param listener  The listener, or nullptr
+     */
+    void setCountdownListener(const CountdownListener& listener) { _onCountdown = listener; }
+
+#pragma mark -
+#pragma mark Stepping
+    /**
+     * Feeds a gesture to the next step.
+     *
+     * The gesture must be due by that step (its end time is at or before
+     * the step time).
+     *
+     * @param gesture   The gesture (with its song times)
+     */
+    void addGesture(const Gesture& gesture) { _gestures.push_back(gesture); }
+
+    /**
+     * Feeds an overlay toggle to the next step.
+     */
+    void toggleOverlay() { _pendingOverlay = true; }
+
+    /**
+     * Drops the holds in progress, so that their releases are ignored.
+     */
+    void clearHolds() { _holds.reset(); }
+
+    /**
+     * Advances the simulation one step to the given song time.
+     *
+     * This contains all gameplay logic. The beat events and the fed
+     * gestures are consumed according to their song time, so the result
+     * does not depend on the step size.
+     *
+     * @param time  The song time of the step
+     */
+    void step(SongTime time);
+
+    /**
+     * Replays a recorded session as fast as possible.
+     *
+     * This restarts the level with the seed and start of the recording,
+     * feeds each input to the step it was recorded in, and runs a measure
+     * past the last input so that its moves are played out. The listeners
+     * are not called.
+     *
+     * @param recording The recorded session
+     * @param interval  The length of one step (the rate it was recorded at)
+     */
+    void replay(const InputRecording& recording, SongTime interval);
+
+    /**
+     * Returns the song time a replay of the recording runs to.
+     *
+     * @param recording The recorded session
+     *
+     * @return the song time a replay of the recording runs to
+     */
+    SongTime getReplayEnd(const InputRecording& recording) const;
+
+#pragma mark -
+#pragma mark Attributes
+    /**
+     * Returns the song time of the last step.
+     *
+     * @return the song time of the last step
+     */
+    SongTime getTime() const { return _time; }
+
+    /**
+     * Returns the tempo map of the song.
+     *
+     * @return the tempo map of the song
+     */
+    const TempoMap& getTempo() const { return _tempo; }
+
+    /**
+     * Returns the judge of every input, with the combo and score.
+     *
+     * @return the judge of every input
+     */
+    const JudgementEngine& getJudge() const { return _judge; }
+
+    /**
+     * Returns the timing statistics of every judged input.
+     *
+     * @return the timing statistics of every judged input
+     */
+    const HitStats& getStats() const { return _stats; }
+
+    /**
+     * Returns the player position.
+     *
+     * @return the player position
+     */
+    const cugl::Vec2& getPosition() const { return _position; }
+
+    /**
+     * Returns the cell of the player, or -1 if off the map.
+     *
+     * @return the cell of the player
+     */
+    int getCell() const { return _grid->toCell(_position); }
+
+    /**
+     * Returns the valuable the player carries, or NO_VALUABLE.
+     *
+     * @return the valuable the player carries
+     */
+    ValuableId getCarried() const { return _carried; }
+
+    /**
+     * Returns the guards of the level.
+     *
+     * @return the guards of the level
+     */
+    const std::vector<Guard>& getGuards() const { return _guards; }
+
+    /**
+     * Returns the valuables of the level (to draw them).
+     *
+     * @return the valuables of the level
+     */
+    ValuableSet& getValuables() { return _valuables; }
+
+    /**
+     * Returns true if the minigame overlay is showing.
+     *
+     * @return true if the minigame overlay is showing
+     */
+    bool isOverlayShown() const { return _showOverlay; }
+
+    /**
+     * Returns the directions the minigame asks for (empty if none).
+     *
+     * @return the directions the minigame asks for
+     */
+    const std::vector<Direction>& getSequence() const { return directionSequence; }
+};
+
+#endif /* __GAME_SIMULATION_H__ */
@@ -0,0 +1,109 @@
+//
+//  GestureRecognizer.cpp
+//  Demo
+//
+//  This is the implementation for the GestureRecognizer class.
+//
+#include "GestureRecognizer.h"
+#include <cmath>
+
+using namespace cugl;
+
+/** Touches that stay within this distance squared (15 px) are taps */
+#define TAP_DEADZONE    225
+/** Swipes are decided once they move this distance squared (30 px) */
+#define COMMIT_DISTANCE 900
+/** ... and the larger axis is at least this many times the smaller one */
+#define AXIS_RATIO      1.5f
+/** Swipes past the deadzone are decided at once above this speed (px/s) */
+#define COMMIT_SPEED    600.0f
+/** The weight of each new sample in the smoothed velocity */
+#define VELOCITY_WEIGHT 0.5f
+/** Touches that stay within the deadzone this long (ms) are holds */
+#define HOLD_TIME       200
+
+/**
+ * Starts recognizing a new touch.
+ */
+void GestureRecognizer::begin(const Vec2& position, const Timestamp& stamp) {
+    _origin = position;
+    _originStamp = stamp;
+    _last = position;
+    _lastStamp = stamp;
+    _velocity = Vec2::ZERO;
+    _active = true;
+    _type = GestureType::Undecided;
+}
+
+/**
+ * Adds an intermediate sample of the touch.
+ */
+GestureType GestureRecognizer::move(const Vec2& position, const Timestamp& stamp) {
+    if (!_active || _type != GestureType::Undecided) {
+        return GestureType::Undecided;
+    }
+
+    Uint64 micros = Timestamp::ellapsedMicros(_lastStamp, stamp);
+    if (micros > 0) {
+        Vec2 sample = (position-_last)*(1000000.0f/micros);
+        _velocity += (sample-_velocity)*VELOCITY_WEIGHT;
+    }
+    _last = position;
+    _lastStamp = stamp;
+
+    Vec2 offset = position-_origin;
+    float major = std::max(std::abs(offset.x), std::abs(offset.y));
+    float minor = std::min(std::abs(offset.x), std::abs(offset.y));
+    float distance = offset.lengthSquared();
+    if ((distance >= COMMIT_DISTANCE && major >= minor*AXIS_RATIO) ||
+        (distance > TAP_DEADZONE && _velocity.lengthSquared() >= COMMIT_SPEED*COMMIT_SPEED)) {
+        _type = classify(offset);
+        return _type;
+    }
+    return GestureType::Undecided;
+}
+
+/**
+ * Checks whether the touch has become a hold.
+ */
+GestureType GestureRecognizer::hold(const Timestamp& now) {
+    if (!_active || _type != GestureType::Undecided) {
+        return GestureType::Undecided;
+    }
+    if ((_last-_origin).lengthSquared() <= TAP_DEADZONE &&
+        Timestamp::ellapsedMillis(_originStamp, now) >= HOLD_TIME) {
+        _type = GestureType::Hold;
+        return _type;
+    }
+    return GestureType::Undecided;
+}
+
+/**
+ * Ends the touch.
+ */
+GestureType GestureRecognizer::end(const Vec2& position) {
+    if (!_active) {
+        return GestureType::Undecided;
+    }
+    _active = false;
+    if (_type == GestureType::Hold) {
+        // The end of a hold is judged too
+        return GestureType::HoldEnd;
+    } else if (_type != GestureType::Undecided) {
+        return GestureType::Undecided;
+    }
+
+    Vec2 offset = position-_origin;
+    _type = offset.lengthSquared() <= TAP_DEADZONE ? GestureType::Tap : classify(offset);
+    return _type;
+}
+
+/**
+ * Returns the swipe along the larger axis of a displacement.
+ */
+GestureType GestureRecognizer::classify(const Vec2& displacement) {
+    if (std::abs(displacement.x) > std::abs(displacement.y)) {
+        return displacement.x >= 0 ? GestureType::Right : GestureType::Left;
+    }
+    return displacement.y <= 0 ? GestureType::Up : GestureType::Down;
+}
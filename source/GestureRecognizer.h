@@ -0,0 +1,163 @@
+//
+//  GestureRecognizer.h
+//  Demo
+//
+//  This class classifies a single touch (or mouse drag) as it happens. It
+//  does not wait for the release: a swipe is decided as soon as it has
+//  moved far enough in one direction, or fast enough, so the game can react
+//  before the finger lifts. A touch that ends without deciding is a tap,
+//  and one that stays still for long enough is a hold.
+//
+//  Notes:
+//  - Positions are in screen coordinates (y points down)
+//  - The judged time of a gesture is still the touch-down instant; only
+//    the moment it is known changes
+//  - A recognizer is a small value type, so one can be kept per finger
+//  - A Gesture is a decided gesture with its song times, as the game
+//    consumes (and records) it
+//
+#ifndef __GESTURE_RECOGNIZER_H__
+#define __GESTURE_RECOGNIZER_H__
+#include <cugl/cugl.h>
+#include "SongTime.h"
+
+/** The touch id used for the mouse and keyboard */
+#define MOUSE_TOUCH -1
+
+/** The kinds of gesture */
+enum class GestureType {
+    Undecided,
+    Tap,
+    Up,
+    Down,
+    Left,
+    Right,
+    /** A touch held still (decided while it is still down) */
+    Hold,
+    /** The release of a hold */
+    HoldEnd
+};
+
+/**
+ * A recognized gesture.
+ *
+ * A swipe is recognized while the finger is still moving, so the end event
+ * is the sample that decided it, not necessarily the release. A hold is
+ * queued twice: once when it is decided (ending at that instant), and once
+ * as HoldEnd on the release.
+ */
+struct Gesture {
+    /** The kind of gesture */
+    GestureType type;
+    /** The press */
+    cugl::TouchEvent start;
+    /** The sample that decided the gesture */
+    cugl::TouchEvent end;
+    /** The song time of the press */
+    SongTime startTime;
+    /** The song time the gesture was decided */
+    SongTime endTime;
+    /** Whether the song times have been set */
+    bool stamped;
+};
+
+/**
+ * An incremental classifier for one touch.
+ */
+class GestureRecognizer {
+private:
+    /** The touch-down position */
+    cugl::Vec2 _origin;
+    /** The touch-down time */
+    cugl::Timestamp _originStamp;
+    /** The most recent position */
+    cugl::Vec2 _last;
+    /** The time of the most recent position */
+    cugl::Timestamp _lastStamp;
+    /** The smoothed velocity in pixels per second */
+    cugl::Vec2 _velocity;
+    /** Whether a touch is in progress */
+    bool _active;
+    /** The decision, or Undecided */
+    GestureType _type;
+
+public:
+    /**
+     * Creates an idle recognizer.
+     */
+    GestureRecognizer() : _active(false), _type(GestureType::Undecided) {}
+
+    /**
+     * Starts recognizing a new touch.
+     *
+     * @param position  The touch-down position
+     * @param stamp     The touch-down time
+     */
+    void begin(const cugl::Vec2& position, const cugl::Timestamp& stamp);
+
+    /**
+     * Adds an intermediate sample of the touch.
+     *
+     * This returns the gesture only on the sample that decides it. Every
+     * other sample returns Undecided.
+     *
+     * @param position  The touch position
+     * @param stamp     The time of the sample
+     *
+     * @return the gesture, if it was decided by this sample
+     */
+    GestureType move(const cugl::Vec2& position, const cugl::Timestamp& stamp);
+
+    /**
+     * Checks whether the touch has become a hold.
+     *
+     * A finger that is not moving sends no samples, so this must be polled.
+     * It returns Hold only on the call that decides it, when the touch has
+     * stayed within the deadzone for long enough. Every other call returns
+     * Undecided.
+     *
+     * @param now   The current time
+     *
+     * @return Hold, if it was decided by this call
+     */
+    GestureType hold(const cugl::Timestamp& now);
+
+    /**
+     * Ends the touch.
+     *
+     * If the gesture was not already decided, it is decided now: a tap if
+     * the touch stayed within the deadzone, and otherwise a swipe along the
+     * larger axis. If it was already decided as a hold, this returns
+     * HoldEnd, and if it was decided as a swipe, this returns Undecided.
+     *
+     * @param position  The touch-up position
+     *
+     * @return the gesture, if it was decided by the release
+     */
+    GestureType end(const cugl::Vec2& position);
+
+    /**
+     * Returns true if a touch is in progress.
+     *
+     * @return true if a touch is in progress
+     */
+    bool isActive() const { return _active; }
+
+    /**
+     * Returns the decision so far, or Undecided.
+     *
+     * @return the decision so far
+     */
+    GestureType getType() const { return _type; }
+
+    /**
+     * Returns the swipe along the larger axis of a displacement.
+     *
+     * @param displacement  The displacement in screen coordinates
+     *
+     * @return the swipe along the larger axis of a displacement
+     */
+    static GestureType classify(const cugl::Vec2& displacement);
+};
+
+#endif /* __GESTURE_RECOGNIZER_H__ */
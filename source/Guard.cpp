@@ -0,0 +1,115 @@
+//
+//  Guard.cpp
+//  Demo
+//
+//  This is the implementation for the Guard class.
+//
+#include "Guard.h"
+
+using namespace cugl;
+using namespace cugl::graphics;
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates a guard in a cell, with a patrol route.
+ */
+Guard::Guard(int index, int cell, const std::vector<int>& route) :
+    _index(index),
+    _cell(cell),
+    _facing(Direction::Down),
+    _route(route),
+    _waypoint(0),
+    _chase(-1) {
+}
+
+/**
+ * Returns the open cell at a [row, col] pair of level data, or -1.
+ *
+ * @param point The [row, col] pair
+ * @param grid  The tile map of the level
+ *
+ * @return the open cell at a [row, col] pair of level data, or -1
+ */
+static int readCell(const std::shared_ptr<JsonValue>& point, const TileGrid& grid) {
+    if (point == nullptr || point->size() < 2) {
+        return -1;
+    }
+    int cell = grid.toCell(point->get(0)->asInt(-1), point->get(1)->asInt(-1));
+    return cell != -1 && grid.isWalkable((size_t)cell) ? cell : -1;
+}
+
+/**
+ * Returns a guard read from level data.
+ */
+Guard Guard::fromJson(int index, const std::shared_ptr<JsonValue>& json, const TileGrid& grid) {
+    int cell = json == nullptr ? -1 : readCell(json->get("cell"), grid);
+    if (cell == -1) {
+        CULog("Guard %d does not start on an open cell", index);
+    }
+    std::vector<int> route;
+    std::shared_ptr<JsonValue> points = json == nullptr ? nullptr : json->get("route");
+    if (points != nullptr) {
+        for (int ii = 0; ii < (int)points->size(); ii++) {
+            int point = readCell(points->get(ii), grid);
+            if (point == -1) {
+                CULog("Skipping route point %d of guard %d: not an open cell", ii, index);
+            } else {
+                route.push_back(point);
+            }
+        }
+    }
+    return Guard(index, cell, route);
+}
+
+#pragma mark -
+#pragma mark Movement
+/**
+ * Returns the cell the guard is heading for.
+ */
+int Guard::getTarget() const {
+    if (_chase != -1) {
+        return _chase;
+    }
+    return _route.empty() ? _cell : _route[_waypoint];
+}
+
+/**
+ * Returns the step the guard wants to take this beat.
+ */
+Direction Guard::steer(NavigationController& nav) {
+    if (_chase == -1 && !_route.empty() && _cell == _route[_waypoint]) {
+        _waypoint = (_waypoint+1) % _route.size();
+    }
+    return nav.steer(_cell, getTarget());
+}
+
+/**
+ * Moves the guard to a neighboring cell, facing the way it moved.
+ */
+void Guard::moveTo(int cell, const TileGrid& grid) {
+    for (Direction dir : {Direction::Up, Direction::Down, Direction::Left, Direction::Right}) {
+        if (grid.neighbor(_cell, dir) == cell) {
+            _facing = dir;
+        }
+    }
+    _cell = cell;
+}
+
+#pragma mark -
+#pragma mark Rendering
+/**
+ * Draws the guard in its cell.
+ */
+void Guard::draw(const std::shared_ptr<SpriteBatch>& batch,
+                 const std::shared_ptr<Texture>& texture,
+                 const TileGrid& grid, float scale) const {
+    if (batch == nullptr || texture == nullptr || _cell == -1) {
+        return;
+    }
+    Vec2 origin(texture->getSize().width/2.0f, texture->getSize().height/2.0f);
+    Affine2 trans;
+    trans.scale(scale);
+    trans.translate(grid.toWorld(_cell/grid.getCols(), _cell%grid.getCols()));
+    batch->draw(texture, Color4::RED, origin, trans);
+}
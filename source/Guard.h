@@ -0,0 +1,161 @@
+//
+//  Guard.h
+//  Demo
+//
+//  This class represents a museum guard. A guard walks a route of waypoint
+//  cells, one tile per beat, and can be sent to chase a cell instead. It
+//  does not search for paths itself: it asks the NavigationController for
+//  the first step toward its target, which is a lookup.
+//
+//  Notes:
+//  - Guards live on the tile grid; the position is the cell, and the world
+//    position is only for drawing
+//  - Guards join the per-beat MoveResolver batch with the players, with
+//    entity ids starting at GUARD_ENTITY_BASE (so players win ties)
+//
+#ifndef __GUARD_H__
+#define __GUARD_H__
+#include <cugl/cugl.h>
+#include <vector>
+#include "Direction.h"
+#include "TileGrid.h"
+#include "NavigationController.h"
+
+/** The move resolver entity id of the first guard */
+#define GUARD_ENTITY_BASE   1024
+
+/**
+ * Class representing a guard on the tile grid.
+ */
+class Guard {
+private:
+    /** The index of this guard in the level */
+    int _index;
+    /** The cell the guard is in */
+    int _cell;
+    /** The direction the guard is facing */
+    Direction _facing;
+    /** The waypoint cells of the patrol route, in order */
+    std::vector<int> _route;
+    /** The waypoint the guard is walking to */
+    size_t _waypoint;
+    /** The cell the guard is chasing, or -1 if patrolling */
+    int _chase;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates a guard in a cell, with a patrol route.
+     *
+     * The guard loops over the route, starting with the first waypoint.
+     * An empty route leaves the guard standing still.
+     *
+     * @param index The index of this guard in the level
+     * @param cell  The starting cell
+     * @param route The waypoint cells of the patrol route
+     */
+    Guard(int index, int cell, const std::vector<int>& route);
+
+    /**
+     * Returns a guard read from level data.
+     *
+     * The JSON has a "cell" [row, col] and an optional "route" of
+     * [row, col] waypoints. A route point that is malformed, off the map
+     * or in a wall is skipped. If the cell is, the guard has cell -1 and
+     * should not be added to the level.
+     *
+     * @param index The index of this guard in the level
+     * @param json  The guard data
+     * @param grid  The tile map
+     *
+     * @return a guard read from level data
+     */
+    static Guard fromJson(int index, const std::shared_ptr<cugl::JsonValue>& json, const TileGrid& grid);
+
+#pragma mark -
+#pragma mark Attributes
+    /**
+     * Returns the move resolver entity id of this guard.
+     *
+     * @return the move resolver entity id of this guard
+     */
+    int getEntity() const { return GUARD_ENTITY_BASE+_index; }
+
+    /**
+     * Returns the cell the guard is in.
+     *
+     * @return the cell the guard is in
+     */
+    int getCell() const { return _cell; }
+
+    /**
+     * Returns the direction the guard is facing.
+     *
+     * @return the direction the guard is facing
+     */
+    Direction getFacing() const { return _facing; }
+
+    /**
+     * Returns the cell the guard is heading for.
+     *
+     * @return the cell the guard is heading for
+     */
+    int getTarget() const;
+
+    /**
+     * Sends the guard after a cell.
+     *
+     * @param cell  The cell to chase
+     */
+    void chase(int cell) { _chase = cell; }
+
+    /**
+     * Sends the guard back to its patrol route.
+     */
+    void patrol() { _chase = -1; }
+
+    /**
+     * Returns true if the guard is chasing rather than patrolling.
+     *
+     * @return true if the guard is chasing
+     */
+    bool isChasing() const { return _chase != -1; }
+
+#pragma mark -
+#pragma mark Movement
+    /**
+     * Returns the step the guard wants to take this beat.
+     *
+     * A patrolling guard at its waypoint moves on to the next one first.
+     *
+     * @param nav   The navigation controller
+     *
+     * @return the step the guard wants to take this beat
+     */
+    Direction steer(NavigationController& nav);
+
+    /**
+     * Moves the guard to a neighboring cell, facing the way it moved.
+     *
+     * The move must have been allowed by the move resolver.
+     *
+     * @param cell  The cell to move to
+     * @param grid  The tile map
+     */
+    void moveTo(int cell, const TileGrid& grid);
+
+    /**
+     * Draws the guard in its cell.
+     *
+     * @param batch     The sprite batch
+     * @param texture   The guard texture
+     * @param grid      The tile map
+     * @param scale     The drawing scale
+     */
+    void draw(const std::shared_ptr<cugl::graphics::SpriteBatch>& batch,
+              const std::shared_ptr<cugl::graphics::Texture>& texture,
+              const TileGrid& grid, float scale) const;
+};
+
+#endif /* __GUARD_H__ */
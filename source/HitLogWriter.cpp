@@ -0,0 +1,177 @@
+//
+//  HitLogWriter.cpp
+//  Demo
+//
+//  This is the implementation for the HitLogWriter class.
+//
+#include "HitLogWriter.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+
+using namespace cugl;
+
+/** How long the worker sleeps when there is nothing to write */
+#define WRITER_PERIOD   std::chrono::milliseconds(20)
+/** The number of records written in one batch */
+#define WRITER_BATCH    256
+/** The longest flush will wait for the worker */
+#define FLUSH_TIMEOUT   std::chrono::milliseconds(500)
+
+/**
+ * Returns true if the file exists and starts with a valid header.
+ */
+static bool hasValidHeader(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    HitLogHeader header;
+    if (!in.read((char*)&header, sizeof(HitLogHeader))) {
+        return false;
+    }
+    return header.magic == HIT_LOG_MAGIC && header.version == HIT_LOG_VERSION &&
+           header.recordSize == sizeof(HitRecord);
+}
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates a stopped writer.
+ */
+HitLogWriter::HitLogWriter() :
+    _running(false),
+    _flushRequested(0),
+    _flushCompleted(0),
+    _dropped(0),
+    _logged(0) {
+}
+
+/**
+ * Starts the worker thread, appending to the given file.
+ */
+bool HitLogWriter::start(const std::string& path) {
+    if (_running.load()) {
+        return false;
+    }
+    _path = path;
+    _running.store(true);
+    _worker = std::thread(&HitLogWriter::run, this);
+    return true;
+}
+
+/**
+ * Stops the worker thread, writing any remaining records.
+ */
+void HitLogWriter::stop() {
+    if (!_running.exchange(false)) {
+        return;
+    }
+    if (_worker.joinable()) {
+        _worker.join();
+    }
+    if (_dropped > 0) {
+        CULog("Hit log dropped %u records", _dropped);
+    }
+}
+
+#pragma mark -
+#pragma mark Logging
+/**
+ * Adds a record to the log.
+ */
+bool HitLogWriter::push(const HitRecord& record) {
+    if (!_ring.push(record)) {
+        _dropped++;
+        return false;
+    }
+    _logged++;
+    return true;
+}
+
+/**
+ * Writes every record logged so far to the file.
+ */
+void HitLogWriter::flush() {
+    if (!_running.load()) {
+        return;
+    }
+    Uint32 request = _flushRequested.fetch_add(1)+1;
+    auto start = std::chrono::steady_clock::now();
+    while (_flushCompleted.load() < request && std::chrono::steady_clock::now()-start < FLUSH_TIMEOUT) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+/**
+ * The body of the worker thread.
+ */
+void HitLogWriter::run() {
+    // Start a new file if this one is missing or from an old version
+    bool valid = hasValidHeader(_path);
+    std::ofstream out(_path, valid ? std::ios::binary | std::ios::app : std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        CULog("Failed to open %s", _path.c_str());
+    } else if (!valid) {
+        HitLogHeader header = {HIT_LOG_MAGIC, HIT_LOG_VERSION, sizeof(HitRecord), 0};
+        out.write((const char*)&header, sizeof(HitLogHeader));
+    }
+
+    HitRecord batch[WRITER_BATCH];
+    bool running = true;
+    while (running) {
+        // Read the flags before draining, so nothing pushed before them is missed
+        running = _running.load();
+        Uint32 request = _flushRequested.load();
+
+        size_t count = 0;
+        while (count < WRITER_BATCH && _ring.pop(batch[count])) {
+            count++;
+        }
+        if (count > 0 && out.is_open()) {
+            out.write((const char*)batch, count*sizeof(HitRecord));
+        }
+        if (count == WRITER_BATCH) {
+            // There may be more waiting
+            running = true;
+            continue;
+        }
+
+        if (request != _flushCompleted.load()) {
+            if (out.is_open()) {
+                out.flush();
+            }
+            _flushCompleted.store(request);
+        }
+        if (running) {
+            std::this_thread::sleep_for(WRITER_PERIOD);
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Export
+/**
+ * Converts a binary hit log to a CSV file.
+ */
+bool HitLogWriter::exportCSV(const std::string& path, const std::string& csv) {
+    if (!hasValidHeader(path)) {
+        CULog("Invalid hit log %s", path.c_str());
+        return false;
+    }
+    std::ifstream in(path, std::ios::binary);
+    in.seekg(sizeof(HitLogHeader));
+    std::ofstream out(csv);
+    if (!out.is_open()) {
+        CULog("Failed to create %s", csv.c_str());
+        return false;
+    }
+
+    out << "time_ms,beat,error_ms,direction\n";
+    out << std::fixed << std::setprecision(3);
+    HitRecord record;
+    while (in.read((char*)&record, sizeof(HitRecord))) {
+        out << SongTime::fromNanos(record.time).toMillis() << ","
+            << record.beat << ","
+            << SongTime::fromNanos(record.error).toMillis() << ","
+            << record.direction << "\n";
+    }
+    return out.good();
+}
@@ -0,0 +1,175 @@
+//
+//  HitLogWriter.h
+//  Demo
+//
+//  This class writes the hit log on a background thread. The game thread
+//  only copies a fixed-size record into a lock-free ring, so logging never
+//  touches the filesystem during a frame. A worker thread wakes up
+//  periodically and writes everything in the ring in one batch.
+//
+//  File layout (little-endian):
+//  - HitLogHeader (16 bytes), only at the start of a new file
+//  - HitRecord records (24 bytes each), in the order they were logged
+//
+//  Notes:
+//  - Records are dropped (and counted) if the ring is ever full
+//  - The binary log can be converted to the old CSV format with exportCSV
+//
+#ifndef __HIT_LOG_WRITER_H__
+#define __HIT_LOG_WRITER_H__
+#include <cugl/cugl.h>
+#include <atomic>
+#include <thread>
+#include "SongTime.h"
+#include "SpscRing.h"
+
+/** The magic number at the start of every hit log ("NCHL") */
+#define HIT_LOG_MAGIC   0x4C48434E
+/** The current hit log version */
+#define HIT_LOG_VERSION 1
+/** The number of records the ring can hold */
+#define HIT_LOG_CAPACITY    4096
+
+/**
+ * The header of a hit log file.
+ */
+struct HitLogHeader {
+    /** Must be HIT_LOG_MAGIC */
+    Uint32 magic;
+    /** The file format version */
+    Uint16 version;
+    /** The size of each record */
+    Uint16 recordSize;
+    /** Reserved for future use */
+    Uint64 reserved;
+};
+
+/**
+ * A single logged hit.
+ */
+struct HitRecord {
+    /** The song time of the hit in nanoseconds */
+    Sint64 time;
+    /** The signed timing error in nanoseconds */
+    Sint64 error;
+    /** The nearest beat number */
+    Sint32 beat;
+    /** The direction (as an int) */
+    Sint32 direction;
+};
+
+static_assert(sizeof(HitLogHeader) == 16, "HitLogHeader must match the file layout");
+static_assert(sizeof(HitRecord) == 24, "HitRecord must match the file layout");
+
+/**
+ * A hit log that is written on a background thread.
+ */
+class HitLogWriter {
+private:
+    /** The records waiting to be written */
+    SpscRing<HitRecord, HIT_LOG_CAPACITY> _ring;
+    /** The worker thread */
+    std::thread _worker;
+    /** The path of the log file */
+    std::string _path;
+    /** Whether the worker should keep running */
+    std::atomic<bool> _running;
+    /** The number of flushes requested */
+    std::atomic<Uint32> _flushRequested;
+    /** The number of flushes completed */
+    std::atomic<Uint32> _flushCompleted;
+    /** The number of records dropped because the ring was full */
+    Uint32 _dropped;
+    /** The number of records logged */
+    Uint32 _logged;
+
+    /** The body of the worker thread */
+    void run();
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates a stopped writer.
+     */
+    HitLogWriter();
+
+    /**
+     * Stops the writer, writing any remaining records.
+     */
+    ~HitLogWriter() { stop(); }
+
+    /**
+     * Starts the worker thread, appending to the given file.
+     *
+     * @param path  The path of the binary log file
+     *
+     * @return true if the worker was started
+     */
+    bool start(const std::string& path);
+
+    /**
+     * Stops the worker thread, writing any remaining records.
+     *
+     * This blocks until the worker has finished.
+     */
+    void stop();
+
+    /**
+     * Returns true if the worker thread is running.
+     *
+     * @return true if the worker thread is running
+     */
+    bool isRunning() const { return _running.load(); }
+
+#pragma mark -
+#pragma mark Logging
+    /**
+     * Adds a record to the log.
+     *
+     * This never blocks or makes a system call. If the ring is full, the
+     * record is dropped.
+     *
+     * @param record    The record to add
+     *
+     * @return false if the record was dropped
+     */
+    bool push(const HitRecord& record);
+
+    /**
+     * Writes every record logged so far to the file.
+     *
+     * This blocks (for a bounded time) until the worker has written them,
+     * so it should only be called on suspension and not during a frame.
+     */
+    void flush();
+
+    /**
+     * Returns the number of records logged.
+     *
+     * @return the number of records logged
+     */
+    Uint32 getLogged() const { return _logged; }
+
+    /**
+     * Returns the number of records dropped because the ring was full.
+     *
+     * @return the number of records dropped
+     */
+    Uint32 getDropped() const { return _dropped; }
+
+    /**
+     * Converts a binary hit log to a CSV file.
+     *
+     * The CSV has the columns time_ms,beat,error_ms,direction. This is meant
+     * to be run offline, or after the writer has stopped.
+     *
+     * @param path  The path of the binary log file
+     * @param csv   The path of the CSV file to create
+     *
+     * @return true if the file was converted
+     */
+    static bool exportCSV(const std::string& path, const std::string& csv);
+};
+
+#endif /* __HIT_LOG_WRITER_H__ */
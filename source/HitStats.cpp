@@ -0,0 +1,176 @@
+//
+//  HitStats.cpp
+//  Demo
+//
+//  This is the implementation for the HitStats and P2Quantile classes.
+//
+#include "HitStats.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace cugl;
+
+#pragma mark -
+#pragma mark P2Quantile
+/**
+ * Removes all samples and sets the quantile to estimate.
+ */
+void P2Quantile::reset(double p) {
+    _p = p;
+    _count = 0;
+    for (int ii = 0; ii < 5; ii++) {
+        _heights[ii] = 0;
+        _positions[ii] = ii;
+    }
+    _desired[0] = 0;
+    _desired[1] = 2*p;
+    _desired[2] = 4*p;
+    _desired[3] = 2+2*p;
+    _desired[4] = 4;
+    _increments[0] = 0;
+    _increments[1] = p/2;
+    _increments[2] = p;
+    _increments[3] = (1+p)/2;
+    _increments[4] = 1;
+}
+
+/**
+ * Returns the parabolic prediction for marker i moved by d.
+ */
+double P2Quantile::parabolic(int i, double d) const {
+    const double* q = _heights;
+    const double* n = _positions;
+    return q[i] + d/(n[i+1]-n[i-1])*((n[i]-n[i-1]+d)*(q[i+1]-q[i])/(n[i+1]-n[i]) +
+                                     (n[i+1]-n[i]-d)*(q[i]-q[i-1])/(n[i]-n[i-1]));
+}
+
+/**
+ * Returns the linear prediction for marker i moved by d.
+ */
+double P2Quantile::linear(int i, int d) const {
+    return _heights[i] + d*(_heights[i+d]-_heights[i])/(_positions[i+d]-_positions[i]);
+}
+
+/**
+ * Adds a sample to the estimate.
+ */
+void P2Quantile::add(double value) {
+    if (_count < 5) {
+        _heights[_count++] = value;
+        if (_count == 5) {
+            std::sort(_heights, _heights+5);
+        }
+        return;
+    }
+    _count++;
+
+    // Find the cell of the sample, stretching the extremes if necessary
+    int k;
+    if (value < _heights[0]) {
+        _heights[0] = value;
+        k = 0;
+    } else if (value >= _heights[4]) {
+        _heights[4] = value;
+        k = 3;
+    } else {
+        k = 0;
+        while (value >= _heights[k+1]) {
+            k++;
+        }
+    }
+    for (int ii = k+1; ii < 5; ii++) {
+        _positions[ii] += 1;
+    }
+    for (int ii = 0; ii < 5; ii++) {
+        _desired[ii] += _increments[ii];
+    }
+
+    // Move the middle markers towards their desired positions
+    for (int ii = 1; ii < 4; ii++) {
+        double d = _desired[ii]-_positions[ii];
+        if ((d >= 1 && _positions[ii+1]-_positions[ii] > 1) ||
+            (d <= -1 && _positions[ii-1]-_positions[ii] < -1)) {
+            int step = d > 0 ? 1 : -1;
+            double height = parabolic(ii, step);
+            if (_heights[ii-1] < height && height < _heights[ii+1]) {
+                _heights[ii] = height;
+            } else {
+                _heights[ii] = linear(ii, step);
+            }
+            _positions[ii] += step;
+        }
+    }
+}
+
+/**
+ * Returns the estimated quantile.
+ */
+double P2Quantile::get() const {
+    if (_count == 0) {
+        return 0;
+    } else if (_count < 5) {
+        double sorted[5];
+        std::copy(_heights, _heights+_count, sorted);
+        std::sort(sorted, sorted+_count);
+        int rank = std::min((int)(_p*_count), _count-1);
+        return sorted[rank];
+    }
+    return _heights[2];
+}
+
+#pragma mark -
+#pragma mark HitStats
+/**
+ * Removes all hits from these statistics.
+ */
+void HitStats::reset() {
+    std::fill(_directions, _directions+DIRECTION_COUNT, 0);
+    std::fill(_judgements, _judgements+JUDGEMENT_COUNT, 0);
+    _timed = 0;
+    _mean = 0;
+    _squares = 0;
+    _p50.reset(0.50);
+    _p95.reset(0.95);
+    _p99.reset(0.99);
+}
+
+/**
+ * Adds a judged input to these statistics.
+ */
+void HitStats::record(SongTime error, Direction dir, Judgement judgement) {
+    _directions[(int)dir]++;
+    _judgements[(int)judgement]++;
+    if (judgement == Judgement::Miss) {
+        return;
+    }
+
+    // Welford's method
+    double millis = error.toMillis();
+    _timed++;
+    double delta = millis-_mean;
+    _mean += delta/_timed;
+    _squares += delta*(millis-_mean);
+
+    double absolute = std::abs(millis);
+    _p50.add(absolute);
+    _p95.add(absolute);
+    _p99.add(absolute);
+}
+
+/**
+ * Returns the total number of hits.
+ */
+int HitStats::getCount() const {
+    int total = 0;
+    for (int ii = 0; ii < JUDGEMENT_COUNT; ii++) {
+        total += _judgements[ii];
+    }
+    return total;
+}
+
+/**
+ * Returns the standard deviation of the error of the timed hits.
+ */
+SongTime HitStats::getDeviation() const {
+    return SongTime::fromMillis(std::sqrt(getVariance()));
+}
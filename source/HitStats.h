@@ -0,0 +1,201 @@
+//
+//  HitStats.h
+//  Demo
+//
+//  This class keeps the timing statistics of every judged input, for a
+//  results screen or adaptive difficulty. It uses the same memory no matter
+//  how long the session, since no individual hits are stored.
+//
+//  Notes:
+//  - Hits are counted by direction and by judgement
+//  - The mean and variance of the signed error use Welford's method
+//  - The percentiles of the absolute error use P-squared estimators, which
+//    track a quantile with five markers and never sort the history
+//  - Misses are counted, but are not part of the timing statistics
+//
+#ifndef __HIT_STATS_H__
+#define __HIT_STATS_H__
+#include <cugl/cugl.h>
+#include "SongTime.h"
+#include "Direction.h"
+#include "Judgement.h"
+
+/** The number of directions, including None */
+#define DIRECTION_COUNT 5
+
+/**
+ * A streaming estimate of a single quantile (the P-squared algorithm).
+ *
+ * This is Jain and Chlamtac's algorithm. It keeps five markers at the
+ * minimum, the maximum, the quantile and halfway to either side, and moves
+ * them with piecewise-parabolic interpolation as samples arrive.
+ */
+class P2Quantile {
+private:
+    /** The quantile to estimate, in (0,1) */
+    double _p;
+    /** The number of samples so far */
+    int _count;
+    /** The marker heights */
+    double _heights[5];
+    /** The marker positions */
+    double _positions[5];
+    /** The desired marker positions */
+    double _desired[5];
+    /** The increments of the desired marker positions */
+    double _increments[5];
+
+    /** Returns the parabolic prediction for marker i moved by d */
+    double parabolic(int i, double d) const;
+    /** Returns the linear prediction for marker i moved by d */
+    double linear(int i, int d) const;
+
+public:
+    /**
+     * Creates an estimator for the median.
+     */
+    P2Quantile() { reset(0.5); }
+
+    /**
+     * Removes all samples and sets the quantile to estimate.
+     *
+     * @param p The quantile to estimate, in (0,1)
+     */
+    void reset(double p);
+
+    /**
+     * Adds a sample to the estimate.
+     *
+     * @param value The sample
+     */
+    void add(double value);
+
+    /**
+     * Returns the estimated quantile.
+     *
+     * This is exact for the first five samples, and 0 if there are none.
+     *
+     * @return the estimated quantile
+     */
+    double get() const;
+};
+
+/**
+ * The timing statistics of a session.
+ */
+class HitStats {
+private:
+    /** The hits in each direction */
+    int _directions[DIRECTION_COUNT];
+    /** The hits with each judgement */
+    int _judgements[JUDGEMENT_COUNT];
+    /** The number of timed (non-miss) hits */
+    int _timed;
+    /** The running mean of the error in milliseconds */
+    double _mean;
+    /** The running sum of squared differences from the mean */
+    double _squares;
+    /** The median absolute error */
+    P2Quantile _p50;
+    /** The 95th percentile absolute error */
+    P2Quantile _p95;
+    /** The 99th percentile absolute error */
+    P2Quantile _p99;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates empty statistics.
+     */
+    HitStats() { reset(); }
+
+    /**
+     * Removes all hits from these statistics.
+     */
+    void reset();
+
+    /**
+     * Adds a judged input to these statistics.
+     *
+     * @param error     The signed timing error (positive is late)
+     * @param dir       The direction of the input (None for a tap)
+     * @param judgement The judgement of the input
+     */
+    void record(SongTime error, Direction dir, Judgement judgement);
+
+#pragma mark -
+#pragma mark Counters
+    /**
+     * Returns the total number of hits.
+     *
+     * @return the total number of hits
+     */
+    int getCount() const;
+
+    /**
+     * Returns the number of hits in the given direction.
+     *
+     * @param dir   The direction
+     *
+     * @return the number of hits in the given direction
+     */
+    int getCount(Direction dir) const { return _directions[(int)dir]; }
+
+    /**
+     * Returns the number of hits with the given judgement.
+     *
+     * @param judgement The judgement
+     *
+     * @return the number of hits with the given judgement
+     */
+    int getCount(Judgement judgement) const { return _judgements[(int)judgement]; }
+
+#pragma mark -
+#pragma mark Timing
+    /**
+     * Returns the mean signed error of the timed hits.
+     *
+     * A positive mean means the player is late on average.
+     *
+     * @return the mean signed error of the timed hits
+     */
+    SongTime getMean() const { return SongTime::fromMillis(_mean); }
+
+    /**
+     * Returns the variance of the error of the timed hits, in ms squared.
+     *
+     * @return the variance of the error of the timed hits
+     */
+    double getVariance() const { return _timed > 1 ? _squares/(_timed-1) : 0; }
+
+    /**
+     * Returns the standard deviation of the error of the timed hits.
+     *
+     * @return the standard deviation of the error of the timed hits
+     */
+    SongTime getDeviation() const;
+
+    /**
+     * Returns the median absolute error of the timed hits.
+     *
+     * @return the median absolute error of the timed hits
+     */
+    SongTime getP50() const { return SongTime::fromMillis(_p50.get()); }
+
+    /**
+     * Returns the 95th percentile absolute error of the timed hits.
+     *
+     * @return the 95th percentile absolute error of the timed hits
+     */
+    SongTime getP95() const { return SongTime::fromMillis(_p95.get()); }
+
+    /**
+     * Returns the 99th percentile absolute error of the timed hits.
+     *
+     * @return the 99th percentile absolute error of the timed hits
+     */
+    SongTime getP99() const { return SongTime::fromMillis(_p99.get()); }
+};
+
+#endif /* __HIT_STATS_H__ */
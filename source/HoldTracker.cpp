@@ -0,0 +1,81 @@
+//
+//  HoldTracker.cpp
+//  Demo
+//
+//  This is the implementation for the HoldTracker class.
+//
+#include "HoldTracker.h"
+
+using namespace cugl;
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Drops every hold in progress.
+ */
+void HoldTracker::reset() {
+    for (int ii = 0; ii < MAX_HOLDS; ii++) {
+        _holds[ii].active = false;
+    }
+}
+
+/**
+ * Returns the hold of the given finger, or nullptr.
+ */
+HoldTracker::Hold* HoldTracker::find(TouchID touch) {
+    for (int ii = 0; ii < MAX_HOLDS; ii++) {
+        if (_holds[ii].active && _holds[ii].touch == touch) {
+            return &_holds[ii];
+        }
+    }
+    return nullptr;
+}
+
+#pragma mark -
+#pragma mark Holds
+/**
+ * Starts a hold.
+ */
+bool HoldTracker::begin(TouchID touch, SongTime start, const TempoMap& tempo) {
+    Hold* hold = find(touch);
+    for (int ii = 0; hold == nullptr && ii < MAX_HOLDS; ii++) {
+        if (!_holds[ii].active) {
+            hold = &_holds[ii];
+        }
+    }
+    if (hold == nullptr) {
+        return false;
+    }
+    hold->touch = touch;
+    hold->start = start;
+    hold->beat = tempo.toBeat(start).getNearestBeat();
+    hold->next = tempo.getBeatTime(hold->beat+1);
+    hold->ticks = 0;
+    hold->active = true;
+    return true;
+}
+
+/**
+ * Ends a hold.
+ */
+bool HoldTracker::end(TouchID touch, SongTime& start, Sint64& ticks) {
+    Hold* hold = find(touch);
+    if (hold == nullptr) {
+        return false;
+    }
+    start = hold->start;
+    ticks = hold->ticks;
+    hold->active = false;
+    return true;
+}
+
+/**
+ * Returns the number of holds in progress.
+ */
+int HoldTracker::getCount() const {
+    int count = 0;
+    for (int ii = 0; ii < MAX_HOLDS; ii++) {
+        count += _holds[ii].active ? 1 : 0;
+    }
+    return count;
+}
@@ -0,0 +1,130 @@
+//
+//  HoldTracker.h
+//  Demo
+//
+//  This class follows the holds in progress and reports every beat that
+//  each one is held through. The start of a hold is judged like any other
+//  input; this class is what turns the time in between into "still
+//  holding" ticks, and measures the hold when it is released.
+//
+//  Notes:
+//  - Holds are kept in a fixed array, one per finger, with no allocation
+//  - Each hold caches the time of its next tick, so an update costs one
+//    comparison per hold unless a beat was crossed
+//  - A hold is identified by the touch id of its finger
+//
+#ifndef __HOLD_TRACKER_H__
+#define __HOLD_TRACKER_H__
+#include <cugl/cugl.h>
+#include "SongTime.h"
+#include "TempoMap.h"
+
+/** The number of holds that can be in progress at once */
+#define MAX_HOLDS   10
+
+/**
+ * A tracker of the holds in progress.
+ */
+class HoldTracker {
+private:
+    /**
+     * A hold in progress.
+     */
+    struct Hold {
+        /** The finger holding */
+        cugl::TouchID touch;
+        /** The song time of the press */
+        SongTime start;
+        /** The last beat that was ticked (or judged by the press) */
+        Sint64 beat;
+        /** The song time of the next beat to tick */
+        SongTime next;
+        /** The number of beats ticked so far */
+        Sint64 ticks;
+        /** Whether this slot is in use */
+        bool active;
+    };
+
+    /** The holds, one per finger */
+    Hold _holds[MAX_HOLDS];
+
+    /** Returns the hold of the given finger, or nullptr */
+    Hold* find(cugl::TouchID touch);
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates a tracker with no holds.
+     */
+    HoldTracker() { reset(); }
+
+    /**
+     * Drops every hold in progress.
+     */
+    void reset();
+
+#pragma mark -
+#pragma mark Holds
+    /**
+     * Starts a hold.
+     *
+     * The beat nearest the press is judged with the press, so the first
+     * tick is the beat after it. If the finger is already holding, the hold
+     * is restarted. If there are too many holds, this returns false.
+     *
+     * @param touch The finger holding
+     * @param start The song time of the press
+     * @param tempo The tempo map of the song
+     *
+     * @return true if the hold is tracked
+     */
+    bool begin(cugl::TouchID touch, SongTime start, const TempoMap& tempo);
+
+    /**
+     * Ends a hold.
+     *
+     * If the finger was not holding (for example the hold was dropped by a
+     * reset), this returns false and leaves the arguments unchanged.
+     *
+     * @param touch The finger holding
+     * @param start Set to the song time of the press
+     * @param ticks Set to the number of beats held through
+     *
+     * @return true if the finger was holding
+     */
+    bool end(cugl::TouchID touch, SongTime& start, Sint64& ticks);
+
+    /**
+     * Returns the number of holds in progress.
+     *
+     * @return the number of holds in progress
+     */
+    int getCount() const;
+
+    /**
+     * Reports every beat crossed by a hold up to the given time.
+     *
+     * The function is called with the touch id and the beat number of each
+     * tick, in beat order for each hold. It is a template so that the call
+     * can be inlined, as this runs every simulation step.
+     *
+     * @param now       The current song time
+     * @param tempo     The tempo map of the song
+     * @param onTick    The function to call on each tick
+     */
+    template <typename F>
+    void update(SongTime now, const TempoMap& tempo, F&& onTick) {
+        for (int ii = 0; ii < MAX_HOLDS; ii++) {
+            Hold& hold = _holds[ii];
+            while (hold.active && hold.next <= now) {
+                hold.beat++;
+                hold.ticks++;
+                hold.next = tempo.getBeatTime(hold.beat+1);
+                onTick(hold.touch, hold.beat);
+            }
+        }
+    }
+};
+
+#endif /* __HOLD_TRACKER_H__ */
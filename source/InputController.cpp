@@ -21,125 +21,262 @@ using namespace cugl;
 /**
  * Creates a new input controller with the default settings
  *
- * This is a very simple class.  It only has the default settings and never
- * needs to attach any custom listeners at initialization.  Therefore, we
- * do not need an init method.  This constructor is sufficient.
+ * This constructor does not attach any listeners. You must call init
+ * before the controller will see any presses.
  */
 InputController::InputController() :
     _dir(Direction::None),
+    _droppedGestures(0),
     _didPress(false),
-    _logOn(false){
-    _start_touch_event = TouchEvent();
-    _start_touch_event.pressure = 0;
-    _end_touch_event = TouchEvent();
-    _end_touch_event.pressure = 0;
+    _logOn(false),
+    _listenerKey(0),
+    _keyListenerKey(0){
+    for (int ii = 0; ii < MAX_TOUCHES; ii++) {
+        _touches[ii].active = false;
+    }
+}
+
+
+
+/**
+ * Attaches the listeners that capture presses and releases.
+ *
+ * Each listener records the timestamp of the platform event, so an input
+ * is timed from when it actually happened and not from the next frame.
+ *
+ * @return true if the controller was initialized successfully
+ */
+bool InputController::init() {
+    Mouse* mouse = Input::get<Mouse>();
+    Keyboard* keys = Input::get<Keyboard>();
+#ifdef CU_TOUCH_SCREEN
+    Touchscreen* touch = Input::get<Touchscreen>();
+    if (touch) {
+        _listenerKey = touch->acquireKey();
+        // Every finger has its own gesture
+        touch->addBeginListener(_listenerKey, [this](const TouchEvent& event, bool focus) {
+            beginGesture(event.position, event.touch, event.timestamp);
+        });
+        touch->addMotionListener(_listenerKey, [this](const TouchEvent& event, const Vec2& previous, bool focus) {
+            moveGesture(event.position, event.touch, event.timestamp);
+        });
+        touch->addEndListener(_listenerKey, [this](const TouchEvent& event, bool focus) {
+            endGesture(event.position, event.touch, event.timestamp);
+        });
+    }
+#else
+    if (mouse) {
+        // Drag events are needed to recognize swipes before the release
+        mouse->setPointerAwareness(Mouse::PointerAwareness::DRAG);
+        _listenerKey = mouse->acquireKey();
+        mouse->addPressListener(_listenerKey, [this](const MouseEvent& event, Uint8 clicks, bool focus) {
+            beginGesture(event.position, MOUSE_TOUCH, event.timestamp);
+        });
+        mouse->addDragListener(_listenerKey, [this](const MouseEvent& event, const Vec2& previous, bool focus) {
+            moveGesture(event.position, MOUSE_TOUCH, event.timestamp);
+        });
+        mouse->addReleaseListener(_listenerKey, [this](const MouseEvent& event, Uint8 clicks, bool focus) {
+            endGesture(event.position, MOUSE_TOUCH, event.timestamp);
+        });
+    }
+    if (keys) {
+        // A key stands for a whole gesture, so it is decided on the press
+        _keyListenerKey = keys->acquireKey();
+        keys->addKeyDownListener(_keyListenerKey, [this](const KeyEvent& event, bool focus) {
+            GestureType type = keyGesture(event.keycode);
+            if (type != GestureType::Undecided) {
+                TouchEvent start;
+                start.position = Vec2::ZERO;
+                start.pressure = 1;
+                start.touch = MOUSE_TOUCH;
+                start.timestamp = event.timestamp;
+                queueGesture(type, start, Vec2::ZERO, event.timestamp);
+            }
+        });
+    }
+#endif
+    return true;
+}
+
+/**
+ * Detaches the listeners.
+ */
+void InputController::dispose() {
+#ifdef CU_TOUCH_SCREEN
+    Touchscreen* touch = Input::get<Touchscreen>();
+    if (touch && _listenerKey) {
+        touch->removeBeginListener(_listenerKey);
+        touch->removeMotionListener(_listenerKey);
+        touch->removeEndListener(_listenerKey);
+    }
+#else
+    Mouse* mouse = Input::get<Mouse>();
+    if (mouse && _listenerKey) {
+        mouse->removePressListener(_listenerKey);
+        mouse->removeDragListener(_listenerKey);
+        mouse->removeReleaseListener(_listenerKey);
+    }
+    Keyboard* keys = Input::get<Keyboard>();
+    if (keys && _keyListenerKey) {
+        keys->removeKeyDownListener(_keyListenerKey);
+    }
+#endif
+    _listenerKey = 0;
+    _keyListenerKey = 0;
+}
+
+/**
+ * Records the start of a gesture.
+ */
+void InputController::beginGesture(const Vec2& position, TouchID touch, const Timestamp& stamp) {
+    TouchSlot* slot = findTouch(touch);
+    for (int ii = 0; slot == nullptr && ii < MAX_TOUCHES; ii++) {
+        if (!_touches[ii].active) {
+            slot = &_touches[ii];
+        }
+    }
+    if (slot == nullptr) {
+        // More fingers than we track
+        return;
+    }
+    slot->start.position = position;
+    slot->start.pressure = 1;
+    slot->start.touch = touch;
+    slot->start.timestamp = stamp;
+    slot->recognizer.begin(position, stamp);
+    slot->active = true;
+    slot->queued = false;
+}
+
+/**
+ * Records an intermediate sample of the gesture in progress.
+ */
+void InputController::moveGesture(const Vec2& position, TouchID touch, const Timestamp& stamp) {
+    TouchSlot* slot = findTouch(touch);
+    if (slot == nullptr || slot->queued) {
+        return;
+    }
+    GestureType type = slot->recognizer.move(position, stamp);
+    if (type != GestureType::Undecided) {
+        queueGesture(type, slot->start, position, stamp);
+        slot->queued = true;
+    }
+}
+
+/**
+ * Records the end of the gesture in progress.
+ */
+void InputController::endGesture(const Vec2& position, TouchID touch, const Timestamp& stamp) {
+    TouchSlot* slot = findTouch(touch);
+    if (slot == nullptr) {
+        return;
+    }
+    // Undecided if it was already queued during the motion
+    GestureType type = slot->recognizer.end(position);
+    if (type == GestureType::HoldEnd || (type != GestureType::Undecided && !slot->queued)) {
+        queueGesture(type, slot->start, position, stamp);
+    }
+    slot->active = false;
+}
+
+/**
+ * Queues a hold for every finger that has stayed still long enough.
+ */
+void InputController::pollHolds(const Timestamp& now) {
+    for (int ii = 0; ii < MAX_TOUCHES; ii++) {
+        TouchSlot& slot = _touches[ii];
+        if (slot.active && !slot.queued && slot.recognizer.hold(now) == GestureType::Hold) {
+            queueGesture(GestureType::Hold, slot.start, slot.start.position, now);
+            slot.queued = true;
+        }
+    }
+}
+
+/**
+ * Queues a gesture once it is decided.
+ */
+void InputController::queueGesture(GestureType type, const TouchEvent& start, const Vec2& position, const Timestamp& stamp) {
+    Gesture gesture;
+    gesture.type = type;
+    gesture.start = start;
+    gesture.end.position = position;
+    gesture.end.pressure = 1;
+    gesture.end.touch = start.touch;
+    gesture.end.timestamp = stamp;
+    gesture.stamped = false;
+    if (!_gestures.push(gesture)) {
+        _droppedGestures++;
+    }
 }
 
+/**
+ * Returns the slot of the finger with a gesture in progress, or nullptr.
+ */
+InputController::TouchSlot* InputController::findTouch(TouchID touch) {
+    // There are only a few slots, so a scan beats hashing
+    for (int ii = 0; ii < MAX_TOUCHES; ii++) {
+        if (_touches[ii].active && _touches[ii].start.touch == touch) {
+            return &_touches[ii];
+        }
+    }
+    return nullptr;
+}
 
+/**
+ * Returns the gesture a key stands for, or Undecided.
+ */
+GestureType InputController::keyGesture(KeyCode key) {
+    switch (key) {
+        case KeyCode::ARROW_UP:    return GestureType::Up;
+        case KeyCode::ARROW_DOWN:  return GestureType::Down;
+        case KeyCode::ARROW_LEFT:  return GestureType::Left;
+        case KeyCode::ARROW_RIGHT: return GestureType::Right;
+        case KeyCode::A:           return GestureType::Tap;
+        default:                   return GestureType::Undecided;
+    }
+}
 
 /**
  * Reads the input for this player and converts the result into game logic.
  *
- * This is an example of polling input.  Instead of registering a listener,
- * we ask the controller about its current state.  When the game is running,
- * it is typically best to poll input instead of using listeners.  Listeners
- * are more appropriate for menus and buttons (like the loading screen).
+ * Presses and releases are captured by the listeners as they happen. This
+ * method decides any holds, converts the timestamps into song time, and
+ * polls the keys for the other commands.
+ *
+ * @param clock The song clock (already updated this frame)
  */
-void InputController::readInput() {
+void InputController::readInput(const BeatClock& clock) {
     // Convert keyboard state into game commands
     _dir = Direction::None;
     _didReset = false;
     _didDrop = false;
     _didPickUp = false;
     _toggleOverlay = false  ;
+    _toggleLatency = false;
+    _didCalibrate = false;
 
+    // The listeners run on this thread, so the slots are safe to poll here
+    pollHolds(Timestamp());
 
-    // Movement forward/backward
-    Keyboard* key_board = Input::get<Keyboard>();
-#ifdef CU_TOUCH_SCREEN
-    
-    Touchscreen* touch_screen = Input::get<Touchscreen>();
-    std::vector<TouchID> touch_ids = touch_screen->touchSet();
-    if (!touch_ids.empty()) {
-        TouchID focusedID = touch_ids[0];
-        if (touch_screen->touchDown(focusedID)) {
-            _start_touch_event.position = touch_screen->touchPosition(focusedID);
-            _end_touch_event.position.x *= -1;
-            _start_touch_event.pressure = 1;
-            _start_touch_event.touch = focusedID;
-            _start_touch_event.timestamp = Timestamp();
-        }
-        else if (touch_screen->touchReleased(focusedID) && _start_touch_event.pressure) {
-            _end_touch_event.position = touch_screen->touchPosition(_start_touch_event.touch);
-            _start_touch_event.position.x *= -1;
-            _end_touch_event.pressure = 1;
-            _end_touch_event.touch = focusedID;
-            _end_touch_event.timestamp = Timestamp();
+    // Each gesture is converted once, with the clock of the frame that saw it
+    Gesture* gesture;
+    for (size_t ii = 0; (gesture = _gestures.peek(ii)) != nullptr; ii++) {
+        if (!gesture->stamped) {
+            gesture->startTime = clock.toSongTime(gesture->start.timestamp);
+            gesture->endTime = clock.toSongTime(gesture->end.timestamp);
+            gesture->stamped = true;
         }
     }
-    
-#else
 
+    Keyboard* key_board = Input::get<Keyboard>();
+    if (key_board == nullptr) {
+        return;
+    }
+    
     // This makes it easier to change the keys later
-    KeyCode up = KeyCode::ARROW_UP;
-    KeyCode down = KeyCode::ARROW_DOWN;
-    KeyCode left = KeyCode::ARROW_LEFT;
-    KeyCode right = KeyCode::ARROW_RIGHT;
-    KeyCode tap = KeyCode::A;
     KeyCode log = KeyCode::L;
     KeyCode reset = KeyCode::R;
-    int focusedID = -1;
-
-    Mouse* mouse = Input::get<Mouse>();
-    if (mouse) {
-        if (mouse->buttonDown().hasLeft()) {
-            _start_touch_event.position = mouse->pointerPosition();
-            _start_touch_event.position.x *= -1;
-            _start_touch_event.pressure = 1;
-            _start_touch_event.touch = focusedID;
-            _start_touch_event.timestamp = Timestamp();
-        }
-        else if (mouse->buttonUp().hasLeft() && _start_touch_event.pressure) {
-            _end_touch_event.position = mouse->pointerPosition();
-            _end_touch_event.position.x *= -1;
-            _end_touch_event.pressure = 1;
-            _end_touch_event.touch = focusedID;
-            _end_touch_event.timestamp = Timestamp();
-        }
-    }
-    if (key_board->keyPressed(up) || key_board->keyPressed(down) || key_board->keyPressed(left) || key_board->keyPressed(right) || key_board->keyPressed(tap)) {
-        CULog("A");
-        _start_touch_event.position = Vec2(0, 0);
-        _start_touch_event.touch = focusedID;
-        _start_touch_event.timestamp = Timestamp();
-    }
-    else if ((key_board->keyReleased(up) || key_board->keyReleased(down) || key_board->keyReleased(left) || key_board->keyReleased(right) || key_board->keyReleased(tap))) {
-        CULog("B");
-        _start_touch_event.pressure = 1;
-        _end_touch_event.pressure = 1;
-        _end_touch_event.touch = focusedID;
-        _end_touch_event.timestamp = Timestamp();
 
-        Vec2 dir;
-
-        if (key_board->keyReleased(up)) {
-            dir = Vec2(0, -100);
-        }
-        else if (key_board->keyReleased(down)) {
-            dir = Vec2(0, 100);
-        }
-        else if (key_board->keyReleased(left)) {
-            dir = Vec2(100, 0);
-        }
-        else if (key_board->keyReleased(right)) {
-            dir = Vec2(-100, 0);
-        }
-        else if (key_board->keyReleased(tap)) {
-            dir = Vec2(0, 0);
-        }
-
-        _end_touch_event.position = dir;
-    }
     // Reset the game
     if (key_board->keyDown(reset)) {
         _didReset = true;
@@ -150,6 +287,10 @@ void InputController::readInput() {
     if (key_board->keyPressed(KeyCode::M)) {
         _toggleOverlay = true;
     }
-
-#endif
+    if (key_board->keyPressed(KeyCode::C)) {
+        _didCalibrate = true;
+    }
+    if (key_board->keyPressed(KeyCode::P)) {
+        _toggleLatency = true;
+    }
 }
@@ -16,8 +16,16 @@
 #ifndef __INPUT_CONTROLLER_H__
 #define __INPUT_CONTROLLER_H__
 #include "Direction.h"
+#include "BeatClock.h"
+#include "SpscRing.h"
+#include "GestureRecognizer.h"
 using namespace cugl;
 
+/** The number of completed gestures that can wait to be processed */
+#define GESTURE_CAPACITY    64
+/** The number of fingers that can be tracked at once */
+#define MAX_TOUCHES         10
+
 /**
  * Device-independent input manager.
  *
@@ -30,8 +38,26 @@ private:
     
     Direction _dir;
 
-    TouchEvent _start_touch_event;
-    TouchEvent _end_touch_event;
+    /**
+     * A finger (or the mouse) with a gesture in progress.
+     */
+    struct TouchSlot {
+        /** The press that started the gesture */
+        TouchEvent start;
+        /** The classifier of the gesture */
+        GestureRecognizer recognizer;
+        /** Whether this slot is in use */
+        bool active;
+        /** Whether the gesture has been queued already */
+        bool queued;
+    };
+
+    /** The gestures in progress, one per finger (capture side only) */
+    TouchSlot _touches[MAX_TOUCHES];
+    /** The completed gestures, oldest first */
+    SpscRing<Gesture, GESTURE_CAPACITY> _gestures;
+    /** The number of gestures dropped because the queue was full */
+    Uint32 _droppedGestures;
     
     bool _didPress;
     
@@ -43,6 +69,30 @@ private:
     bool _pressed = false;
     bool _logOn = false;
     bool _toggleOverlay = false;
+    /** Did we press the latency overlay button? */
+    bool _toggleLatency = false;
+    /** Did we press the calibration button? */
+    bool _didCalibrate = false;
+
+    /** The key for the mouse or touch listeners */
+    Uint32 _listenerKey;
+    /** The key for the keyboard listeners */
+    Uint32 _keyListenerKey;
+
+    /** Records the start of a gesture */
+    void beginGesture(const Vec2& position, TouchID touch, const Timestamp& stamp);
+    /** Records an intermediate sample of the gesture in progress */
+    void moveGesture(const Vec2& position, TouchID touch, const Timestamp& stamp);
+    /** Records the end of the gesture in progress */
+    void endGesture(const Vec2& position, TouchID touch, const Timestamp& stamp);
+    /** Queues a hold for every finger that has stayed still long enough */
+    void pollHolds(const Timestamp& now);
+    /** Queues a gesture once it is decided */
+    void queueGesture(GestureType type, const TouchEvent& start, const Vec2& position, const Timestamp& stamp);
+    /** Returns the slot of the finger with a gesture in progress, or nullptr */
+    TouchSlot* findTouch(TouchID touch);
+    /** Returns the gesture a key stands for, or Undecided */
+    static GestureType keyGesture(KeyCode key);
 
     
 
@@ -60,31 +110,59 @@ public:
     bool didToggleOverlay() const {
         return _toggleOverlay;
     }
-
-    bool queryInputReady() {
-        return _start_touch_event.pressure == 1 && _end_touch_event.pressure == 1;
-    }
-
-    bool queryStartEventReady(){
-        return _start_touch_event.pressure;
+    /**
+     * Returns whether the latency overlay button was pressed.
+     *
+     * @return whether the latency overlay button was pressed.
+     */
+    bool didToggleLatency() const {
+        return _toggleLatency;
     }
-    bool queryEndEventReady() {
-        return _end_touch_event.pressure;
+    /**
+     * Returns whether the calibration button was pressed.
+     *
+     * @return whether the calibration button was pressed.
+     */
+    bool didCalibrate() const {
+        return _didCalibrate;
     }
-    TouchEvent peekStartEvent() {
-        return _start_touch_event;
+
+    /**
+     * Returns the oldest completed gesture, or nullptr if there is none.
+     *
+     * Only gestures seen by readInput (and so converted to song time) are
+     * returned. The gesture stays queued until popGesture is called.
+     *
+     * @return the oldest completed gesture
+     */
+    const Gesture* peekGesture() {
+        const Gesture* gesture = _gestures.peek();
+        return gesture != nullptr && gesture->stamped ? gesture : nullptr;
     }
-    TouchEvent peekEndEvent() {
-        return _end_touch_event;
+
+    /**
+     * Removes the oldest completed gesture.
+     */
+    void popGesture() {
+        Gesture gesture;
+        _gestures.pop(gesture);
     }
-    std::pair<TouchEvent, TouchEvent> peekCompletedEvent () {
-        return std::pair(_start_touch_event, _end_touch_event);
+
+    /**
+     * Removes all completed gestures.
+     */
+    void clearGestures() {
+        Gesture gesture;
+        while (_gestures.pop(gesture)) {}
     }
-    void clearTouchEvents() {
-        _start_touch_event = TouchEvent();
-        _start_touch_event.pressure = 0;
-        _end_touch_event = TouchEvent();
-        _end_touch_event.pressure = 0;
+
+    /**
+     * Returns the number of gestures dropped because the queue was full.
+     *
+     * @return the number of gestures dropped
+     */
+    Uint32 getDroppedGestures() const {
+        return _droppedGestures;
     }
 
     bool didPickUp() const {
@@ -106,26 +184,42 @@ public:
     /**
      * Creates a new input controller with the default settings
      *
-     * This is a very simple class.  It only has the default settings and never
-     * needs to attach any custom listeners at initialization.  Therefore, we
-     * do not need an init method.  This constructor is sufficient.
+     * This constructor does not attach any listeners. You must call init
+     * before the controller will see any presses.
      */
     InputController();
 
     /**
      * Disposses this input controller, releasing all resources.
      */
-    ~InputController() {}
+    ~InputController() { dispose(); }
+
+    /**
+     * Attaches the listeners that capture presses and releases.
+     *
+     * Polling would stamp every press with the time of the next frame, which
+     * is up to a frame late. The listeners record the timestamp of the
+     * platform event instead.
+     *
+     * @return true if the controller was initialized successfully
+     */
+    bool init();
+
+    /**
+     * Detaches the listeners.
+     */
+    void dispose();
     
     /**
      * Reads the input for this player and converts the result into game logic.
      *
-     * This is an example of polling input.  Instead of registering a listener,
-     * we ask the controller about its current state.  When the game is running,
-     * it is typically best to poll input instead of using listeners.  Listeners
-     * are more appropriate for menus and buttons (like the loading screen).
+     * Presses and releases are captured by the listeners as they happen. This
+     * method decides any holds, converts the timestamps into song time, and
+     * polls the keys for the other commands.
+     *
+     * @param clock The song clock (already updated this frame)
      */
-    void readInput();
+    void readInput(const BeatClock& clock);
 };
 
 #endif /*__INPUT_CONTROLLER_H__*/
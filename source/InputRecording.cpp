@@ -0,0 +1,114 @@
+//
+//  InputRecording.cpp
+//  Demo
+//
+//  This is the implementation for the InputRecording class.
+//
+#include "InputRecording.h"
+#include <algorithm>
+#include <fstream>
+
+using namespace cugl;
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Clears this recording and starts a new session.
+ */
+void InputRecording::start(Uint32 seed, SongTime start) {
+    _seed = seed;
+    _start = start;
+    _records.clear();
+}
+
+/**
+ * Replaces this recording with a recording file.
+ */
+bool InputRecording::load(const std::string& path) {
+    std::shared_ptr<BinaryReader> reader = BinaryReader::alloc(path);
+    if (reader == nullptr) {
+        return false;
+    }
+
+    ReplayHeader header;
+    if (reader->read((char*)&header, sizeof(ReplayHeader)) != sizeof(ReplayHeader) ||
+        header.magic != REPLAY_MAGIC || header.version != REPLAY_VERSION ||
+        header.recordSize != sizeof(ReplayRecord)) {
+        CULog("Invalid recording %s", path.c_str());
+        reader->close();
+        return false;
+    }
+
+    // The records are used as-is, so these are bulk reads. They are read
+    // a block at a time, so a bad count cannot allocate past the file.
+    std::vector<ReplayRecord> records;
+    while (records.size() < header.count) {
+        size_t first = records.size();
+        size_t count = std::min((size_t)header.count-first, (size_t)REPLAY_READ_BLOCK);
+        records.resize(first+count);
+        size_t bytes = count*sizeof(ReplayRecord);
+        if (reader->read((char*)(records.data()+first), bytes) != bytes) {
+            CULog("Truncated recording %s", path.c_str());
+            reader->close();
+            return false;
+        }
+    }
+    reader->close();
+
+    _seed = header.seed;
+    _start = SongTime::fromNanos(header.start);
+    _records = std::move(records);
+    return true;
+}
+
+/**
+ * Writes this recording to a file.
+ */
+bool InputRecording::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        CULog("Failed to create %s", path.c_str());
+        return false;
+    }
+
+    ReplayHeader header = {REPLAY_MAGIC, REPLAY_VERSION, sizeof(ReplayRecord),
+                           _seed, (Uint32)_records.size(), _start.toNanos()};
+    out.write((const char*)&header, sizeof(ReplayHeader));
+    out.write((const char*)_records.data(), _records.size()*sizeof(ReplayRecord));
+    return out.good();
+}
+
+#pragma mark -
+#pragma mark Recording
+/**
+ * Adds a consumed gesture.
+ */
+void InputRecording::addGesture(const Gesture& gesture) {
+    ReplayRecord record = {gesture.startTime.toNanos(), gesture.endTime.toNanos(),
+                           (Sint32)gesture.start.touch, (Uint8)gesture.type, {0, 0, 0}};
+    _records.push_back(record);
+}
+
+/**
+ * Adds an overlay toggle.
+ */
+void InputRecording::addOverlay(SongTime time) {
+    ReplayRecord record = {time.toNanos(), time.toNanos(), MOUSE_TOUCH, REPLAY_OVERLAY, {0, 0, 0}};
+    _records.push_back(record);
+}
+
+/**
+ * Returns the gesture of a recorded input.
+ */
+Gesture InputRecording::toGesture(const ReplayRecord& record) {
+    Gesture gesture;
+    gesture.type = (GestureType)record.kind;
+    gesture.start.position = Vec2::ZERO;
+    gesture.start.pressure = 1;
+    gesture.start.touch = record.touch;
+    gesture.end = gesture.start;
+    gesture.startTime = SongTime::fromNanos(record.startTime);
+    gesture.endTime = SongTime::fromNanos(record.endTime);
+    gesture.stamped = true;
+    return gesture;
+}
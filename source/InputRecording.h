@@ -0,0 +1,189 @@
+//
+//  InputRecording.h
+//  Demo
+//
+//  This class records a play session so that it can be replayed exactly.
+//  It stores every gesture the game consumed with its song times, the
+//  overlay toggles, and the random seed of the session. Since the game is
+//  stepped in fixed increments of song time, feeding the same gestures back
+//  at the same song times reproduces the same game.
+//
+//  File layout (little-endian):
+//  - ReplayHeader (24 bytes)
+//  - count ReplayRecord records (24 bytes each), in the order consumed
+//
+//  Notes:
+//  - Positions and platform timestamps are not stored, since the game
+//    only uses the gesture type, the finger and the song times
+//  - A replay is only exact with a fixed simulation rate
+//
+#ifndef __INPUT_RECORDING_H__
+#define __INPUT_RECORDING_H__
+#include <cugl/cugl.h>
+#include <vector>
+#include "SongTime.h"
+#include "GestureRecognizer.h"
+
+/** The magic number at the start of every recording ("NCRP") */
+#define REPLAY_MAGIC    0x5052434E
+/** The current recording version */
+#define REPLAY_VERSION  1
+/** The record kind of an overlay toggle (every other kind is a GestureType) */
+#define REPLAY_OVERLAY  0xFF
+/** The most records read from a recording at once */
+#define REPLAY_READ_BLOCK   4096
+
+/**
+ * The header of a recording file.
+ */
+struct ReplayHeader {
+    /** Must be REPLAY_MAGIC */
+    Uint32 magic;
+    /** The file format version */
+    Uint16 version;
+    /** The size of each record */
+    Uint16 recordSize;
+    /** The seed of rand() for the session */
+    Uint32 seed;
+    /** The number of records following the header */
+    Uint32 count;
+    /** The song time the session started in nanoseconds */
+    Sint64 start;
+};
+
+/**
+ * A single recorded input.
+ */
+struct ReplayRecord {
+    /** The song time of the press in nanoseconds */
+    Sint64 startTime;
+    /** The song time the gesture was decided in nanoseconds */
+    Sint64 endTime;
+    /** The finger of the gesture */
+    Sint32 touch;
+    /** The GestureType, or REPLAY_OVERLAY */
+    Uint8 kind;
+    /** Reserved for future use */
+    Uint8 reserved[3];
+};
+
+static_assert(sizeof(ReplayHeader) == 24, "ReplayHeader must match the file layout");
+static_assert(sizeof(ReplayRecord) == 24, "ReplayRecord must match the file layout");
+
+/**
+ * A recorded play session.
+ */
+class InputRecording {
+private:
+    /** The seed of rand() for the session */
+    Uint32 _seed;
+    /** The song time the session started */
+    SongTime _start;
+    /** The inputs, in the order they were consumed */
+    std::vector<ReplayRecord> _records;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates an empty recording.
+     */
+    InputRecording() : _seed(0) {}
+
+    /**
+     * Clears this recording and starts a new session.
+     *
+     * @param seed  The seed of rand() for the session
+     * @param start The song time the session starts
+     */
+    void start(Uint32 seed, SongTime start);
+
+    /**
+     * Replaces this recording with a recording file.
+     *
+     * @param path  The path to the recording file
+     *
+     * @return true if the file was loaded successfully
+     */
+    bool load(const std::string& path);
+
+    /**
+     * Writes this recording to a file.
+     *
+     * @param path  The path to the recording file
+     *
+     * @return true if the file was written successfully
+     */
+    bool save(const std::string& path) const;
+
+#pragma mark -
+#pragma mark Recording
+    /**
+     * Adds a consumed gesture.
+     *
+     * @param gesture   The gesture (with its song times)
+     */
+    void addGesture(const Gesture& gesture);
+
+    /**
+     * Adds an overlay toggle.
+     *
+     * @param time  The song time the toggle was consumed
+     */
+    void addOverlay(SongTime time);
+
+#pragma mark -
+#pragma mark Attributes
+    /**
+     * Returns the seed of rand() for the session.
+     *
+     * @return the seed of rand() for the session
+     */
+    Uint32 getSeed() const { return _seed; }
+
+    /**
+     * Returns the song time the session started.
+     *
+     * @return the song time the session started
+     */
+    SongTime getStart() const { return _start; }
+
+    /**
+     * Returns the song time of the last input, or the start if there is none.
+     *
+     * @return the song time of the last input
+     */
+    SongTime getEnd() const {
+        return _records.empty() ? _start : SongTime::fromNanos(_records.back().endTime);
+    }
+
+    /**
+     * Returns the number of recorded inputs.
+     *
+     * @return the number of recorded inputs
+     */
+    size_t size() const { return _records.size(); }
+
+    /**
+     * Returns the recorded input at the given index.
+     *
+     * @param index The input index
+     *
+     * @return the recorded input at the given index
+     */
+    const ReplayRecord& get(size_t index) const { return _records[index]; }
+
+    /**
+     * Returns the gesture of a recorded input.
+     *
+     * The gesture is already converted to song time. The record must not be
+     * an overlay toggle.
+     *
+     * @param record    The recorded input
+     *
+     * @return the gesture of a recorded input
+     */
+    static Gesture toGesture(const ReplayRecord& record);
+};
+
+#endif /* __INPUT_RECORDING_H__ */
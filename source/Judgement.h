@@ -0,0 +1,28 @@
+// Judgement.h
+#ifndef __JUDGEMENT_H__
+#define __JUDGEMENT_H__
+
+/** How close an input was to its note, from best to worst */
+enum class Judgement {
+    Perfect,
+    Good,
+    Ok,
+    Poor,
+    Miss
+};
+
+/** The number of judgements */
+#define JUDGEMENT_COUNT 5
+
+/** Returns the name of a judgement for logging */
+inline const char* judgementName(Judgement judgement) {
+    switch (judgement) {
+        case Judgement::Perfect: return "perfect";
+        case Judgement::Good:    return "good";
+        case Judgement::Ok:      return "ok";
+        case Judgement::Poor:    return "poor";
+        default:                 return "miss";
+    }
+}
+
+#endif // !__JUDGEMENT_H__
@@ -0,0 +1,125 @@
+//
+//  JudgementEngine.cpp
+//  Demo
+//
+//  This is the implementation for the JudgementEngine class.
+//
+#include "JudgementEngine.h"
+#include <algorithm>
+
+using namespace cugl;
+
+/** The points for each judgement, before the combo bonus */
+constexpr Uint32 JUDGEMENT_POINTS[JUDGEMENT_COUNT] = {300, 200, 100, 50, 0};
+/** The combo length that raises the multiplier by one */
+#define COMBO_STEP      10
+/** The largest score multiplier */
+#define MAX_MULTIPLIER  4
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Clears the combo and score.
+ */
+void JudgementEngine::reset() {
+    _combo = 0;
+    _maxCombo = 0;
+    _score = 0;
+    for (int ii = 0; ii < JUDGEMENT_COUNT; ii++) {
+        _counts[ii] = 0;
+    }
+}
+
+/**
+ * Returns the difficulty with the given name, or Normal.
+ */
+Difficulty JudgementEngine::difficultyFromName(const std::string& name) {
+    if (name == "easy") {
+        return Difficulty::Easy;
+    } else if (name == "hard") {
+        return Difficulty::Hard;
+    }
+    return Difficulty::Normal;
+}
+
+#pragma mark -
+#pragma mark Judging
+/**
+ * Returns the judgement of an error at the current difficulty.
+ */
+Judgement JudgementEngine::judge(SongTime delta, SongTime interval) const {
+    switch (_difficulty) {
+        case Difficulty::Easy: return judgeWith<Difficulty::Easy>(delta, interval);
+        case Difficulty::Hard: return judgeWith<Difficulty::Hard>(delta, interval);
+        default:               return judgeWith<Difficulty::Normal>(delta, interval);
+    }
+}
+
+/**
+ * Adds a judgement to the combo and score.
+ */
+void JudgementEngine::record(Judgement judgement) {
+    _counts[(int)judgement]++;
+    if (judgement == Judgement::Poor || judgement == Judgement::Miss) {
+        _combo = 0;
+    } else {
+        _combo++;
+        _maxCombo = std::max(_maxCombo, _combo);
+    }
+    Uint32 multiplier = std::min<Uint32>(1+_combo/COMBO_STEP, MAX_MULTIPLIER);
+    _score += JUDGEMENT_POINTS[(int)judgement]*multiplier;
+}
+
+/**
+ * Judges a whole session of inputs with the windows of a difficulty.
+ */
+template <Difficulty D>
+void JudgementEngine::judgeAllWith(const Chart& chart, const TempoMap& tempo,
+                                   const SongTime* inputs, size_t count, Judgement* results) {
+    if (chart.isEmpty()) {
+        std::fill(results, results+count, Judgement::Miss);
+        return;
+    }
+
+    size_t note = 0;
+    for (size_t ii = 0; ii < count; ii++) {
+        // Walk to the last note at or before the input, then pick the nearer
+        Sint64 time = inputs[ii].toNanos();
+        while (note+1 < chart.size() && chart.get(note+1).time <= time) {
+            note++;
+        }
+        size_t nearest = note;
+        if (note+1 < chart.size() &&
+            std::abs(chart.get(note+1).time-time) < std::abs(chart.get(note).time-time)) {
+            nearest = note+1;
+        }
+        const ChartNote& target = chart.get(nearest);
+        SongTime delta = (inputs[ii]-target.getTime()).abs();
+        results[ii] = judgeWith<D>(delta, tempo.getInterval(target.beat));
+    }
+}
+
+template void JudgementEngine::judgeAllWith<Difficulty::Easy>(const Chart&, const TempoMap&, const SongTime*, size_t, Judgement*);
+template void JudgementEngine::judgeAllWith<Difficulty::Normal>(const Chart&, const TempoMap&, const SongTime*, size_t, Judgement*);
+template void JudgementEngine::judgeAllWith<Difficulty::Hard>(const Chart&, const TempoMap&, const SongTime*, size_t, Judgement*);
+
+/**
+ * Judges a whole session of inputs against a chart.
+ */
+void JudgementEngine::judgeAll(const Chart& chart, const TempoMap& tempo,
+                               const SongTime* inputs, size_t count, Judgement* results) {
+    switch (_difficulty) {
+        case Difficulty::Easy:
+            judgeAllWith<Difficulty::Easy>(chart, tempo, inputs, count, results);
+            break;
+        case Difficulty::Hard:
+            judgeAllWith<Difficulty::Hard>(chart, tempo, inputs, count, results);
+            break;
+        default:
+            judgeAllWith<Difficulty::Normal>(chart, tempo, inputs, count, results);
+            break;
+    }
+    for (size_t ii = 0; ii < count; ii++) {
+        record(results[ii]);
+    }
+}
@@ -0,0 +1,213 @@
+//
+//  JudgementEngine.h
+//  Demo
+//
+//  This class turns timing errors into judgements, and keeps the combo and
+//  score. The timing windows of each difficulty are compile-time tables,
+//  selected by template, so judging an input is a handful of integer
+//  comparisons with no allocation.
+//
+//  Notes:
+//  - Windows are in thousandths of a beat, so they scale with the tempo
+//  - An input is judged by the smallest window that contains its error
+//  - Poor and Miss break the combo
+//
+#ifndef __JUDGEMENT_ENGINE_H__
+#define __JUDGEMENT_ENGINE_H__
+#include <cugl/cugl.h>
+#include <string>
+#include "SongTime.h"
+#include "TempoMap.h"
+#include "Chart.h"
+#include "Judgement.h"
+
+/** The number of judgements with a window (every one but Miss) */
+#define WINDOW_COUNT    (JUDGEMENT_COUNT-1)
+
+/** The difficulty settings, from widest windows to narrowest */
+enum class Difficulty {
+    Easy,
+    Normal,
+    Hard
+};
+
+/**
+ * The timing windows of a difficulty.
+ *
+ * Each difficulty specializes this with a table of the largest error, in
+ * thousandths of a beat, for Perfect, Good, Ok and Poor.
+ */
+template <Difficulty D>
+struct JudgementWindows;
+
+template <>
+struct JudgementWindows<Difficulty::Easy> {
+    static constexpr Sint64 WINDOWS[WINDOW_COUNT] = {130, 200, 300, 400};
+};
+
+template <>
+struct JudgementWindows<Difficulty::Normal> {
+    static constexpr Sint64 WINDOWS[WINDOW_COUNT] = {100, 150, 250, 350};
+};
+
+template <>
+struct JudgementWindows<Difficulty::Hard> {
+    static constexpr Sint64 WINDOWS[WINDOW_COUNT] = {70, 110, 180, 250};
+};
+
+/**
+ * A judge of timing errors, with the combo and score of a session.
+ */
+class JudgementEngine {
+private:
+    /** The difficulty of the windows */
+    Difficulty _difficulty;
+    /** The number of judged inputs since the combo last broke */
+    Uint32 _combo;
+    /** The longest combo since the reset */
+    Uint32 _maxCombo;
+    /** The total score since the reset */
+    Uint64 _score;
+    /** The number of inputs with each judgement */
+    Uint32 _counts[JUDGEMENT_COUNT];
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates an engine on Normal with no score.
+     */
+    JudgementEngine() : _difficulty(Difficulty::Normal) { reset(); }
+
+    /**
+     * Clears the combo and score.
+     */
+    void reset();
+
+    /**
+     * Sets the difficulty of the windows.
+     *
+     * @param difficulty    The difficulty
+     */
+    void setDifficulty(Difficulty difficulty) { _difficulty = difficulty; }
+
+    /**
+     * Returns the difficulty of the windows.
+     *
+     * @return the difficulty of the windows
+     */
+    Difficulty getDifficulty() const { return _difficulty; }
+
+    /**
+     * Returns the difficulty with the given name, or Normal.
+     *
+     * @param name  The name ("easy", "normal" or "hard")
+     *
+     * @return the difficulty with the given name
+     */
+    static Difficulty difficultyFromName(const std::string& name);
+
+#pragma mark -
+#pragma mark Judging
+    /**
+     * Returns the judgement of an error with the windows of a difficulty.
+     *
+     * @param delta     The absolute error of the input
+     * @param interval  The length of the beat of the note
+     *
+     * @return the judgement of the error
+     */
+    template <Difficulty D>
+    static constexpr Judgement judgeWith(SongTime delta, SongTime interval) {
+        for (int ii = 0; ii < WINDOW_COUNT; ii++) {
+            if (delta*1000 <= interval*JudgementWindows<D>::WINDOWS[ii]) {
+                return (Judgement)ii;
+            }
+        }
+        return Judgement::Miss;
+    }
+
+    /**
+     * Returns the judgement of an error at the current difficulty.
+     *
+     * This does not change the combo or score; see record.
+     *
+     * @param delta     The absolute error of the input
+     * @param interval  The length of the beat of the note
+     *
+     * @return the judgement of the error
+     */
+    Judgement judge(SongTime delta, SongTime interval) const;
+
+    /**
+     * Adds a judgement to the combo and score.
+     *
+     * @param judgement The judgement of an input
+     */
+    void record(Judgement judgement);
+
+    /**
+     * Judges a whole session of inputs against a chart.
+     *
+     * Each input is judged against its nearest note, and the results are
+     * added to the combo and score. The inputs must be sorted by time, so
+     * the chart is walked once instead of searched per input.
+     *
+     * @param chart     The chart of the song
+     * @param tempo     The tempo map of the song
+     * @param inputs    The song times of the inputs, in order
+     * @param count     The number of inputs
+     * @param results   The array (of size count) to store the judgements
+     */
+    void judgeAll(const Chart& chart, const TempoMap& tempo,
+                  const SongTime* inputs, size_t count, Judgement* results);
+
+    /**
+     * Judges a whole session of inputs with the windows of a difficulty.
+     *
+     * This is judgeAll without the combo and score.
+     *
+     * @param chart     The chart of the song
+     * @param tempo     The tempo map of the song
+     * @param inputs    The song times of the inputs, in order
+     * @param count     The number of inputs
+     * @param results   The array (of size count) to store the judgements
+     */
+    template <Difficulty D>
+    static void judgeAllWith(const Chart& chart, const TempoMap& tempo,
+                             const SongTime* inputs, size_t count, Judgement* results);
+
+#pragma mark -
+#pragma mark Attributes
+    /**
+     * Returns the number of judged inputs since the combo last broke.
+     *
+     * @return the current combo
+     */
+    Uint32 getCombo() const { return _combo; }
+
+    /**
+     * Returns the longest combo since the reset.
+     *
+     * @return the longest combo since the reset
+     */
+    Uint32 getMaxCombo() const { return _maxCombo; }
+
+    /**
+     * Returns the total score since the reset.
+     *
+     * @return the total score since the reset
+     */
+    Uint64 getScore() const { return _score; }
+
+    /**
+     * Returns the number of inputs with the given judgement.
+     *
+     * @param judgement The judgement
+     *
+     * @return the number of inputs with the given judgement
+     */
+    Uint32 getCount(Judgement judgement) const { return _counts[(int)judgement]; }
+};
+
+#endif /* __JUDGEMENT_ENGINE_H__ */
@@ -0,0 +1,115 @@
+//
+//  LatencyMonitor.cpp
+//  Demo
+//
+//  This is the implementation for the LatencyMonitor class.
+//
+#include "LatencyMonitor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+using namespace cugl;
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Removes every sample.
+ */
+void LatencyMonitor::reset() {
+    for (int ii = 0; ii < LATENCY_STAGES; ii++) {
+        Stage& stage = _stages[ii];
+        std::fill(stage.buckets, stage.buckets+LATENCY_BUCKETS, 0);
+        stage.head = 0;
+        stage.size = 0;
+        stage.total = 0;
+    }
+}
+
+#pragma mark -
+#pragma mark Recording
+/**
+ * Records the latency of a stage.
+ */
+void LatencyMonitor::record(LatencyStage stage, Uint64 micros) {
+    Stage& data = _stages[(int)stage];
+    Uint32 sample = (Uint32)std::min<Uint64>(micros, 0xFFFFFFFF);
+    if (data.size == LATENCY_RING) {
+        // The oldest sample leaves the histogram with the ring
+        data.buckets[bucket(data.ring[data.head])]--;
+    } else {
+        data.size++;
+    }
+    data.ring[data.head] = sample;
+    data.buckets[bucket(sample)]++;
+    data.head = (data.head+1) % LATENCY_RING;
+    data.total++;
+}
+
+#pragma mark -
+#pragma mark Statistics
+/**
+ * Returns a percentile of the recent latency of a stage, in milliseconds.
+ */
+float LatencyMonitor::getPercentile(LatencyStage stage, float p) const {
+    const Stage& data = _stages[(int)stage];
+    if (data.size == 0) {
+        return 0;
+    }
+    Uint32 rank = (Uint32)std::ceil(p*data.size);
+    Uint32 seen = 0;
+    for (int ii = 0; ii < LATENCY_BUCKETS; ii++) {
+        seen += data.buckets[ii];
+        if (seen >= std::max<Uint32>(rank, 1)) {
+            return (ii+1)*LATENCY_BUCKET_US/1000.0f;
+        }
+    }
+    return LATENCY_BUCKETS*LATENCY_BUCKET_US/1000.0f;
+}
+
+/**
+ * Returns a one-line summary of a stage for the debug overlay.
+ */
+std::string LatencyMonitor::getSummary(LatencyStage stage) const {
+    char line[96];
+    snprintf(line, sizeof(line), "%-8s p50 %3.0f  p95 %3.0f  p99 %3.0f ms  (%u)",
+             stageName(stage), getPercentile(stage, 0.5f), getPercentile(stage, 0.95f),
+             getPercentile(stage, 0.99f), getCount(stage));
+    return line;
+}
+
+/**
+ * Writes the histogram of every stage to a CSV file.
+ */
+bool LatencyMonitor::dump(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        CULog("Failed to create %s", path.c_str());
+        return false;
+    }
+    out << "stage,bucket_ms,count\n";
+    for (int ii = 0; ii < LATENCY_STAGES; ii++) {
+        const Stage& data = _stages[ii];
+        for (int jj = 0; jj < LATENCY_BUCKETS; jj++) {
+            if (data.buckets[jj] > 0) {
+                out << stageName((LatencyStage)ii) << "," << (jj+1)*LATENCY_BUCKET_US/1000
+                    << "," << data.buckets[jj] << "\n";
+            }
+        }
+    }
+    return out.good();
+}
+
+/**
+ * Returns the name of a stage.
+ */
+const char* LatencyMonitor::stageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::Classify: return "classify";
+        case LatencyStage::Judge:    return "judge";
+        case LatencyStage::Move:     return "move";
+        case LatencyStage::Render:   return "render";
+        default:                     return "sound";
+    }
+}
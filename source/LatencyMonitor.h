@@ -0,0 +1,172 @@
+//
+//  LatencyMonitor.h
+//  Demo
+//
+//  This class measures how long an input takes to reach each stage of the
+//  game, from the touch event to the sound of its feedback. Every stage is
+//  timed from the platform timestamp of the touch, so the stages add up to
+//  the full motion-to-photon and motion-to-sound latency.
+//
+//  Notes:
+//  - Each stage keeps a ring of its most recent samples and a histogram of
+//    that ring, so the memory is fixed and the statistics follow the device
+//  - A sample leaving the ring is removed from the histogram
+//  - Percentiles are read from the histogram, to the bucket width
+//
+#ifndef __LATENCY_MONITOR_H__
+#define __LATENCY_MONITOR_H__
+#include <cugl/cugl.h>
+#include <algorithm>
+#include <string>
+
+/** The number of recent samples kept for each stage */
+#define LATENCY_RING        256
+/** The number of histogram buckets (the last one holds anything slower) */
+#define LATENCY_BUCKETS     64
+/** The width of each histogram bucket in microseconds */
+#define LATENCY_BUCKET_US   4000
+
+/** The stages of an input, in the order it reaches them */
+enum class LatencyStage {
+    /** The gesture was classified */
+    Classify,
+    /** The gesture was judged by the simulation */
+    Judge,
+    /** The player moved because of it */
+    Move,
+    /** The first frame showing the move was drawn */
+    Render,
+    /** The feedback sound was started (plus the output latency) */
+    Sound
+};
+
+/** The number of stages */
+#define LATENCY_STAGES  5
+
+/**
+ * Fixed-memory latency histograms for each stage of the input path.
+ */
+class LatencyMonitor {
+private:
+    /**
+     * The samples of one stage.
+     */
+    struct Stage {
+        /** The most recent samples in microseconds, oldest first from head */
+        Uint32 ring[LATENCY_RING];
+        /** The number of ring samples in each bucket */
+        Uint32 buckets[LATENCY_BUCKETS];
+        /** The next slot of the ring to write */
+        Uint32 head;
+        /** The number of samples in the ring */
+        Uint32 size;
+        /** The number of samples ever recorded */
+        Uint64 total;
+    };
+
+    /** The samples of each stage */
+    Stage _stages[LATENCY_STAGES];
+
+    /** Returns the bucket of a sample */
+    static int bucket(Uint32 micros) {
+        return std::min((int)(micros/LATENCY_BUCKET_US), LATENCY_BUCKETS-1);
+    }
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates a monitor with no samples.
+     */
+    LatencyMonitor() { reset(); }
+
+    /**
+     * Removes every sample.
+     */
+    void reset();
+
+#pragma mark -
+#pragma mark Recording
+    /**
+     * Records the latency of a stage.
+     *
+     * @param stage     The stage reached
+     * @param micros    The time since the touch in microseconds
+     */
+    void record(LatencyStage stage, Uint64 micros);
+
+    /**
+     * Records the latency of a stage.
+     *
+     * @param stage The stage reached
+     * @param touch The timestamp of the touch
+     * @param now   The time the stage was reached
+     */
+    void record(LatencyStage stage, const cugl::Timestamp& touch, const cugl::Timestamp& now) {
+        record(stage, cugl::Timestamp::ellapsedMicros(touch, now));
+    }
+
+#pragma mark -
+#pragma mark Statistics
+    /**
+     * Returns the number of recent samples of a stage.
+     *
+     * @param stage The stage
+     *
+     * @return the number of recent samples of a stage
+     */
+    Uint32 getCount(LatencyStage stage) const { return _stages[(int)stage].size; }
+
+    /**
+     * Returns the number of samples of a stage since the reset.
+     *
+     * @param stage The stage
+     *
+     * @return the number of samples of a stage since the reset
+     */
+    Uint64 getTotal(LatencyStage stage) const { return _stages[(int)stage].total; }
+
+    /**
+     * Returns a percentile of the recent latency of a stage, in milliseconds.
+     *
+     * The result is the upper edge of the bucket holding the percentile. It
+     * is 0 if there are no samples.
+     *
+     * @param stage The stage
+     * @param p     The percentile in [0,1]
+     *
+     * @return a percentile of the recent latency of a stage
+     */
+    float getPercentile(LatencyStage stage, float p) const;
+
+    /**
+     * Returns a one-line summary of a stage for the debug overlay.
+     *
+     * @param stage The stage
+     *
+     * @return a one-line summary of a stage
+     */
+    std::string getSummary(LatencyStage stage) const;
+
+    /**
+     * Writes the histogram of every stage to a CSV file.
+     *
+     * The columns are stage, bucket_ms (the upper edge) and count.
+     *
+     * @param path  The file to write
+     *
+     * @return true if the file was written
+     */
+    bool dump(const std::string& path) const;
+
+    /**
+     * Returns the name of a stage.
+     *
+     * @param stage The stage
+     *
+     * @return the name of a stage
+     */
+    static const char* stageName(LatencyStage stage);
+};
+
+#endif /* __LATENCY_MONITOR_H__ */
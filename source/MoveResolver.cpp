@@ -0,0 +1,111 @@
+//
+//  MoveResolver.cpp
+//  Demo
+//
+//  This is the implementation for the MoveResolver class.
+//
+#include "MoveResolver.h"
+
+using namespace cugl;
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Removes every move, to start a new beat.
+ */
+void MoveResolver::clear() {
+    _moves.clear();
+    _occupants.clear();
+    _claims.clear();
+    _blocked.clear();
+}
+
+#pragma mark -
+#pragma mark Moves
+/**
+ * Adds the move of an entity from one cell to another.
+ */
+size_t MoveResolver::add(int entity, int from, int to) {
+    _moves.push_back({entity, from, from == -1 ? -1 : to, false});
+    return _moves.size()-1;
+}
+
+/**
+ * Adds the move of an entity one tile in the given direction.
+ */
+size_t MoveResolver::add(int entity, int from, Direction dir, const TileGrid& grid) {
+    return add(entity, from, from == -1 ? -1 : grid.neighbor(from, dir));
+}
+
+/**
+ * Blocks a move, and queues it so that moves into its cell are blocked.
+ */
+void MoveResolver::block(int index) {
+    _moves[index].moved = false;
+    _blocked.push_back(index);
+}
+
+/**
+ * Decides which of the moves are allowed.
+ */
+void MoveResolver::resolve(const TileGrid& grid) {
+    _occupants.clear();
+    _claims.clear();
+    _blocked.clear();
+
+    // Claim the target cells; the lowest entity id wins, whatever the order
+    for (int ii = 0; ii < (int)_moves.size(); ii++) {
+        Move& move = _moves[ii];
+        move.moved = false;
+        if (move.from == -1) {
+            continue;
+        }
+        auto occupant = _occupants.emplace(move.from, ii);
+        if (!occupant.second) {
+            // Entities that start in the same cell (a bad level) stay put
+            occupant.first->second = -1;
+        }
+        if (move.to == -1 || move.to == move.from || !grid.isWalkable((size_t)move.to)) {
+            continue;
+        }
+        auto claim = _claims.emplace(move.to, ii);
+        if (!claim.second && move.entity < _moves[claim.first->second].entity) {
+            claim.first->second = ii;
+        }
+    }
+    for (int ii = 0; ii < (int)_moves.size(); ii++) {
+        auto claim = _moves[ii].to == -1 ? _claims.end() : _claims.find(_moves[ii].to);
+        _moves[ii].moved = claim != _claims.end() && claim->second == ii && _occupants[_moves[ii].from] != -1;
+    }
+
+    // Two entities may not walk through each other
+    for (int ii = 0; ii < (int)_moves.size(); ii++) {
+        const Move& move = _moves[ii];
+        if (!move.moved) {
+            _blocked.push_back(ii);
+            continue;
+        }
+        auto occupant = _occupants.find(move.to);
+        if (occupant != _occupants.end() && occupant->second != -1) {
+            const Move& other = _moves[occupant->second];
+            if (other.moved && other.to == move.from) {
+                block(ii);
+                block(occupant->second);
+            }
+        }
+    }
+
+    // Whoever stays put blocks the move into its cell, and so on down the line
+    while (!_blocked.empty()) {
+        int index = _blocked.back();
+        _blocked.pop_back();
+        int cell = _moves[index].from;
+        if (cell == -1) {
+            continue;
+        }
+        auto claim = _claims.find(cell);
+        if (claim != _claims.end() && _moves[claim->second].moved) {
+            block(claim->second);
+        }
+    }
+}
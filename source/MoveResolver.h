@@ -0,0 +1,146 @@
+//
+//  MoveResolver.h
+//  Demo
+//
+//  This class resolves all of the moves made on one beat as a single batch.
+//  Every entity first states where it wants to go, and only then does the
+//  resolver decide who actually moves. So the result does not depend on the
+//  order the entities were updated in, and no two entities end up in the
+//  same cell.
+//
+//  Notes:
+//  - Two entities that want the same cell: the lowest entity id wins
+//  - Two entities that want to swap cells: neither moves
+//  - An entity that wants a cell whose occupant stays put does not move
+//    (this is followed down chains, so a blocked line stays in place)
+//  - Rotations of three or more entities all move
+//  - Entities that start in the same cell do not move
+//  - Resolution is linear in the number of moves; the cells are kept in
+//    hash maps, so a large map costs nothing extra
+//
+#ifndef __MOVE_RESOLVER_H__
+#define __MOVE_RESOLVER_H__
+#include <cugl/cugl.h>
+#include <unordered_map>
+#include <vector>
+#include "Direction.h"
+#include "TileGrid.h"
+
+/**
+ * A per-beat batch of moves.
+ */
+class MoveResolver {
+public:
+    /** One intended move */
+    struct Move {
+        /** The entity making the move (players by player id) */
+        int entity;
+        /** The cell the entity starts in */
+        int from;
+        /** The cell the entity wants to go to (from if it stays) */
+        int to;
+        /** Whether the move was allowed, after resolve */
+        bool moved;
+    };
+
+private:
+    /** The moves this beat, in the order they were added */
+    std::vector<Move> _moves;
+    /** The move of the entity starting in each cell (-1 if there are several) */
+    std::unordered_map<int, int> _occupants;
+    /** The move that won each target cell */
+    std::unordered_map<int, int> _claims;
+    /** The blocked moves whose cells are not yet checked */
+    std::vector<int> _blocked;
+
+    /**
+     * Blocks a move, and queues it so that moves into its cell are blocked.
+     *
+     * @param index The move index
+     */
+    void block(int index);
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates an empty batch.
+     */
+    MoveResolver() {}
+
+    /**
+     * Removes every move, to start a new beat.
+     *
+     * The hash maps keep their buckets, so this does not allocate.
+     */
+    void clear();
+
+#pragma mark -
+#pragma mark Moves
+    /**
+     * Adds the move of an entity from one cell to another.
+     *
+     * An entity that is not moving should still be added (with to equal to
+     * from), as it blocks the cell it is in. An entity that is off the map
+     * (from is -1) never moves.
+     *
+     * @param entity    The entity id
+     * @param from      The cell the entity is in
+     * @param to        The cell the entity wants to go to
+     *
+     * @return the index of the move
+     */
+    size_t add(int entity, int from, int to);
+
+    /**
+     * Adds the move of an entity one tile in the given direction.
+     *
+     * @param entity    The entity id
+     * @param from      The cell the entity is in
+     * @param dir       The direction of the move (None to stay)
+     * @param grid      The tile map
+     *
+     * @return the index of the move
+     */
+    size_t add(int entity, int from, Direction dir, const TileGrid& grid);
+
+    /**
+     * Decides which of the moves are allowed.
+     *
+     * A move into a cell that is not walkable is never allowed.
+     *
+     * @param grid  The tile map
+     */
+    void resolve(const TileGrid& grid);
+
+#pragma mark -
+#pragma mark Results
+    /**
+     * Returns the number of moves.
+     *
+     * @return the number of moves
+     */
+    size_t size() const { return _moves.size(); }
+
+    /**
+     * Returns a move.
+     *
+     * @param index The move index
+     *
+     * @return a move
+     */
+    const Move& get(size_t index) const { return _moves[index]; }
+
+    /**
+     * Returns true if the move was allowed.
+     *
+     * This is only meaningful after a call to resolve.
+     *
+     * @param index The move index
+     *
+     * @return true if the move was allowed
+     */
+    bool didMove(size_t index) const { return _moves[index].moved; }
+};
+
+#endif /* __MOVE_RESOLVER_H__ */
@@ -0,0 +1,105 @@
+//
+//  NavigationController.cpp
+//  Demo
+//
+//  This is the implementation for the NavigationController class.
+//
+#include "NavigationController.h"
+
+using namespace cugl;
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Initializes the controller for a map.
+ */
+bool NavigationController::init(const TileGrid& grid, bool tables) {
+    _grid = &grid;
+    clear();
+    _useTable = tables && _table.init(grid);
+    return true;
+}
+
+/**
+ * Drops every cached field.
+ */
+void NavigationController::clear() {
+    _fields.clear();
+    _used.clear();
+    _byTarget.clear();
+    _queries = 0;
+}
+
+/**
+ * Returns the flow field toward a target, building it if necessary.
+ */
+const FlowField& NavigationController::field(int target) {
+    _queries++;
+    auto cached = _byTarget.find(target);
+    if (cached != _byTarget.end()) {
+        int index = cached->second;
+        _used[index] = _queries;
+        // This only rebuilds if the walls changed
+        if (_fields[index].setTarget(*_grid, target)) {
+            _rebuilds++;
+        }
+        return _fields[index];
+    }
+
+    // A new target takes a new field, or the one unused for longest
+    int index;
+    if (_fields.size() < NAV_MAX_FIELDS) {
+        index = (int)_fields.size();
+        _fields.emplace_back();
+        _used.push_back(0);
+    } else {
+        index = 0;
+        for (int ii = 1; ii < (int)_used.size(); ii++) {
+            if (_used[ii] < _used[index]) {
+                index = ii;
+            }
+        }
+        _byTarget.erase(_fields[index].getTarget());
+    }
+    _byTarget[target] = index;
+    _used[index] = _queries;
+    _fields[index].setTarget(*_grid, target);
+    _rebuilds++;
+    return _fields[index];
+}
+
+#pragma mark -
+#pragma mark Steering
+/**
+ * Returns the first step on a shortest path between two cells.
+ */
+Direction NavigationController::steer(int from, int to) {
+    if (_grid == nullptr || from < 0 || to < 0 || from == to) {
+        return Direction::None;
+    }
+    if (_useTable) {
+        if (!_table.isCurrent(*_grid)) {
+            _table.init(*_grid);
+        }
+        return _table.getStep(*_grid, from, to);
+    }
+    return field(to).getStep(from);
+}
+
+/**
+ * Returns the number of steps between two cells, or -1 if there is no path.
+ */
+int NavigationController::getDistance(int from, int to) {
+    if (_grid == nullptr || from < 0 || to < 0) {
+        return -1;
+    }
+    if (_useTable) {
+        if (!_table.isCurrent(*_grid)) {
+            _table.init(*_grid);
+        }
+        int distance = _table.getDistance(from, to);
+        return distance == TABLE_UNREACHABLE ? -1 : distance;
+    }
+    Uint32 distance = field(to).getDistance(from);
+    return distance == FLOW_UNREACHABLE ? -1 : (int)distance;
+}
@@ -0,0 +1,129 @@
+//
+//  NavigationController.h
+//  Demo
+//
+//  This class steers guards over the tile grid. A guard asks for the first
+//  step from its cell toward a target cell, and gets it from a cached flow
+//  field toward that target, so steering is a lookup rather than a search.
+//  Guards chasing the same player, or patrolling to the same waypoint,
+//  share one field.
+//
+//  Notes:
+//  - Up to NAV_MAX_FIELDS targets are cached; the least recently used
+//    field is reused for a new target, so a field is only recomputed when
+//    the target it serves changes
+//  - A small map can use a distance table instead, which answers for every
+//    target and never recomputes while the walls stay the same
+//  - Wall changes are picked up from the grid revision on the next query
+//
+#ifndef __NAVIGATION_CONTROLLER_H__
+#define __NAVIGATION_CONTROLLER_H__
+#include <cugl/cugl.h>
+#include <unordered_map>
+#include <vector>
+#include "Direction.h"
+#include "TileGrid.h"
+#include "FlowField.h"
+#include "DistanceTable.h"
+
+/** The number of flow fields kept at once */
+#define NAV_MAX_FIELDS  16
+
+/**
+ * The guard steering controller.
+ */
+class NavigationController {
+private:
+    /** The tile map */
+    const TileGrid* _grid;
+    /** Whether to use the distance table */
+    bool _useTable;
+    /** The distance table (if the map is small enough) */
+    DistanceTable _table;
+    /** The cached flow fields */
+    std::vector<FlowField> _fields;
+    /** When each field was last used */
+    std::vector<Uint64> _used;
+    /** The field of each cached target */
+    std::unordered_map<int, int> _byTarget;
+    /** The number of queries so far (the clock for _used) */
+    Uint64 _queries;
+    /** The number of field rebuilds so far */
+    Uint64 _rebuilds;
+
+    /**
+     * Returns the flow field toward a target, building it if necessary.
+     *
+     * @param target    The target cell
+     *
+     * @return the flow field toward a target
+     */
+    const FlowField& field(int target);
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates a controller with no map.
+     */
+    NavigationController() : _grid(nullptr), _useTable(false), _queries(0), _rebuilds(0) {}
+
+    /**
+     * Initializes the controller for a map.
+     *
+     * If tables is true and the map has at most NAV_TABLE_CELLS cells, the
+     * controller answers from a distance table. Otherwise it uses flow
+     * fields.
+     *
+     * @param grid      The tile map (which must outlive the controller)
+     * @param tables    Whether to use a distance table on small maps
+     *
+     * @return true if initialization was successful
+     */
+    bool init(const TileGrid& grid, bool tables);
+
+    /**
+     * Drops every cached field.
+     */
+    void clear();
+
+#pragma mark -
+#pragma mark Steering
+    /**
+     * Returns the first step on a shortest path between two cells.
+     *
+     * This is None if the cells are the same, or cannot reach each other.
+     *
+     * @param from  The start cell
+     * @param to    The target cell
+     *
+     * @return the first step on a shortest path
+     */
+    Direction steer(int from, int to);
+
+    /**
+     * Returns the number of steps between two cells, or -1 if there is no path.
+     *
+     * @param from  The start cell
+     * @param to    The target cell
+     *
+     * @return the number of steps between two cells
+     */
+    int getDistance(int from, int to);
+
+    /**
+     * Returns true if the controller uses a distance table.
+     *
+     * @return true if the controller uses a distance table
+     */
+    bool usesTable() const { return _useTable; }
+
+    /**
+     * Returns the number of flow field rebuilds so far.
+     *
+     * @return the number of flow field rebuilds so far
+     */
+    Uint64 getRebuilds() const { return _rebuilds; }
+};
+
+#endif /* __NAVIGATION_CONTROLLER_H__ */
@@ -0,0 +1,134 @@
+//
+//  NoiseField.cpp
+//  Demo
+//
+//  This is the implementation for the NoiseField class.
+//
+#include "NoiseField.h"
+#include <algorithm>
+
+using namespace cugl;
+
+/** The directions a noise spreads in */
+static const Direction SPREAD_ORDER[] = {
+    Direction::Up, Direction::Down, Direction::Left, Direction::Right
+};
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Initializes a silent field for a map.
+ */
+bool NoiseField::init(const TileGrid& grid, float decay, int wallCost, size_t budget) {
+    if (decay < 0.0f || decay >= 1.0f || wallCost < 0) {
+        return false;
+    }
+    _grid = &grid;
+    _wallCost = wallCost;
+    _budget = std::max(budget, area(NOISE_MAX_LOUDNESS));
+    _fade.resize(NOISE_MAX_AGE);
+    _fade[0] = 1.0f;
+    for (int ii = 1; ii < NOISE_MAX_AGE; ii++) {
+        _fade[ii] = _fade[ii-1]*decay;
+    }
+    _buckets.resize(NOISE_MAX_LOUDNESS);
+    clear();
+    return true;
+}
+
+/**
+ * Silences the field and drops every waiting noise.
+ */
+void NoiseField::clear() {
+    size_t cells = _grid == nullptr ? 0 : _grid->size();
+    _levels.assign(cells, 0.0f);
+    _stamps.assign(cells, 0);
+    _origins.assign(cells, -1);
+    _costs.assign(cells, 0);
+    _visits.assign(cells, 0);
+    _pending.clear();
+    _beat = 0;
+    _search = 0;
+    _spent = 0;
+}
+
+#pragma mark -
+#pragma mark Updates
+/**
+ * Makes a noise, to be spread on the next beat.
+ */
+void NoiseField::emit(int cell, int loudness) {
+    if (loudness <= 0 || (unsigned)cell >= (unsigned)_levels.size() || _pending.size() >= NOISE_MAX_PENDING) {
+        return;
+    }
+    _pending.push_back({cell, std::min(loudness, NOISE_MAX_LOUDNESS)});
+}
+
+/**
+ * Advances the field one beat.
+ */
+size_t NoiseField::step() {
+    // Fading is lazy: moving the beat on is enough
+    _beat++;
+    _spent = 0;
+
+    size_t done = 0;
+    while (done < _pending.size() && _spent+area(_pending[done].loudness) <= _budget) {
+        spread(_pending[done]);
+        done++;
+    }
+    _pending.erase(_pending.begin(), _pending.begin()+done);
+    return _spent;
+}
+
+/**
+ * Spreads one noise over the cells it reaches.
+ */
+void NoiseField::spread(const Source& source) {
+    // Costs are small integers, so the search keeps a bucket per cost
+    if (++_search == 0) {
+        std::fill(_visits.begin(), _visits.end(), 0);
+        _search = 1;
+    }
+    for (auto& bucket : _buckets) {
+        bucket.clear();
+    }
+    _costs[source.cell] = 0;
+    _visits[source.cell] = _search;
+    _buckets[0].push_back(source.cell);
+
+    for (int cost = 0; cost < source.loudness; cost++) {
+        std::vector<int>& bucket = _buckets[cost];
+        for (size_t ii = 0; ii < bucket.size(); ii++) {
+            int cell = bucket[ii];
+            if (_costs[cell] != cost) {
+                // Reached more cheaply since it was queued
+                continue;
+            }
+
+            // Add to whatever is still ringing in this cell
+            float level = getLevel(cell);
+            float heard = (float)(source.loudness-cost);
+            if (heard >= level) {
+                _origins[cell] = source.cell;
+            }
+            _levels[cell] = level+heard;
+            _stamps[cell] = _beat;
+            _spent++;
+
+            for (Direction dir : SPREAD_ORDER) {
+                int next = _grid->neighbor(cell, dir);
+                if (next == -1) {
+                    continue;
+                }
+                int total = cost+1+(_grid->isWalkable((size_t)next) ? 0 : _wallCost);
+                if (total >= source.loudness || (_visits[next] == _search && _costs[next] <= total)) {
+                    continue;
+                }
+                _visits[next] = _search;
+                _costs[next] = total;
+                _buckets[total].push_back(next);
+            }
+        }
+    }
+}
@@ -0,0 +1,188 @@
+//
+//  NoiseField.h
+//  Demo
+//
+//  This class is the noise level of every cell of the tile grid. A noise
+//  (a footstep, a dropped valuable, a failed minigame) spreads out from its
+//  cell with a bounded breadth-first search, losing one unit per tile and
+//  more through walls, and adds to what is already there. The whole field
+//  fades every beat.
+//
+//  Notes:
+//  - Only the cells a new noise reaches are written; the fading is applied
+//    lazily when a cell is read or written, so a beat costs nothing for the
+//    rest of the map
+//  - Noises are spread on the beat, within a fixed budget of cells per
+//    beat; a noise that does not fit waits for the next beat, so the cost
+//    of a beat is bounded however many noises there are
+//  - The budget is counted in cells rather than time, so a replay hears
+//    exactly what the original session heard
+//  - Every cell also remembers the source that was loudest there, which is
+//    where a guard that hears it should go
+//
+#ifndef __NOISE_FIELD_H__
+#define __NOISE_FIELD_H__
+#include <cugl/cugl.h>
+#include <vector>
+#include "TileGrid.h"
+
+/** The loudest noise (in tiles of reach) that can be emitted */
+#define NOISE_MAX_LOUDNESS  16
+/** The number of beats after which a noise has faded out entirely */
+#define NOISE_MAX_AGE       64
+/** The most noises that can wait to be spread (more are not heard) */
+#define NOISE_MAX_PENDING   256
+
+/**
+ * The per-cell noise levels of a level.
+ */
+class NoiseField {
+private:
+    /** A noise that has not been spread yet */
+    struct Source {
+        /** The cell of the noise */
+        int cell;
+        /** How far the noise reaches, in tiles */
+        int loudness;
+    };
+
+    /** The tile map */
+    const TileGrid* _grid;
+    /** The noise level of each cell, as of the beat in _stamps */
+    std::vector<float> _levels;
+    /** The beat each cell was last written */
+    std::vector<Uint32> _stamps;
+    /** The loudest source heard in each cell, or -1 */
+    std::vector<int> _origins;
+    /** The fraction of a noise left after each beat, raised to each age */
+    std::vector<float> _fade;
+    /** The extra cost of spreading into a wall */
+    int _wallCost;
+    /** The number of cells that can be written each beat */
+    size_t _budget;
+    /** The current beat */
+    Uint32 _beat;
+    /** The noises waiting to be spread */
+    std::vector<Source> _pending;
+    /** The cost of the current search in each cell */
+    std::vector<int> _costs;
+    /** The search that last wrote each entry of _costs */
+    std::vector<Uint32> _visits;
+    /** The current search */
+    Uint32 _search;
+    /** The cells of the current search, bucketed by cost */
+    std::vector<std::vector<int>> _buckets;
+    /** The number of cells written this beat */
+    size_t _spent;
+
+    /**
+     * Returns the most cells one noise can write.
+     *
+     * @param loudness  The loudness of the noise
+     *
+     * @return the most cells one noise can write
+     */
+    static size_t area(int loudness) { return (size_t)2*loudness*loudness+2*loudness+1; }
+
+    /**
+     * Spreads one noise over the cells it reaches.
+     *
+     * @param source    The noise
+     */
+    void spread(const Source& source);
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates a field with no map.
+     */
+    NoiseField() : _grid(nullptr), _wallCost(0), _budget(0), _beat(0), _search(0), _spent(0) {}
+
+    /**
+     * Initializes a silent field for a map.
+     *
+     * A noise loses one unit of loudness for every tile it spreads, and
+     * wallCost more for a wall. The budget is raised if needed, so that
+     * the loudest noise always fits in one beat.
+     *
+     * @param grid      The tile map (which must outlive the field)
+     * @param decay     The fraction of a noise left after each beat
+     * @param wallCost  The extra cost of spreading into a wall
+     * @param budget    The number of cells that can be written each beat
+     *
+     * @return true if initialization was successful
+     */
+    bool init(const TileGrid& grid, float decay, int wallCost, size_t budget);
+
+    /**
+     * Silences the field and drops every waiting noise.
+     */
+    void clear();
+
+#pragma mark -
+#pragma mark Updates
+    /**
+     * Makes a noise, to be spread on the next beat.
+     *
+     * The noise is lost if NOISE_MAX_PENDING noises are already waiting.
+     *
+     * @param cell      The cell of the noise
+     * @param loudness  How far the noise reaches, in tiles
+     */
+    void emit(int cell, int loudness);
+
+    /**
+     * Advances the field one beat.
+     *
+     * Everything heard so far fades, and then the waiting noises are
+     * spread, oldest first, until the budget for the beat is used.
+     *
+     * @return the number of cells written this beat
+     */
+    size_t step();
+
+#pragma mark -
+#pragma mark Queries
+    /**
+     * Returns the noise level of a cell.
+     *
+     * @param cell  The cell index
+     *
+     * @return the noise level of a cell
+     */
+    float getLevel(int cell) const {
+        if ((unsigned)cell >= (unsigned)_levels.size()) {
+            return 0.0f;
+        }
+        Uint32 age = _beat-_stamps[cell];
+        return age < NOISE_MAX_AGE ? _levels[cell]*_fade[age] : 0.0f;
+    }
+
+    /**
+     * Returns the cell of the loudest noise heard in a cell, or -1.
+     *
+     * @param cell  The cell index
+     *
+     * @return the cell of the loudest noise heard in a cell
+     */
+    int getOrigin(int cell) const {
+        return getLevel(cell) > 0.0f ? _origins[cell] : -1;
+    }
+
+    /**
+     * Returns the number of noises waiting to be spread.
+     *
+     * @return the number of noises waiting to be spread
+     */
+    size_t getPending() const { return _pending.size(); }
+
+    /**
+     * Returns the number of cells that can be written each beat.
+     *
+     * @return the number of cells that can be written each beat
+     */
+    size_t getBudget() const { return _budget; }
+};
+
+#endif /* __NOISE_FIELD_H__ */
@@ -0,0 +1,89 @@
+//
+//  OccupancyIndex.cpp
+//  Demo
+//
+//  This is the implementation for the OccupancyIndex class.
+//
+#include "OccupancyIndex.h"
+#include <algorithm>
+
+using namespace cugl;
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Initializes an empty index for the given number of cells.
+ */
+bool OccupancyIndex::init(size_t cells) {
+    _heads.assign(cells, -1);
+    _counts.assign(cells, 0);
+    _next.clear();
+    _prev.clear();
+    _cells.clear();
+    return true;
+}
+
+/**
+ * Removes every entity, keeping the cells.
+ */
+void OccupancyIndex::clear() {
+    std::fill(_heads.begin(), _heads.end(), -1);
+    std::fill(_counts.begin(), _counts.end(), 0);
+    _next.clear();
+    _prev.clear();
+    _cells.clear();
+}
+
+#pragma mark -
+#pragma mark Updates
+/**
+ * Places an entity in a cell, moving it if it was in another.
+ */
+void OccupancyIndex::place(int entity, int cell) {
+    if (entity < 0) {
+        return;
+    } else if (entity >= (int)_cells.size()) {
+        _next.resize(entity+1, -1);
+        _prev.resize(entity+1, -1);
+        _cells.resize(entity+1, -1);
+    }
+    if (_cells[entity] == cell) {
+        return;
+    }
+    remove(entity);
+    if (cell < 0 || cell >= (int)_heads.size()) {
+        return;
+    }
+
+    // Push on the front of the cell's list
+    _next[entity] = _heads[cell];
+    _prev[entity] = -1;
+    if (_heads[cell] != -1) {
+        _prev[_heads[cell]] = entity;
+    }
+    _heads[cell] = entity;
+    _counts[cell]++;
+    _cells[entity] = cell;
+}
+
+/**
+ * Removes an entity from its cell, if it has one.
+ */
+void OccupancyIndex::remove(int entity) {
+    int cell = getCell(entity);
+    if (cell == -1) {
+        return;
+    }
+    if (_prev[entity] != -1) {
+        _next[_prev[entity]] = _next[entity];
+    } else {
+        _heads[cell] = _next[entity];
+    }
+    if (_next[entity] != -1) {
+        _prev[_next[entity]] = _prev[entity];
+    }
+    _next[entity] = -1;
+    _prev[entity] = -1;
+    _counts[cell]--;
+    _cells[entity] = -1;
+}
@@ -0,0 +1,136 @@
+//
+//  OccupancyIndex.h
+//  Demo
+//
+//  This class records which entities are in which cell of the tile grid.
+//  Each cell holds an intrusive doubly-linked list of entity ids, so
+//  placing, moving and removing an entity are all O(1), and so is asking
+//  what is in a cell. The index is kept up to date by the code that moves
+//  entities, instead of being rebuilt by scanning them.
+//
+//  Notes:
+//  - Entities are small integer ids (an index into their owner's array)
+//  - An entity is in at most one cell; an entity that is not placed (for
+//    example a carried valuable) is in none
+//  - The lists hold no order guarantee beyond "most recently placed first"
+//
+#ifndef __OCCUPANCY_INDEX_H__
+#define __OCCUPANCY_INDEX_H__
+#include <cugl/cugl.h>
+#include <vector>
+
+/**
+ * A per-cell index of entity ids.
+ */
+class OccupancyIndex {
+private:
+    /** The first entity in each cell, or -1 */
+    std::vector<int> _heads;
+    /** The number of entities in each cell */
+    std::vector<Uint16> _counts;
+    /** The next entity in the same cell, or -1 */
+    std::vector<int> _next;
+    /** The previous entity in the same cell, or -1 */
+    std::vector<int> _prev;
+    /** The cell of each entity, or -1 */
+    std::vector<int> _cells;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates an empty index with no cells.
+     */
+    OccupancyIndex() {}
+
+    /**
+     * Initializes an empty index for the given number of cells.
+     *
+     * @param cells The number of cells in the grid
+     *
+     * @return true if initialization was successful
+     */
+    bool init(size_t cells);
+
+    /**
+     * Removes every entity, keeping the cells.
+     */
+    void clear();
+
+#pragma mark -
+#pragma mark Updates
+    /**
+     * Places an entity in a cell, moving it if it was in another.
+     *
+     * A cell of -1 removes the entity.
+     *
+     * @param entity    The entity id
+     * @param cell      The cell index, or -1
+     */
+    void place(int entity, int cell);
+
+    /**
+     * Removes an entity from its cell, if it has one.
+     *
+     * @param entity    The entity id
+     */
+    void remove(int entity);
+
+#pragma mark -
+#pragma mark Queries
+    /**
+     * Returns the cell of an entity, or -1 if it is not placed.
+     *
+     * @param entity    The entity id
+     *
+     * @return the cell of an entity
+     */
+    int getCell(int entity) const {
+        return entity >= 0 && entity < (int)_cells.size() ? _cells[entity] : -1;
+    }
+
+    /**
+     * Returns the first entity in a cell, or -1 if it is empty.
+     *
+     * @param cell  The cell index
+     *
+     * @return the first entity in a cell
+     */
+    int first(int cell) const { return _heads[cell]; }
+
+    /**
+     * Returns the next entity in the same cell, or -1 if there is none.
+     *
+     * @param entity    An entity returned by first or next
+     *
+     * @return the next entity in the same cell
+     */
+    int next(int entity) const { return _next[entity]; }
+
+    /**
+     * Returns the number of entities in a cell.
+     *
+     * @param cell  The cell index
+     *
+     * @return the number of entities in a cell
+     */
+    int count(int cell) const { return _counts[cell]; }
+
+    /**
+     * Returns true if a cell has no entities.
+     *
+     * @param cell  The cell index
+     *
+     * @return true if a cell has no entities
+     */
+    bool isEmpty(int cell) const { return _heads[cell] == -1; }
+
+    /**
+     * Returns the number of cells.
+     *
+     * @return the number of cells
+     */
+    size_t size() const { return _heads.size(); }
+};
+
+#endif /* __OCCUPANCY_INDEX_H__ */
@@ -0,0 +1,81 @@
+//
+//  OffsetEstimator.cpp
+//  Demo
+//
+//  This is the implementation for the OffsetEstimator class.
+//
+#include "OffsetEstimator.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace cugl;
+
+/** Samples further than this many MADs from the median are outliers */
+#define OUTLIER_MADS    5.0
+/** The smallest spread in milliseconds, so the steps never vanish */
+#define MIN_MAD         2.0
+/**
+ * The step gains for normally distributed errors. The best stochastic
+ * approximation step is 1/(n*f), where f is the density at the estimate:
+ * sqrt(2pi)*sigma for the median and 1.573*sigma for the MAD, with
+ * sigma = 1.4826*MAD.
+ */
+#define MEDIAN_GAIN     3.716
+#define MAD_GAIN        2.333
+/** The sample count at which the steps stop shrinking, so the estimate can still drift */
+#define MAX_GAIN_COUNT  64
+
+/**
+ * Returns the median of a small array, reordering it.
+ */
+static double smallMedian(double* values, int count) {
+    std::sort(values, values+count);
+    return count % 2 ? values[count/2] : (values[count/2-1]+values[count/2])/2;
+}
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Removes all samples from this estimator.
+ */
+void OffsetEstimator::reset() {
+    _count = 0;
+    _rejected = 0;
+    _median = 0;
+    _mad = MIN_MAD;
+}
+
+#pragma mark -
+#pragma mark Samples
+/**
+ * Adds a timing error to the estimate.
+ */
+bool OffsetEstimator::addSample(SongTime error) {
+    double x = error.toMillis();
+    if (_count < ESTIMATOR_SEED) {
+        // Exact median and MAD of the seed
+        _seed[_count++] = x;
+        double values[ESTIMATOR_SEED];
+        std::copy(_seed, _seed+_count, values);
+        _median = smallMedian(values, _count);
+        for (int ii = 0; ii < _count; ii++) {
+            values[ii] = std::abs(_seed[ii]-_median);
+        }
+        _mad = std::max(smallMedian(values, _count), MIN_MAD);
+        return true;
+    }
+
+    double deviation = std::abs(x-_median);
+    double rate = 1.0/std::min(_count+1, MAX_GAIN_COUNT);
+    // The spread still grows on outliers, so a real change is not locked out
+    _mad += rate*MAD_GAIN*_mad*(deviation > _mad ? 1 : -1);
+    _mad = std::max(_mad, MIN_MAD);
+    if (deviation > OUTLIER_MADS*_mad) {
+        _rejected++;
+        return false;
+    }
+
+    _count++;
+    _median += rate*MEDIAN_GAIN*_mad*(x > _median ? 1 : (x < _median ? -1 : 0));
+    return true;
+}
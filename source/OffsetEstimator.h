@@ -0,0 +1,104 @@
+//
+//  OffsetEstimator.h
+//  Demo
+//
+//  This class estimates the typical timing error of the player's taps while
+//  they are being made. It keeps a running median and median absolute
+//  deviation (MAD), which ignore the occasional missed or doubled tap in a
+//  way that a mean and variance cannot.
+//
+//  Notes:
+//  - The first few taps are kept to seed the estimate with an exact median
+//  - After that, each tap nudges the estimates by a stochastic approximation
+//    step, so there is no sample history and every tap is O(1)
+//  - Taps far from the median (in units of MAD) are rejected as outliers
+//
+#ifndef __OFFSET_ESTIMATOR_H__
+#define __OFFSET_ESTIMATOR_H__
+#include <cugl/cugl.h>
+#include "SongTime.h"
+
+/** The number of taps used to seed the estimate */
+#define ESTIMATOR_SEED  5
+
+/**
+ * A streaming, outlier-robust estimator of a timing offset.
+ */
+class OffsetEstimator {
+private:
+    /** The seed samples in milliseconds */
+    double _seed[ESTIMATOR_SEED];
+    /** The number of samples accepted so far */
+    int _count;
+    /** The number of samples rejected as outliers */
+    int _rejected;
+    /** The running median in milliseconds */
+    double _median;
+    /** The running median absolute deviation in milliseconds */
+    double _mad;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates an estimator with no samples.
+     */
+    OffsetEstimator() { reset(); }
+
+    /**
+     * Removes all samples from this estimator.
+     */
+    void reset();
+
+#pragma mark -
+#pragma mark Samples
+    /**
+     * Adds a timing error to the estimate.
+     *
+     * Positive errors are late. The sample is ignored if it is an outlier.
+     *
+     * @param error The timing error of a tap
+     *
+     * @return true if the sample was accepted
+     */
+    bool addSample(SongTime error);
+
+    /**
+     * Returns the number of samples accepted so far.
+     *
+     * @return the number of samples accepted so far
+     */
+    int getCount() const { return _count; }
+
+    /**
+     * Returns the number of samples rejected as outliers.
+     *
+     * @return the number of samples rejected as outliers
+     */
+    int getRejected() const { return _rejected; }
+
+    /**
+     * Returns true if there are enough samples for an estimate.
+     *
+     * @return true if there are enough samples for an estimate
+     */
+    bool isReady() const { return _count >= ESTIMATOR_SEED; }
+
+#pragma mark -
+#pragma mark Estimates
+    /**
+     * Returns the estimated offset (the median error).
+     *
+     * @return the estimated offset
+     */
+    SongTime getOffset() const { return SongTime::fromMillis(_median); }
+
+    /**
+     * Returns the spread of the errors (the median absolute deviation).
+     *
+     * @return the spread of the errors
+     */
+    SongTime getSpread() const { return SongTime::fromMillis(_mad); }
+};
+
+#endif /* __OFFSET_ESTIMATOR_H__ */
@@ -23,6 +23,7 @@ int Player::_playerID = -1;
  */
 Player::Player(const Vec2& pos) :
     _pos(pos),
+    _prevPos(pos),
     _start(pos),
     _target(pos),
     _ID(++_playerID),
@@ -81,6 +82,7 @@ bool Player::init(const Vec2& pos, const std::shared_ptr<Texture>& texture) {
  */
 void Player::setPosition(const Vec2& value) {
     _pos = value;
+    _prevPos = value;
     _start = value;
     _target = value;
     _moving = false;
@@ -164,7 +166,7 @@ void Player::update(float dt) {
     }
 }
 
-void Player::move(Direction dir, float gridSize, int nRow, int nCol){
+void Player::move(Direction dir, const TileGrid& grid){
     cugl::Vec2 step = Vec2(0,0);
     switch (dir) {
         case Direction::Up:{
@@ -186,12 +188,9 @@ void Player::move(Direction dir, float gridSize, int nRow, int nCol){
         default:
             break;
     }
-    float rightEdge = nCol*gridSize;
-    float topEdge = nRow*gridSize;
-    cugl::Vec2 next = _pos+step*gridSize;
+    cugl::Vec2 next = _pos+step*grid.getTileSize();
 
-    if (next.x < 0 || next.x >= rightEdge ||
-            next.y < 0 || next.y >= topEdge) {
+    if (!grid.isWalkable(grid.toRow(next), grid.toCol(next))) {
             return;   // block movement
         }
     _pos = next;
@@ -204,10 +203,10 @@ void Player::move(Direction dir, float gridSize, int nRow, int nCol){
 /**
  * Draws this player to the sprite batch.
  */
-void Player::draw(const std::shared_ptr<graphics::SpriteBatch>& batch) {
+void Player::draw(const std::shared_ptr<graphics::SpriteBatch>& batch, float alpha) {
     if (_texture != nullptr && batch != nullptr &&!_isCarrying) {
         float scale = getScale();
-        Vec2 pos = getPosition();
+        Vec2 pos = getRenderPosition(alpha);
         // Vec2 origin(_radius,_radius);
         Vec2 origin(_width, _height);
         
@@ -217,7 +216,7 @@ void Player::draw(const std::shared_ptr<graphics::SpriteBatch>& batch) {
 
         batch->draw(_texture, origin, trans);
     }else if (_carry!=nullptr && batch!=nullptr && _isCarrying){
-        Vec2 pos = getPosition();
+        Vec2 pos = getRenderPosition(alpha);
         Vec2 origin(_carry->getSize().width/2.0f, _carry->getSize().height/2.0f);
         
         Affine2 trans;
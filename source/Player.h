@@ -15,6 +15,8 @@
 #define __PLAYER_H__
 #include <cugl/cugl.h>
 #include "Direction.h"
+#include "TileGrid.h"
+#include "ValuableSet.h"
 
 /**
  * Class representing a player in a grid-based game.
@@ -34,6 +36,9 @@ private:
     /** Current rendered position (world/pixels) */
     cugl::Vec2 _pos;
     
+    /** Position at the previous simulation step, for interpolation */
+    cugl::Vec2 _prevPos;
+    
     /** Start position of current movement step */
     cugl::Vec2 _start;
     
@@ -53,7 +58,7 @@ private:
     bool _isCarrying;
 
     /** the id of the thing being carried*/
-    int _carried_id = -1;
+    ValuableId _carried = NO_VALUABLE;
     
     /** Time elapsed in current movement step (seconds) */
     float _moveTime;
@@ -140,6 +145,33 @@ public:
      */
     void setPosition(const cugl::Vec2& value);
     
+    /**
+     * Records the current position as the previous simulation state.
+     *
+     * This should be called at the start of every simulation step.
+     */
+    void storePosition() { _prevPos = _pos; }
+
+    /**
+     * Sets the position reached by a simulation step.
+     *
+     * Unlike setPosition, this keeps the previous step for interpolation.
+     *
+     * @param value The new position in world coordinates
+     */
+    void stepTo(const cugl::Vec2& value) { _pos = value; }
+
+    /**
+     * Returns the position interpolated between the last two simulation steps.
+     *
+     * @param alpha How far between the previous (0) and current (1) step
+     *
+     * @return the interpolated position
+     */
+    cugl::Vec2 getRenderPosition(float alpha) const {
+        return _prevPos + (_pos - _prevPos) * alpha;
+    }
+    
 #pragma mark -
 #pragma mark Identification
     
@@ -165,12 +197,12 @@ public:
      *
      * @param carrying Whether the player is carrying
      */
-    void setCarrying(bool carrying, int carrier_id) { _isCarrying = carrying; _carried_id = carrier_id;}
+    void setCarrying(bool carrying, ValuableId carried) { _isCarrying = carrying; _carried = carried;}
     /** 
-    * Gets the id of the carried obj, returns -1 if non carried
+    * Gets the id of the carried obj, returns NO_VALUABLE if non carried
     */
-    int getCarried() {
-        return _carried_id;
+    ValuableId getCarried() {
+        return _carried;
     }
 
 #pragma mark -
@@ -230,7 +262,16 @@ public:
      * @param dt Delta time in seconds
      */
     void update(float dt);
-    void move(Direction dir, float gridSize, int nRow, int nCol);
+
+    /**
+     * Moves the player one tile in the given direction.
+     *
+     * The player does not move if the next tile is a wall or off the map.
+     *
+     * @param dir   Direction of movement
+     * @param grid  The tile map of the level
+     */
+    void move(Direction dir, const TileGrid& grid);
     
 #pragma mark -
 #pragma mark Rendering
@@ -246,8 +287,9 @@ public:
      * Draws this player to the sprite batch.
      *
      * @param batch The sprite batch for drawing
+     * @param alpha How far between the previous and current simulation step
      */
-    void draw(const std::shared_ptr<cugl::graphics::SpriteBatch>& batch);
+    void draw(const std::shared_ptr<cugl::graphics::SpriteBatch>& batch, float alpha = 1.0f);
     
 #pragma mark Graphics
     /**
@@ -0,0 +1,303 @@
+//
+//  SongTime.h
+//  Demo
+//
+//  This file defines the fixed-point types used for all rhythm timing.
+//  SongTime is a point (or span) on the song timeline measured in integer
+//  nanoseconds. BeatPosition is a position measured in beats, stored as a
+//  32.32 fixed-point number.
+//
+//  Notes:
+//  - Everything is integer math, so repeated additions never drift
+//  - Conversions are constexpr so constants can be computed at compile time
+//  - Converting to milliseconds is for display and logging only
+//
+#ifndef __SONG_TIME_H__
+#define __SONG_TIME_H__
+#include <cugl/cugl.h>
+
+/**
+ * A signed time on the song timeline, in nanoseconds.
+ *
+ * A SongTime is used both for absolute positions (time since the song
+ * started) and for durations (the length of a beat, a judgement error).
+ */
+class SongTime {
+private:
+    /** The time in nanoseconds */
+    Sint64 _nanos;
+
+    /** Creates a song time from a raw nanosecond count */
+    constexpr explicit SongTime(Sint64 nanos) : _nanos(nanos) {}
+
+    /** Returns value rounded to the nearest integer */
+    static constexpr Sint64 round(double value) {
+        return (Sint64)(value < 0 ? value - 0.5 : value + 0.5);
+    }
+
+public:
+    /** The number of nanoseconds in a millisecond */
+    static constexpr Sint64 NANOS_PER_MILLI  = 1000000;
+    /** The number of nanoseconds in a second */
+    static constexpr Sint64 NANOS_PER_SECOND = 1000000000;
+
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates a song time at the start of the song.
+     */
+    constexpr SongTime() : _nanos(0) {}
+
+    /**
+     * Returns the song time for the given number of nanoseconds.
+     *
+     * @param nanos The number of nanoseconds
+     *
+     * @return the song time for the given number of nanoseconds
+     */
+    static constexpr SongTime fromNanos(Sint64 nanos) { return SongTime(nanos); }
+
+    /**
+     * Returns the song time for the given number of milliseconds.
+     *
+     * @param millis    The number of milliseconds
+     *
+     * @return the song time for the given number of milliseconds
+     */
+    static constexpr SongTime fromMillis(double millis) {
+        return SongTime(round(millis*NANOS_PER_MILLI));
+    }
+
+    /**
+     * Returns the song time for the given number of seconds.
+     *
+     * @param seconds   The number of seconds
+     *
+     * @return the song time for the given number of seconds
+     */
+    static constexpr SongTime fromSeconds(double seconds) {
+        return SongTime(round(seconds*NANOS_PER_SECOND));
+    }
+
+    /**
+     * Returns the song time of the given audio sample.
+     *
+     * @param samples   The sample (frame) position
+     * @param rate      The sample rate in Hz
+     *
+     * @return the song time of the given audio sample
+     */
+    static constexpr SongTime fromSamples(Sint64 samples, Uint32 rate) {
+        return SongTime((samples/rate)*NANOS_PER_SECOND + ((samples % rate)*NANOS_PER_SECOND)/rate);
+    }
+
+    /**
+     * Returns the length of one beat at the given tempo.
+     *
+     * @param bpm   The tempo in beats per minute
+     *
+     * @return the length of one beat at the given tempo
+     */
+    static constexpr SongTime fromBPM(double bpm) {
+        return SongTime(round(60.0*NANOS_PER_SECOND/bpm));
+    }
+
+#pragma mark -
+#pragma mark Conversions
+    /**
+     * Returns this time in nanoseconds.
+     *
+     * @return this time in nanoseconds
+     */
+    constexpr Sint64 toNanos() const { return _nanos; }
+
+    /**
+     * Returns this time in milliseconds.
+     *
+     * @return this time in milliseconds
+     */
+    constexpr double toMillis() const { return (double)_nanos/NANOS_PER_MILLI; }
+
+    /**
+     * Returns this time in seconds.
+     *
+     * @return this time in seconds
+     */
+    constexpr double toSeconds() const { return (double)_nanos/NANOS_PER_SECOND; }
+
+    /**
+     * Returns the audio sample (frame) at this time, rounded down.
+     *
+     * @param rate  The sample rate in Hz
+     *
+     * @return the audio sample (frame) at this time
+     */
+    constexpr Sint64 toSamples(Uint32 rate) const {
+        return (_nanos/NANOS_PER_SECOND)*rate + ((_nanos % NANOS_PER_SECOND)*rate)/NANOS_PER_SECOND;
+    }
+
+    /**
+     * Returns the absolute value of this time.
+     *
+     * @return the absolute value of this time
+     */
+    constexpr SongTime abs() const { return SongTime(_nanos < 0 ? -_nanos : _nanos); }
+
+#pragma mark -
+#pragma mark Operators
+    constexpr SongTime operator+(SongTime other) const { return SongTime(_nanos+other._nanos); }
+    constexpr SongTime operator-(SongTime other) const { return SongTime(_nanos-other._nanos); }
+    constexpr SongTime operator-() const { return SongTime(-_nanos); }
+    constexpr SongTime operator*(Sint64 scalar) const { return SongTime(_nanos*scalar); }
+    constexpr SongTime operator*(int scalar) const { return SongTime(_nanos*scalar); }
+    constexpr SongTime operator*(double scalar) const { return SongTime(round(_nanos*scalar)); }
+    constexpr SongTime operator/(Sint64 scalar) const { return SongTime(_nanos/scalar); }
+    constexpr Sint64 operator/(SongTime other) const { return _nanos/other._nanos; }
+    constexpr SongTime operator%(SongTime other) const { return SongTime(_nanos % other._nanos); }
+    SongTime& operator+=(SongTime other) { _nanos += other._nanos; return *this; }
+    SongTime& operator-=(SongTime other) { _nanos -= other._nanos; return *this; }
+
+    constexpr bool operator==(SongTime other) const { return _nanos == other._nanos; }
+    constexpr bool operator!=(SongTime other) const { return _nanos != other._nanos; }
+    constexpr bool operator< (SongTime other) const { return _nanos <  other._nanos; }
+    constexpr bool operator<=(SongTime other) const { return _nanos <= other._nanos; }
+    constexpr bool operator> (SongTime other) const { return _nanos >  other._nanos; }
+    constexpr bool operator>=(SongTime other) const { return _nanos >= other._nanos; }
+};
+
+/**
+ * A signed position on the song timeline, in beats.
+ *
+ * The value is stored as 32.32 fixed-point: the upper bits are the beat
+ * number and the lower 32 bits are the fraction of the way through it.
+ */
+class BeatPosition {
+private:
+    /** The raw fixed-point value */
+    Sint64 _value;
+
+    /** Creates a beat position from a raw fixed-point value */
+    constexpr explicit BeatPosition(Sint64 value) : _value(value) {}
+
+public:
+    /** The number of fractional bits */
+    static constexpr int FRACTION_BITS = 32;
+    /** The raw value of a single beat */
+    static constexpr Sint64 ONE = (Sint64)1 << FRACTION_BITS;
+
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates a beat position at the start of the song.
+     */
+    constexpr BeatPosition() : _value(0) {}
+
+    /**
+     * Returns the position of the start of the given beat.
+     *
+     * @param beat  The beat number
+     *
+     * @return the position of the start of the given beat
+     */
+    static constexpr BeatPosition fromBeat(Sint64 beat) { return BeatPosition(beat*ONE); }
+
+    /**
+     * Returns the position numerator/denominator beats from the start.
+     *
+     * This is used for subdivisions, such as triplets (denominator 3).
+     *
+     * @param numerator     The number of subdivisions
+     * @param denominator   The number of subdivisions per beat
+     *
+     * @return the position numerator/denominator beats from the start
+     */
+    static constexpr BeatPosition fromFraction(Sint64 numerator, Sint64 denominator) {
+        Sint64 whole = numerator/denominator;
+        Sint64 rem = numerator % denominator;
+        if (rem < 0) {
+            whole -= 1;
+            rem += denominator;
+        }
+        return BeatPosition(whole*ONE + (rem*ONE)/denominator);
+    }
+
+    /**
+     * Returns the beat position of a song time at a constant tempo.
+     *
+     * The whole and fractional parts are computed separately so that the
+     * shift never overflows, even for very long sessions.
+     *
+     * @param time      The song time
+     * @param interval  The length of one beat
+     *
+     * @return the beat position of a song time at a constant tempo
+     */
+    static constexpr BeatPosition fromTime(SongTime time, SongTime interval) {
+        Sint64 nanos = time.toNanos();
+        Sint64 len = interval.toNanos();
+        Sint64 whole = nanos/len;
+        Sint64 rem = nanos % len;
+        if (rem < 0) {
+            whole -= 1;
+            rem += len;
+        }
+        return BeatPosition(whole*ONE + (Sint64)(((Uint64)rem << FRACTION_BITS)/(Uint64)len));
+    }
+
+#pragma mark -
+#pragma mark Conversions
+    /**
+     * Returns the song time of this position at a constant tempo.
+     *
+     * @param interval  The length of one beat
+     *
+     * @return the song time of this position at a constant tempo
+     */
+    constexpr SongTime toTime(SongTime interval) const {
+        Sint64 len = interval.toNanos();
+        Uint64 frac = (Uint64)(_value & (ONE-1));
+        return SongTime::fromNanos(getBeat()*len + (Sint64)((frac*(Uint64)len) >> FRACTION_BITS));
+    }
+
+    /**
+     * Returns the beat this position falls in (rounded towards -infinity).
+     *
+     * @return the beat this position falls in
+     */
+    constexpr Sint64 getBeat() const { return _value >> FRACTION_BITS; }
+
+    /**
+     * Returns the nearest beat to this position.
+     *
+     * @return the nearest beat to this position
+     */
+    constexpr Sint64 getNearestBeat() const { return (_value + ONE/2) >> FRACTION_BITS; }
+
+    /**
+     * Returns how far this position is through its beat, in [0,1).
+     *
+     * @return how far this position is through its beat
+     */
+    constexpr double getPhase() const { return (double)(_value & (ONE-1))/ONE; }
+
+    /**
+     * Returns this position as a floating point number of beats.
+     *
+     * @return this position as a floating point number of beats
+     */
+    constexpr double toBeats() const { return (double)_value/ONE; }
+
+#pragma mark -
+#pragma mark Operators
+    constexpr BeatPosition operator+(BeatPosition other) const { return BeatPosition(_value+other._value); }
+    constexpr BeatPosition operator-(BeatPosition other) const { return BeatPosition(_value-other._value); }
+
+    constexpr bool operator==(BeatPosition other) const { return _value == other._value; }
+    constexpr bool operator!=(BeatPosition other) const { return _value != other._value; }
+    constexpr bool operator< (BeatPosition other) const { return _value <  other._value; }
+    constexpr bool operator<=(BeatPosition other) const { return _value <= other._value; }
+    constexpr bool operator> (BeatPosition other) const { return _value >  other._value; }
+    constexpr bool operator>=(BeatPosition other) const { return _value >= other._value; }
+};
+
+#endif /* __SONG_TIME_H__ */
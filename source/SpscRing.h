@@ -0,0 +1,121 @@
+//
+//  SpscRing.h
+//  Demo
+//
+//  This is a bounded lock-free queue for passing fixed-size records from one
+//  thread to another. It is used to get data off the game thread without
+//  locks or allocation.
+//
+//  Notes:
+//  - There must be exactly one producer thread and one consumer thread
+//  - The capacity must be a power of two
+//  - Neither push nor pop blocks; they fail when the ring is full or empty
+//
+#ifndef __SPSC_RING_H__
+#define __SPSC_RING_H__
+#include <atomic>
+#include <cstddef>
+
+/** The size of a cache line, to keep the two indices from false sharing */
+#define RING_CACHE_LINE 64
+
+/**
+ * A single-producer, single-consumer ring buffer.
+ */
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N > 0 && (N & (N-1)) == 0, "SpscRing capacity must be a power of two");
+
+private:
+    /** The next slot to read (written only by the consumer) */
+    alignas(RING_CACHE_LINE) std::atomic<size_t> _head;
+    /** The next slot to write (written only by the producer) */
+    alignas(RING_CACHE_LINE) std::atomic<size_t> _tail;
+    /** The records */
+    alignas(RING_CACHE_LINE) T _items[N];
+
+public:
+    /**
+     * Creates an empty ring.
+     */
+    SpscRing() : _head(0), _tail(0) {}
+
+    /**
+     * Adds a record to the ring (producer only).
+     *
+     * @param item  The record to add
+     *
+     * @return false if the ring was full
+     */
+    bool push(const T& item) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail-_head.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        _items[tail & (N-1)] = item;
+        _tail.store(tail+1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Removes the oldest record from the ring (consumer only).
+     *
+     * @param item  The record removed
+     *
+     * @return false if the ring was empty
+     */
+    bool pop(T& item) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _items[head & (N-1)];
+        _head.store(head+1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Returns a record in the ring without removing it (consumer only).
+     *
+     * The consumer may modify the record in place, since the producer does
+     * not touch it until it is popped.
+     *
+     * @param offset    The position of the record after the oldest
+     *
+     * @return the record, or nullptr if there are not that many
+     */
+    T* peek(size_t offset = 0) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (_tail.load(std::memory_order_acquire)-head <= offset) {
+            return nullptr;
+        }
+        return &_items[(head+offset) & (N-1)];
+    }
+
+    /**
+     * Returns the number of records in the ring.
+     *
+     * The value may be out of date as soon as it is returned.
+     *
+     * @return the number of records in the ring
+     */
+    size_t size() const {
+        return _tail.load(std::memory_order_acquire)-_head.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Returns true if the ring has no records.
+     *
+     * @return true if the ring has no records
+     */
+    bool isEmpty() const { return size() == 0; }
+
+    /**
+     * Returns the number of records the ring can hold.
+     *
+     * @return the number of records the ring can hold
+     */
+    static constexpr size_t capacity() { return N; }
+};
+
+#endif /* __SPSC_RING_H__ */
@@ -0,0 +1,199 @@
+//
+//  TempoMap.cpp
+//  Demo
+//
+//  This is the implementation for the TempoMap class.
+//
+#include "TempoMap.h"
+#include <algorithm>
+
+using namespace cugl;
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates a tempo map at 120 BPM in 4/4.
+ */
+TempoMap::TempoMap() :
+    _maxNumerator(4) {
+    init(SongTime::fromBPM(120));
+}
+
+/**
+ * Initializes this map with a single constant tempo and meter.
+ */
+bool TempoMap::init(SongTime interval, int numerator, int denominator) {
+    if (interval <= SongTime() || numerator <= 0 || denominator <= 0) {
+        return false;
+    }
+    _segments.clear();
+    _segments.push_back({SongTime(), BeatPosition(), 0, interval, numerator, denominator});
+    _maxNumerator = numerator;
+    return true;
+}
+
+/**
+ * Initializes this map from the given JSON.
+ */
+bool TempoMap::initWithJson(const std::shared_ptr<JsonValue>& data) {
+    if (data == nullptr || data->size() == 0) {
+        return false;
+    }
+
+    // Parsed on the side, so a bad change leaves this map as it was
+    TempoMap parsed;
+    auto changes = data->children();
+    bool first = true;
+    SongTime interval;
+    int numerator = 4;
+    int denominator = 4;
+    for (auto it = changes.begin(); it != changes.end(); ++it) {
+        std::shared_ptr<JsonValue> entry = (*it);
+        Sint64 beat = entry->get("beat") ? entry->get("beat")->asInt(0) : 0;
+        if (entry->get("bpm")) {
+            interval = SongTime::fromBPM(entry->get("bpm")->asFloat());
+        }
+        if (entry->get("meter")) {
+            numerator = entry->get("meter")->get(0)->asInt(4);
+            denominator = entry->get("meter")->get(1)->asInt(4);
+        }
+
+        if (first) {
+            if (beat != 0 || !parsed.init(interval, numerator, denominator)) {
+                CULog("The first tempo change must be at beat 0 with a bpm");
+                return false;
+            }
+            first = false;
+        } else if (!parsed.addChange(beat, interval, numerator, denominator)) {
+            CULog("Tempo change at beat %lld is out of order", (long long)beat);
+            return false;
+        }
+    }
+    *this = std::move(parsed);
+    return true;
+}
+
+/**
+ * Appends a tempo and/or meter change.
+ */
+bool TempoMap::addChange(Sint64 beat, SongTime interval, int numerator, int denominator) {
+    const Segment& prev = _segments.back();
+    Sint64 prevBeat = prev.startBeat.getBeat();
+    if (beat <= prevBeat || interval <= SongTime() || numerator <= 0 || denominator <= 0) {
+        return false;
+    }
+
+    // A partial measure before a meter change still counts as a measure
+    Sint64 beats = beat-prevBeat;
+    Segment next;
+    next.startTime = prev.startTime + prev.interval*beats;
+    next.startBeat = BeatPosition::fromBeat(beat);
+    next.startMeasure = prev.startMeasure + (beats+prev.numerator-1)/prev.numerator;
+    next.interval = interval;
+    next.numerator = numerator;
+    next.denominator = denominator;
+    _segments.push_back(next);
+    _maxNumerator = std::max(_maxNumerator, numerator);
+    return true;
+}
+
+#pragma mark -
+#pragma mark Segment Search
+/**
+ * Returns the index of the segment containing the given time.
+ */
+size_t TempoMap::findSegment(SongTime time) const {
+    auto next = std::upper_bound(_segments.begin(), _segments.end(), time,
+                                 [](SongTime t, const Segment& seg) { return t < seg.startTime; });
+    return next == _segments.begin() ? 0 : (size_t)(next-_segments.begin())-1;
+}
+
+/**
+ * Returns the index of the segment containing the given beat.
+ */
+size_t TempoMap::findSegment(BeatPosition beat) const {
+    auto next = std::upper_bound(_segments.begin(), _segments.end(), beat,
+                                 [](BeatPosition b, const Segment& seg) { return b < seg.startBeat; });
+    return next == _segments.begin() ? 0 : (size_t)(next-_segments.begin())-1;
+}
+
+/**
+ * Returns the index of the segment containing the given time, starting at the cursor.
+ */
+size_t TempoMap::findSegment(SongTime time, Cursor& cursor) const {
+    size_t index = std::min(cursor.index, _segments.size()-1);
+    if (time < _segments[index].startTime) {
+        // Went backwards (a seek), so fall back to a search
+        index = findSegment(time);
+    } else {
+        while (index+1 < _segments.size() && _segments[index+1].startTime <= time) {
+            index++;
+        }
+    }
+    cursor.index = index;
+    return index;
+}
+
+#pragma mark -
+#pragma mark Conversions
+/**
+ * Returns the beat position of the given song time.
+ */
+BeatPosition TempoMap::toBeat(SongTime time) const {
+    const Segment& seg = _segments[findSegment(time)];
+    return seg.startBeat + BeatPosition::fromTime(time-seg.startTime, seg.interval);
+}
+
+/**
+ * Returns the beat position of the given song time, using a cursor.
+ */
+BeatPosition TempoMap::toBeat(SongTime time, Cursor& cursor) const {
+    const Segment& seg = _segments[findSegment(time, cursor)];
+    return seg.startBeat + BeatPosition::fromTime(time-seg.startTime, seg.interval);
+}
+
+/**
+ * Returns the song time of the given beat position.
+ */
+SongTime TempoMap::toTime(BeatPosition beat) const {
+    const Segment& seg = _segments[findSegment(beat)];
+    return seg.startTime + (beat-seg.startBeat).toTime(seg.interval);
+}
+
+#pragma mark -
+#pragma mark Meter
+/**
+ * Returns the length of the given beat.
+ */
+SongTime TempoMap::getInterval(Sint64 beat) const {
+    return _segments[findSegment(BeatPosition::fromBeat(beat))].interval;
+}
+
+/**
+ * Returns the number of beats in the measure containing the given beat.
+ */
+int TempoMap::getBeatsPerMeasure(Sint64 beat) const {
+    return _segments[findSegment(BeatPosition::fromBeat(beat))].numerator;
+}
+
+/**
+ * Returns the position of the given beat within its measure.
+ */
+int TempoMap::getBeatInMeasure(Sint64 beat) const {
+    const Segment& seg = _segments[findSegment(BeatPosition::fromBeat(beat))];
+    Sint64 offset = (beat-seg.startBeat.getBeat()) % seg.numerator;
+    return (int)(offset < 0 ? offset+seg.numerator : offset);
+}
+
+/**
+ * Returns the measure containing the given beat.
+ */
+Sint64 TempoMap::getMeasure(Sint64 beat) const {
+    const Segment& seg = _segments[findSegment(BeatPosition::fromBeat(beat))];
+    Sint64 offset = beat-seg.startBeat.getBeat();
+    Sint64 measure = offset/seg.numerator;
+    if (offset < 0 && offset % seg.numerator != 0) {
+        measure -= 1;
+    }
+    return seg.startMeasure + measure;
+}
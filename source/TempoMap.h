@@ -0,0 +1,228 @@
+//
+//  TempoMap.h
+//  Demo
+//
+//  This class converts between song time and beats for songs whose tempo
+//  and time signature change. The song is divided into segments, each with
+//  a constant tempo and meter. The start time, start beat and start measure
+//  of every segment are precomputed, so a conversion is a binary search over
+//  segments, or O(1) with a cursor when the queries move forward in time.
+//
+//  Notes:
+//  - Segments must be added in order
+//  - Meter changes must fall on a whole beat
+//  - A song with one segment costs the same as a fixed tempo
+//
+#ifndef __TEMPO_MAP_H__
+#define __TEMPO_MAP_H__
+#include <cugl/cugl.h>
+#include <vector>
+#include "SongTime.h"
+
+/**
+ * A map of tempo and time signature changes over a song.
+ */
+class TempoMap {
+public:
+    /**
+     * A span of the song with a constant tempo and meter.
+     */
+    struct Segment {
+        /** The song time at which this segment starts */
+        SongTime startTime;
+        /** The beat position at which this segment starts */
+        BeatPosition startBeat;
+        /** The measure number at which this segment starts */
+        Sint64 startMeasure;
+        /** The length of one beat in this segment */
+        SongTime interval;
+        /** The number of beats in one measure */
+        int numerator;
+        /** The note value that gets one beat */
+        int denominator;
+    };
+
+    /**
+     * A position in the segment table, to speed up ordered queries.
+     *
+     * Each system that queries the map as time moves forward should keep
+     * its own cursor.
+     */
+    struct Cursor {
+        /** The index of the last segment found */
+        size_t index = 0;
+    };
+
+private:
+    /** The segments, sorted by start time */
+    std::vector<Segment> _segments;
+    /** The largest number of beats in any measure */
+    int _maxNumerator;
+
+    /** Returns the index of the segment containing the given time */
+    size_t findSegment(SongTime time) const;
+    /** Returns the index of the segment containing the given beat */
+    size_t findSegment(BeatPosition beat) const;
+    /** Returns the index of the segment containing the given time, starting at the cursor */
+    size_t findSegment(SongTime time, Cursor& cursor) const;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates a tempo map at 120 BPM in 4/4.
+     */
+    TempoMap();
+
+    /**
+     * Initializes this map with a single constant tempo and meter.
+     *
+     * @param interval      The length of one beat
+     * @param numerator     The number of beats in one measure
+     * @param denominator   The note value that gets one beat
+     *
+     * @return true if initialization was successful
+     */
+    bool init(SongTime interval, int numerator = 4, int denominator = 4);
+
+    /**
+     * Initializes this map from the given JSON.
+     *
+     * The JSON is an array of changes, each with a whole "beat" at which it
+     * starts, and a "bpm", a "meter" ([numerator, denominator]), or both.
+     * Values that are not given carry over from the previous change. The
+     * first change must be at beat 0. If any change is invalid, this map
+     * is left as it was.
+     *
+     * @param data  The JSON array of tempo changes
+     *
+     * @return true if initialization was successful
+     */
+    bool initWithJson(const std::shared_ptr<cugl::JsonValue>& data);
+
+    /**
+     * Appends a tempo and/or meter change.
+     *
+     * The change must come after every existing change. The meter change
+     * takes effect at the given beat; measures are counted from there.
+     *
+     * @param beat          The beat at which the change happens
+     * @param interval      The new length of one beat
+     * @param numerator     The new number of beats in one measure
+     * @param denominator   The new note value that gets one beat
+     *
+     * @return true if the change was added
+     */
+    bool addChange(Sint64 beat, SongTime interval, int numerator, int denominator);
+
+#pragma mark -
+#pragma mark Conversions
+    /**
+     * Returns the beat position of the given song time.
+     *
+     * @param time  The song time
+     *
+     * @return the beat position of the given song time
+     */
+    BeatPosition toBeat(SongTime time) const;
+
+    /**
+     * Returns the beat position of the given song time, using a cursor.
+     *
+     * This is O(1) when successive queries move forward in time.
+     *
+     * @param time      The song time
+     * @param cursor    The cursor to start the search from (updated)
+     *
+     * @return the beat position of the given song time
+     */
+    BeatPosition toBeat(SongTime time, Cursor& cursor) const;
+
+    /**
+     * Returns the song time of the given beat position.
+     *
+     * @param beat  The beat position
+     *
+     * @return the song time of the given beat position
+     */
+    SongTime toTime(BeatPosition beat) const;
+
+    /**
+     * Returns the song time at which the given beat starts.
+     *
+     * @param beat  The beat number
+     *
+     * @return the song time at which the given beat starts
+     */
+    SongTime getBeatTime(Sint64 beat) const { return toTime(BeatPosition::fromBeat(beat)); }
+
+    /**
+     * Returns the signed time from the nearest beat to the given time.
+     *
+     * This is the timing error of an input at that time. It is positive
+     * when the input is late.
+     *
+     * @param time  The song time
+     *
+     * @return the signed time from the nearest beat to the given time
+     */
+    SongTime getBeatError(SongTime time) const {
+        return time - getBeatTime(toBeat(time).getNearestBeat());
+    }
+
+#pragma mark -
+#pragma mark Meter
+    /**
+     * Returns the length of the given beat.
+     *
+     * @param beat  The beat number
+     *
+     * @return the length of the given beat
+     */
+    SongTime getInterval(Sint64 beat) const;
+
+    /**
+     * Returns the number of beats in the measure containing the given beat.
+     *
+     * @param beat  The beat number
+     *
+     * @return the number of beats in the measure containing the given beat
+     */
+    int getBeatsPerMeasure(Sint64 beat) const;
+
+    /**
+     * Returns the largest number of beats in any measure of the song.
+     *
+     * @return the largest number of beats in any measure of the song
+     */
+    int getMaxBeatsPerMeasure() const { return _maxNumerator; }
+
+    /**
+     * Returns the position of the given beat within its measure.
+     *
+     * The first beat of every measure is 0.
+     *
+     * @param beat  The beat number
+     *
+     * @return the position of the given beat within its measure
+     */
+    int getBeatInMeasure(Sint64 beat) const;
+
+    /**
+     * Returns the measure containing the given beat.
+     *
+     * @param beat  The beat number
+     *
+     * @return the measure containing the given beat
+     */
+    Sint64 getMeasure(Sint64 beat) const;
+
+    /**
+     * Returns the segments of this map.
+     *
+     * @return the segments of this map
+     */
+    const std::vector<Segment>& getSegments() const { return _segments; }
+};
+
+#endif /* __TEMPO_MAP_H__ */
@@ -0,0 +1,73 @@
+//
+//  TileGrid.cpp
+//  Demo
+//
+//  This is the implementation for the TileGrid class.
+//
+#include "TileGrid.h"
+
+using namespace cugl;
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Initializes a grid of floor tiles.
+ */
+bool TileGrid::init(int rows, int cols, float tileSize) {
+    if (rows <= 0 || cols <= 0 || tileSize <= 0) {
+        return false;
+    }
+    _rows = rows;
+    _cols = cols;
+    _tileSize = tileSize;
+    size_t cells = (size_t)rows*cols;
+    _types.assign(cells, (Uint8)TileType::FLOOR);
+    _walkable.assign((cells+TILE_WORD_BITS-1)/TILE_WORD_BITS, ~(Uint64)0);
+    _revision++;
+    return true;
+}
+
+/**
+ * Initializes a grid from level data.
+ */
+bool TileGrid::initWithJson(const std::shared_ptr<JsonValue>& json) {
+    if (json == nullptr) {
+        return false;
+    }
+    std::shared_ptr<JsonValue> tiles = json->get("tiles");
+    if (tiles == nullptr || tiles->size() == 0) {
+        CULog("Level has no tiles");
+        return false;
+    }
+
+    int rows = (int)tiles->size();
+    int cols = 0;
+    for (int ii = 0; ii < rows; ii++) {
+        cols = std::max(cols, (int)tiles->get(ii)->asString().size());
+    }
+    if (!init(rows, cols, json->getFloat("tile size", 100.0f))) {
+        return false;
+    }
+
+    // The first string is the top of the map
+    for (int ii = 0; ii < rows; ii++) {
+        std::string line = tiles->get(ii)->asString();
+        int row = rows-1-ii;
+        for (int col = 0; col < (int)line.size(); col++) {
+            setType(row, col, tileTypeFromChar(line[col]));
+        }
+    }
+    return true;
+}
+
+#pragma mark -
+#pragma mark Tiles
+/**
+ * Sets the type of a cell in the map.
+ */
+void TileGrid::setType(int row, int col, TileType type) {
+    size_t index = toIndex(row, col);
+    _types[index] = (Uint8)type;
+    setTileBit(_walkable.data(), index, TileObject(row, col, type).isWalkable());
+    _revision++;
+}
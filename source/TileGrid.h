@@ -0,0 +1,401 @@
+//
+//  TileGrid.h
+//  Demo
+//
+//  This class is the tile map of a level. The tiles are stored densely in
+//  row-major order: one TileType byte per cell, plus a bitset of the
+//  walkable cells. Movement only ever needs the bitset, so a wall check is
+//  one shift and mask on memory that stays in cache even for very large
+//  maps.
+//
+//  Notes:
+//  - Row 0 is the bottom of the map, to match world coordinates (y up)
+//  - Cells outside the map are never walkable
+//  - FixedTileGrid is the same map with a compile-time size, for small
+//    rooms that should not allocate
+//
+#ifndef __TILE_GRID_H__
+#define __TILE_GRID_H__
+#include <cugl/cugl.h>
+#include <array>
+#include <vector>
+#include "TileModel.h"
+#include "Direction.h"
+
+/** The number of cells in each word of the walkability bitset */
+#define TILE_WORD_BITS  64
+
+/**
+ * Returns true if the given bit of a bitset is set.
+ *
+ * @param words The words of the bitset
+ * @param index The bit index
+ *
+ * @return true if the given bit of a bitset is set
+ */
+inline bool testTileBit(const Uint64* words, size_t index) {
+    return (words[index/TILE_WORD_BITS] >> (index%TILE_WORD_BITS)) & 1;
+}
+
+/**
+ * Sets or clears the given bit of a bitset.
+ *
+ * @param words The words of the bitset
+ * @param index The bit index
+ * @param value Whether to set the bit
+ */
+inline void setTileBit(Uint64* words, size_t index, bool value) {
+    Uint64 mask = (Uint64)1 << (index%TILE_WORD_BITS);
+    if (value) {
+        words[index/TILE_WORD_BITS] |= mask;
+    } else {
+        words[index/TILE_WORD_BITS] &= ~mask;
+    }
+}
+
+/**
+ * Returns the tile type of a level character ('#' is a wall).
+ *
+ * @param c The character in the level data
+ *
+ * @return the tile type of a level character
+ */
+inline TileType tileTypeFromChar(char c) {
+    return c == '#' ? TileType::WALL : TileType::FLOOR;
+}
+
+/**
+ * A dense tile map of a level.
+ */
+class TileGrid {
+private:
+    /** The number of rows */
+    int _rows;
+    /** The number of columns */
+    int _cols;
+    /** The size of a tile in world units */
+    float _tileSize;
+    /** The type of every cell, in row-major order */
+    std::vector<Uint8> _types;
+    /** The walkable cells, in row-major order */
+    std::vector<Uint64> _walkable;
+    /** The number of tile changes, so that cached paths know when to rebuild */
+    Uint32 _revision;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates an empty grid.
+     *
+     * You must initialize this grid before use.
+     */
+    TileGrid() : _rows(0), _cols(0), _tileSize(1.0f), _revision(0) {}
+
+    /**
+     * Initializes a grid of floor tiles.
+     *
+     * @param rows      The number of rows
+     * @param cols      The number of columns
+     * @param tileSize  The size of a tile in world units
+     *
+     * @return true if initialization was successful
+     */
+    bool init(int rows, int cols, float tileSize);
+
+    /**
+     * Initializes a grid from level data.
+     *
+     * The JSON has a "tile size" and a "tiles" array of strings, one per
+     * row from the top of the map down. A '#' is a wall and anything else
+     * is floor. Short rows are padded with floor.
+     *
+     * @param json  The level data
+     *
+     * @return true if initialization was successful
+     */
+    bool initWithJson(const std::shared_ptr<cugl::JsonValue>& json);
+
+#pragma mark -
+#pragma mark Tiles
+    /**
+     * Returns true if the cell is in the map and can be walked on.
+     *
+     * @param row   The row of the cell
+     * @param col   The column of the cell
+     *
+     * @return true if the cell is in the map and can be walked on
+     */
+    bool isWalkable(int row, int col) const {
+        // Negative values wrap around, so one comparison checks both bounds
+        return (unsigned)row < (unsigned)_rows && (unsigned)col < (unsigned)_cols &&
+               testTileBit(_walkable.data(), (size_t)row*_cols+col);
+    }
+
+    /**
+     * Returns true if the cell with the given index can be walked on.
+     *
+     * @param index The row-major index of a cell in the map
+     *
+     * @return true if the cell can be walked on
+     */
+    bool isWalkable(size_t index) const { return testTileBit(_walkable.data(), index); }
+
+    /**
+     * Returns the type of a cell in the map.
+     *
+     * @param row   The row of the cell
+     * @param col   The column of the cell
+     *
+     * @return the type of a cell in the map
+     */
+    TileType getType(int row, int col) const { return (TileType)_types[(size_t)row*_cols+col]; }
+
+    /**
+     * Sets the type of a cell in the map.
+     *
+     * @param row   The row of the cell
+     * @param col   The column of the cell
+     * @param type  The new type
+     */
+    void setType(int row, int col, TileType type);
+
+    /**
+     * Returns the tile object of a cell in the map.
+     *
+     * @param row   The row of the cell
+     * @param col   The column of the cell
+     *
+     * @return the tile object of a cell in the map
+     */
+    TileObject getTile(int row, int col) const { return TileObject(row, col, getType(row, col)); }
+
+    /**
+     * Returns the number of times the tiles have changed.
+     *
+     * Anything computed from the walls (paths, sight lines) is stale once
+     * this value changes.
+     *
+     * @return the number of times the tiles have changed
+     */
+    Uint32 getRevision() const { return _revision; }
+
+#pragma mark -
+#pragma mark Coordinates
+    /**
+     * Returns the number of rows.
+     *
+     * @return the number of rows
+     */
+    int getRows() const { return _rows; }
+
+    /**
+     * Returns the number of columns.
+     *
+     * @return the number of columns
+     */
+    int getCols() const { return _cols; }
+
+    /**
+     * Returns the number of cells.
+     *
+     * @return the number of cells
+     */
+    size_t size() const { return _types.size(); }
+
+    /**
+     * Returns the size of a tile in world units.
+     *
+     * @return the size of a tile in world units
+     */
+    float getTileSize() const { return _tileSize; }
+
+    /**
+     * Returns the row-major index of a cell in the map.
+     *
+     * @param row   The row of the cell
+     * @param col   The column of the cell
+     *
+     * @return the row-major index of a cell
+     */
+    size_t toIndex(int row, int col) const { return (size_t)row*_cols+col; }
+
+    /**
+     * Returns the row of a world position (which may be outside the map).
+     *
+     * @param pos   The world position
+     *
+     * @return the row of a world position
+     */
+    int toRow(const cugl::Vec2& pos) const { return (int)std::floor(pos.y/_tileSize); }
+
+    /**
+     * Returns the column of a world position (which may be outside the map).
+     *
+     * @param pos   The world position
+     *
+     * @return the column of a world position
+     */
+    int toCol(const cugl::Vec2& pos) const { return (int)std::floor(pos.x/_tileSize); }
+
+    /**
+     * Returns the cell index of a world position, or -1 if it is off the map.
+     *
+     * @param pos   The world position
+     *
+     * @return the cell index of a world position
+     */
+    int toCell(const cugl::Vec2& pos) const {
+        return toCell(toRow(pos), toCol(pos));
+    }
+
+    /**
+     * Returns the cell index of a row and column, or -1 if it is off the map.
+     *
+     * @param row   The row of the cell
+     * @param col   The column of the cell
+     *
+     * @return the cell index of a row and column
+     */
+    int toCell(int row, int col) const {
+        return (unsigned)row < (unsigned)_rows && (unsigned)col < (unsigned)_cols ? (int)toIndex(row, col) : -1;
+    }
+
+    /**
+     * Returns the world position of the center of a cell.
+     *
+     * @param row   The row of the cell
+     * @param col   The column of the cell
+     *
+     * @return the world position of the center of a cell
+     */
+    cugl::Vec2 toWorld(int row, int col) const {
+        return cugl::Vec2((col+0.5f)*_tileSize, (row+0.5f)*_tileSize);
+    }
+
+    /**
+     * Returns the cell next to a cell, or -1 if it is off the map.
+     *
+     * @param cell  The cell index
+     * @param dir   The direction (None for the cell itself)
+     *
+     * @return the cell next to a cell
+     */
+    int neighbor(int cell, Direction dir) const {
+        int row = cell/_cols;
+        int col = cell%_cols;
+        switch (dir) {
+            case Direction::Up:
+                row++;
+                break;
+            case Direction::Down:
+                row--;
+                break;
+            case Direction::Left:
+                col--;
+                break;
+            case Direction::Right:
+                col++;
+                break;
+            default:
+                break;
+        }
+        return (unsigned)row < (unsigned)_rows && (unsigned)col < (unsigned)_cols ? (int)toIndex(row, col) : -1;
+    }
+};
+
+/**
+ * A tile map with a compile-time size, for small fixed rooms.
+ *
+ * This has the same queries as TileGrid, but the storage is inline, so a
+ * room can live on the stack or inside another object without allocating.
+ */
+template <int ROWS, int COLS>
+class FixedTileGrid {
+    static_assert(ROWS > 0 && COLS > 0, "FixedTileGrid must have at least one cell");
+
+public:
+    /** The number of cells */
+    static constexpr size_t CELLS = (size_t)ROWS*COLS;
+
+private:
+    /** The type of every cell, in row-major order */
+    std::array<Uint8, CELLS> _types;
+    /** The walkable cells, in row-major order */
+    std::array<Uint64, (CELLS+TILE_WORD_BITS-1)/TILE_WORD_BITS> _walkable;
+
+public:
+    /**
+     * Creates a room of floor tiles.
+     */
+    FixedTileGrid() {
+        _types.fill((Uint8)TileType::FLOOR);
+        _walkable.fill(~(Uint64)0);
+    }
+
+    /**
+     * Creates a room from rows of level characters, from the top down.
+     *
+     * @param rows  The rows of the room ('#' is a wall)
+     */
+    explicit FixedTileGrid(const char* const (&rows)[ROWS]) : FixedTileGrid() {
+        for (int row = 0; row < ROWS; row++) {
+            const char* line = rows[ROWS-1-row];
+            for (int col = 0; col < COLS && line[col] != '\0'; col++) {
+                setType(row, col, tileTypeFromChar(line[col]));
+            }
+        }
+    }
+
+    /**
+     * Returns true if the cell is in the room and can be walked on.
+     *
+     * @param row   The row of the cell
+     * @param col   The column of the cell
+     *
+     * @return true if the cell is in the room and can be walked on
+     */
+    bool isWalkable(int row, int col) const {
+        return (unsigned)row < (unsigned)ROWS && (unsigned)col < (unsigned)COLS &&
+               testTileBit(_walkable.data(), (size_t)row*COLS+col);
+    }
+
+    /**
+     * Returns the type of a cell in the room.
+     *
+     * @param row   The row of the cell
+     * @param col   The column of the cell
+     *
+     * @return the type of a cell in the room
+     */
+    TileType getType(int row, int col) const { return (TileType)_types[(size_t)row*COLS+col]; }
+
+    /**
+     * Sets the type of a cell in the room.
+     *
+     * @param row   The row of the cell
+     * @param col   The column of the cell
+     * @param type  The new type
+     */
+    void setType(int row, int col, TileType type) {
+        size_t index = (size_t)row*COLS+col;
+        _types[index] = (Uint8)type;
+        setTileBit(_walkable.data(), index, TileObject(row, col, type).isWalkable());
+    }
+
+    /**
+     * Returns the number of rows.
+     *
+     * @return the number of rows
+     */
+    static constexpr int getRows() { return ROWS; }
+
+    /**
+     * Returns the number of columns.
+     *
+     * @return the number of columns
+     */
+    static constexpr int getCols() { return COLS; }
+};
+
+#endif /* __TILE_GRID_H__ */
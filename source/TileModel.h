@@ -54,3 +54,5 @@ public:
         return _type != TileType::WALL;
     }
 };
+
+#endif /* __TILE_MODEL_H__ */
@@ -4,58 +4,6 @@ using namespace cugl;
 using namespace cugl::graphics;
 using namespace cugl::audio;
 
-#pragma mark Valuable
-/**
- * Allocates a valuable by setting its position and velocity.
- *
- * @param p     The position
- * @param v     The velocity
- */
-ValuableSet::Valuable::Valuable(const cugl::Vec2 p, int type) {
-    position = p;
-    setType(type);
-}
-
-/**
- * Returns the type of this valuable.
- *
- * All valuables have types 1 or 2.  2 is the larger type of
- * valuable (statues, paintings) (scale 1.25), while 1 is the smaller (vase, jewelry) (scale of 0.5).
- *
- * @param type  The type of this valuable.
- */
-void ValuableSet::Valuable::setType(int type) {
-    CUAssertLog(type > 0 && type <= 2, "type must be 1 or 2");
-    _type = type;
-    switch (type) {
-    case 2:
-        _scale = 0.14;
-        break;
-    case 1:
-        _scale = 0.11;
-        break;
-    default:
-        _scale = 0.0f;
-        break;
-    }
-}
-
-void ValuableSet::Valuable::setState(Status state, int id) {
-    _state = state;
-    carrierID = id;
-}
-
-/**
- * Updates the valuable one animation frame
- *
- * This method performs no
- * collision detection. Collisions are resolved afterwards.
- */
-void ValuableSet::Valuable::update(Size size, cugl::Vec2 pos) {
-    // position += velocity;
-    position = pos;
-}
-
 #pragma mark Valuable Set
 /**
  * Creates a valuable set with the default values.
@@ -66,13 +14,14 @@ void ValuableSet::Valuable::update(Size size, cugl::Vec2 pos) {
  * is called (because we do not create this object dynamically).
  */
 ValuableSet::ValuableSet() :
-    _radius(0) {
+    _radius(0),
+    _grid(nullptr) {
 }
 
 /**
  * Initializes valuable data with the given JSON
  *
- * This JSON contains all shared information. 
+ * This JSON contains all shared information.
  * It also contains a list of valuables to
  * spawn initially.
  *
@@ -80,13 +29,28 @@ ValuableSet::ValuableSet() :
  * valuable data.
  *
  * @param data  The data defining the valuable settings
+ * @param grid  The tile map the valuables are on
  *
  * @return true if initialization was successful
  */
-bool ValuableSet::init(std::shared_ptr<cugl::JsonValue> data) {
+bool ValuableSet::init(std::shared_ptr<cugl::JsonValue> data, const TileGrid& grid) {
     if (data) {
-        // Reset all data
-        current.clear();
+        // Reset all data (old ids stay stale, since the generations are kept)
+        for (size_t ii = 0; ii < _dense.size(); ++ii) {
+            if (_dense[ii] != -1) {
+                _dense[ii] = -1;
+                _generations[ii]++;
+                _freeSlots.push_back((Uint32)ii);
+            }
+        }
+        _positions.clear();
+        _types.clear();
+        _scales.clear();
+        _states.clear();
+        _carriers.clear();
+        _slots.clear();
+        _grid = &grid;
+        _cells.init(grid.size());
 
         // This is an iterator over all of the elements of rocks
         if (data->get("start")) {
@@ -131,31 +95,143 @@ void ValuableSet::setTexture(const std::shared_ptr<Texture>& value) {
 }
 
 /**
- * Adds a valuable to the active queue.
+ * Returns the scale of a valuable type.
+ *
+ * All valuables have types 1 or 2.  2 is the larger type of
+ * valuable (statues, paintings) (scale 1.25), while 1 is the smaller (vase, jewelry) (scale of 0.5).
+ *
+ * @param type  The type of a valuable.
+ */
+float ValuableSet::scaleOf(int type) {
+    CUAssertLog(type > 0 && type <= 2, "type must be 1 or 2");
+    switch (type) {
+    case 2:
+        return 0.14;
+    case 1:
+        return 0.11;
+    default:
+        return 0.0f;
+    }
+}
+
+/**
+ * Adds a valuable to the set.
  *
  * @param p     The valuable position.
- * @param type  The valuable type.
+ * @param t     The valuable type.
+ *
+ * @return the id of the new valuable
  */
-void ValuableSet::spawnValuable(Vec2 p, int t) {
-    std::shared_ptr<Valuable> rock = std::make_shared<Valuable>(p, t);
-    rock->setState(Valuable::FREE, -1);
-    current.push_back(rock);
+ValuableId ValuableSet::spawnValuable(Vec2 p, int t) {
+    Uint32 slot;
+    if (_freeSlots.empty()) {
+        slot = (Uint32)_dense.size();
+        _dense.push_back(-1);
+        _generations.push_back(0);
+    } else {
+        slot = _freeSlots.back();
+        _freeSlots.pop_back();
+    }
+    _dense[slot] = (int)_positions.size();
+    _positions.push_back(p);
+    _types.push_back((Uint8)t);
+    _scales.push_back(scaleOf(t));
+    _states.push_back(FREE);
+    _carriers.push_back(-1);
+    _slots.push_back(slot);
+    if (_grid != nullptr) {
+        _cells.place((int)slot, _grid->toCell(p));
+    }
+    return makeId(slot);
 }
 
 /**
- * Updates all the valuables in the active set.
+ * Removes a valuable from the set in O(1).
+ *
+ * @param id    The valuable id
+ *
+ * @return true if the valuable existed
+ */
+bool ValuableSet::removeValuable(ValuableId id) {
+    int index = find(id);
+    if (index == -1) {
+        return false;
+    }
+    Uint32 slot = _slots[index];
+    _cells.remove((int)slot);
+
+    // Move the last valuable into the hole
+    size_t last = _positions.size()-1;
+    if ((size_t)index != last) {
+        _positions[index] = _positions[last];
+        _types[index] = _types[last];
+        _scales[index] = _scales[last];
+        _states[index] = _states[last];
+        _carriers[index] = _carriers[last];
+        _slots[index] = _slots[last];
+        _dense[_slots[index]] = index;
+    }
+    _positions.pop_back();
+    _types.pop_back();
+    _scales.pop_back();
+    _states.pop_back();
+    _carriers.pop_back();
+    _slots.pop_back();
+
+    _dense[slot] = -1;
+    _generations[slot]++;
+    _freeSlots.push_back(slot);
+    return true;
+}
+
+/**
+ * Marks a valuable as dropped where it is, and puts it in that cell.
+ *
+ * @param val_id    The valuable id (ignored if it is stale or NO_VALUABLE)
+ */
+void ValuableSet::set_val_dropped(ValuableId val_id) {
+    int index = find(val_id);
+    if (index == -1) {
+        return;
+    }
+    _states[index] = FREE;
+    _carriers[index] = -1;
+    if (_grid != nullptr) {
+        _cells.place((int)_slots[index], _grid->toCell(_positions[index]));
+    }
+}
+
+/**
+ * Marks a valuable as carried, and takes it out of its cell.
+ *
+ * @param val_id        The valuable id
+ * @param carrier_id    The id of the player carrying it
+ */
+void ValuableSet::set_val_carried(ValuableId val_id, int carrier_id) {
+    int index = find(val_id);
+    if (index == -1) {
+        return;
+    }
+    _states[index] = CARRIED;
+    _carriers[index] = carrier_id;
+    _cells.remove((int)_slots[index]);
+}
+
+/**
+ * Updates all the valuables in the set.
  *
  * This method performs no collision detection. Collisions
  * are resolved afterwards.
+ *
+ * @param players   The positions of the players, indexed by player id
  */
-void ValuableSet::update(Size size, std::vector<cugl::Vec2> pos) {
-    // Move asteroids, updating the animation frame
-    for (size_t i = 0; i < current.size(); ++i) {
-        std::shared_ptr<ValuableSet::Valuable> val = current[i];
-        if (val->getCarrier() != -1 && val->position != pos[val->getCarrier()]) {
-            val->update(size, pos[val->getCarrier()]);
+void ValuableSet::update(const std::vector<cugl::Vec2>& players) {
+    // Carried valuables follow their carrier
+    for (size_t i = 0; i < _positions.size(); ++i) {
+        int carrier = _carriers[i];
+        if (carrier >= 0 && carrier < (int)players.size()) {
+            _positions[i] = players[carrier];
         }
-        val->update(size, val->position);
     }
 }
 
@@ -169,18 +245,12 @@ void ValuableSet::update(Size size, std::vector<cugl::Vec2> pos) {
  */
 void ValuableSet::draw(const std::shared_ptr<SpriteBatch>& batch, Size size) {
     if (_texture) {
-        for (size_t i = 0; i < current.size(); ++i) {
-            std::shared_ptr<ValuableSet::Valuable> val = current[i];
-            float scale = val->getScale();
-            Vec2 pos = val->position;
-            // Vec2 origin(_radius, _radius);
-            Vec2 origin(_width, _height);
-
+        // Vec2 origin(_radius, _radius);
+        Vec2 origin(_width, _height);
+        for (size_t i = 0; i < _positions.size(); ++i) {
             Affine2 trans;
-            trans.scale(scale);
-            trans.translate(pos);
-
-            float r = _radius * scale;
+            trans.scale(_scales[i]);
+            trans.translate(_positions[i]);
             batch->draw(_texture, origin, trans);
         }
     }
@@ -3,130 +3,43 @@
 //
 //  This class implements a collection of valuables.
 //
+//  The valuables are stored as parallel arrays (position, type, scale,
+//  state, carrier), packed so that update and draw walk contiguous memory.
+//  Other objects refer to a valuable by a ValuableId, which stays valid
+//  while the valuable exists and is detected as stale once it is removed.
+//
+//  Notes:
+//  - Removal swaps the last valuable into the hole, so it is O(1) and the
+//    arrays stay packed; ids go through a slot table so they do not change
+//  - An id holds the slot in the low 32 bits and its generation in the high
+//
 #ifndef __VALUABLE_SET_H__
 #define __VALUABLE_SET_H__
 #include <cugl/cugl.h>
 #include <unordered_set>
+#include <vector>
+#include "OccupancyIndex.h"
+#include "TileGrid.h"
+
+/** A stable reference to a valuable */
+typedef Uint64 ValuableId;
+/** The id that refers to no valuable */
+#define NO_VALUABLE ((ValuableId)-1)
 
 /**
  * Model class representing a collection of valuables.
- * 
+ *
  */
 class ValuableSet {
-#pragma mark Valuable
 public:
-    /**
-     * An inner class that represents a single Valuable.
-     *
-     * Valuables come in two different sizes, represented by their types.
-     */
-    class Valuable {
-        // It is okay for the user to access these directly
-    public:
-        /** Valuable position */
-        cugl::Vec2 position;
-
-        enum Status {
-            /** The valuable is at the original position or dropped on floor */
-            FREE,
-            /** The valuable is carried by a player */
-            CARRIED,
-            /** The valuable is stored */
-            STORED,
-        };
-        // But these need to be protected for invariant reasons
-    private:
-        /** The type of the valuable: 1 or 2 */
-        int _type;
-        /** The drawing scale of the valuable (to vary the size) */
-        float _scale;
-        /** Whether the valuable is picked up by a player */
-        Status _state;
-        /** ID of the player who is currently carrying the object */
-        int carrierID = -1;
-        /** The texture for the valuable sprite sheet. */
-        /*std::shared_ptr<cugl::graphics::Texture> _texture;*/
-
-    public:
-        /**
-         * Allocates an valuable by setting its position and type.
-         *
-         *
-         * @param p     The position
-         * @param type  The type (1 or 2)
-         */
-        Valuable(const cugl::Vec2 p, int type);
-
-        /**
-         * Allocates an valuable by setting its position, type and texture.
-         *
-         *
-         * @param p     The position
-         * @param type  The type (1 or 2)
-         * @param texture The texture
-         */
-         /*Valuable(const cugl::Vec2 p, int type, std::shared_ptr<cugl::graphics::Texture> texture);*/
-
-         /**
-          * Returns the scale of this valuable.
-          *
-          * Multiply this scale by the standard valuable radius
-          * ({@link ValuableSet#getRadius}) to get the "true" radius
-          * of a valuable.
-          *
-          * @return the scale of this valuable.
-          */
-        float getScale() const { return _scale; }
-
-        /**
-         * Returns the type of this valuable.
-         *
-         * All valuables have types 1 or 2.  2 is the larger type of
-         * valuable (statues, paintings) (scale 1.25), while 1 is the smaller (vase, jewelry) (scale of 0.5).
-         *
-         * @return the type of this valuable.
-         */
-        int getType() const { return _type; }
-
-        /**
-         * Returns the carrier ID of this valuable. Will return -1 if the valuable is not carried.
-         *
-         * @return the carrier ID of this valuable.
-         */
-        int getCarrier() const { return carrierID; }
-
-        /**
-         * Returns the type of this valuable.
-         *
-         * All valuables have types 1 or 2.  2 is the larger type of
-         * valuable (statues, paintings) (scale 1.25), while 1 is the smaller (vase, jewelry) (scale of 0.5).
-         *
-         * @param type  The type of this valuable.
-         */
-        void setType(int type);
-
-        /*void setTexture(const std::shared_ptr<cugl::graphics::Texture>& value);
-
-        const std::shared_ptr<cugl::graphics::Texture>& getTexture() const {
-            return _texture;
-        }*/
-
-        Status getState() { return _state; }
-
-        /**
-         * Updates the state of this valuable.
-         *
-         *
-         * @param state  The state of this valuable.
-         * @param id     The id of the player carrying this valuable. (should be -1 if the valuable is FREE or STORED)
-         */
-        void setState(Status state, int id = -1);
-
-        /**
-         * Updates the valuable one animation frame
-         */
-        void update(cugl::Size size, cugl::Vec2 pos);
-
+    /** The state of a valuable */
+    enum Status {
+        /** The valuable is at the original position or dropped on floor */
+        FREE,
+        /** The valuable is carried by a player */
+        CARRIED,
+        /** The valuable is stored */
+        STORED,
     };
 
 private:
@@ -136,12 +49,52 @@ private:
     float _radius;
     float _width;
     float _height;
+    /** The tile map the valuables are on */
+    const TileGrid* _grid;
+    /** The free valuables in each cell, by slot (carried valuables are in none) */
+    OccupancyIndex _cells;
+
+    // The packed arrays, one entry per valuable
+    /** Valuable positions */
+    std::vector<cugl::Vec2> _positions;
+    /** The type of each valuable: 1 or 2 */
+    std::vector<Uint8> _types;
+    /** The drawing scale of each valuable (to vary the size) */
+    std::vector<float> _scales;
+    /** The state of each valuable */
+    std::vector<Uint8> _states;
+    /** ID of the player carrying each valuable, or -1 */
+    std::vector<int> _carriers;
+    /** The slot of each valuable */
+    std::vector<Uint32> _slots;
+
+    // The slot table, so that ids survive removals
+    /** The packed index of each slot, or -1 if the slot is free */
+    std::vector<int> _dense;
+    /** The generation of each slot, incremented when its valuable is removed */
+    std::vector<Uint32> _generations;
+    /** The unused slots */
+    std::vector<Uint32> _freeSlots;
+
+    /** Returns the packed index of a valuable, or -1 if the id is stale */
+    int find(ValuableId id) const {
+        Uint32 slot = (Uint32)(id & 0xFFFFFFFF);
+        if (id == NO_VALUABLE || slot >= _dense.size() || _generations[slot] != (Uint32)(id >> 32)) {
+            return -1;
+        }
+        return _dense[slot];
+    }
+
+    /** Returns the id of a slot */
+    ValuableId makeId(Uint32 slot) const {
+        return ((ValuableId)_generations[slot] << 32) | slot;
+    }
+
+    /** Returns the scale of a valuable type */
+    static float scaleOf(int type);
 
 #pragma mark The Set
 public:
-    /** The collection of all ACTIVE valuables. Allow the user direct access */
-    std::vector<std::shared_ptr<Valuable>> current;
-
     /**
      * Creates a valuable set with the default values.
      *
@@ -162,17 +115,25 @@ public:
      * valuable data.
      *
      * @param data  The data defining the valuable settings
+     * @param grid  The tile map the valuables are on
      *
      * @return true if initialization was successful
      */
-    bool init(std::shared_ptr<cugl::JsonValue> data);
+    bool init(std::shared_ptr<cugl::JsonValue> data, const TileGrid& grid);
 
     /**
      * Returns true if the valuable set is empty.
      *
      * @return true if the valuable set is empty.
      */
-    bool isEmpty() const { return current.empty(); }
+    bool isEmpty() const { return _positions.empty(); }
+
+    /**
+     * Returns the number of valuables.
+     *
+     * @return the number of valuables
+     */
+    size_t size() const { return _positions.size(); }
 
     /**
      * Returns the default radius of a valuable
@@ -190,26 +151,115 @@ public:
     void setTexture(const std::shared_ptr<cugl::graphics::Texture>& value);
 
     /**
-     * Adds a valuable to the active queue.
+     * Adds a valuable to the set.
      *
      * @param p     The valuable position.
-     * @param type  The valuable type.
+     * @param type  The valuable type (1 or 2).
+     *
+     * @return the id of the new valuable
+     */
+    ValuableId spawnValuable(cugl::Vec2 p, int type);
+
+    /**
+     * Removes a valuable from the set in O(1).
+     *
+     * Every id of the valuable becomes stale.
+     *
+     * @param id    The valuable id
+     *
+     * @return true if the valuable existed
+     */
+    bool removeValuable(ValuableId id);
+
+    /**
+     * Returns true if the id refers to a valuable in the set.
+     *
+     * @param id    The valuable id
+     *
+     * @return true if the id refers to a valuable in the set
+     */
+    bool isValid(ValuableId id) const { return find(id) != -1; }
+
+#pragma mark Attributes
+    /**
+     * Returns the position of a valuable.
+     *
+     * @param id    The valuable id (which must be valid)
+     *
+     * @return the position of a valuable
+     */
+    const cugl::Vec2& getPosition(ValuableId id) const { return _positions[find(id)]; }
+
+    /**
+     * Returns the type of a valuable.
+     *
+     * All valuables have types 1 or 2.  2 is the larger type of
+     * valuable (statues, paintings) (scale 1.25), while 1 is the smaller (vase, jewelry) (scale of 0.5).
+     *
+     * @param id    The valuable id (which must be valid)
+     *
+     * @return the type of a valuable
+     */
+    int getType(ValuableId id) const { return _types[find(id)]; }
+
+    /**
+     * Returns the state of a valuable.
+     *
+     * @param id    The valuable id (which must be valid)
+     *
+     * @return the state of a valuable
      */
-    void spawnValuable(cugl::Vec2 p, int type);
+    Status getState(ValuableId id) const { return (Status)_states[find(id)]; }
 
     /**
-     * Updates all the valuables in the active set.
+     * Returns the carrier ID of a valuable. Will return -1 if the valuable is not carried.
      *
+     * @param id    The valuable id (which must be valid)
+     *
+     * @return the carrier ID of a valuable
      */
-    void update(cugl::Size size, std::vector<cugl::Vec2> pos);
+    int getCarrier(ValuableId id) const { return _carriers[find(id)]; }
 
-    /** sets the val with id to carrier id = -1 */
-    void set_val_dropped(int val_id) { current[val_id]->setState(Valuable::Status::FREE, -1); }
+#pragma mark Updates
+    /**
+     * Updates all the valuables in the set.
+     *
+     * Carried valuables follow their carrier.
+     *
+     * @param players   The positions of the players, indexed by player id
+     */
+    void update(const std::vector<cugl::Vec2>& players);
+
+    /** sets the val with id to carrier id = -1, and puts it in the cell where it was dropped */
+    void set_val_dropped(ValuableId val_id);
+
+    /** sets the val with id to be carried, and takes it out of its cell */
+    void set_val_carried(ValuableId val_id, int carrier_id);
+
+    /**
+     * Returns the first free valuable in the cell of a position, or NO_VALUABLE.
+     *
+     * @param pos   The world position
+     *
+     * @return the first free valuable in the cell of a position
+     */
+    ValuableId findFree(const cugl::Vec2& pos) const {
+        int cell = _grid != nullptr ? _grid->toCell(pos) : -1;
+        int slot = cell == -1 ? -1 : _cells.first(cell);
+        return slot == -1 ? NO_VALUABLE : makeId((Uint32)slot);
+    }
+
+    /**
+     * Returns the index of the free valuables in each cell, by slot.
+     *
+     * @return the index of the free valuables in each cell
+     */
+    const OccupancyIndex& getCells() const { return _cells; }
 
     /**
      * Draws all active valuables to the sprite batch within the given bounds.
      *
-     * Stored asteroids are not drawn.
+     * Stored valuables are not drawn.
      *
      * @param batch     The sprite batch to draw to
      * @param size      The size of the window (for wrap around)
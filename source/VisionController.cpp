@@ -0,0 +1,167 @@
+//
+//  VisionController.cpp
+//  Demo
+//
+//  This is the implementation for the VisionController class.
+//
+#include "VisionController.h"
+#include <algorithm>
+
+using namespace cugl;
+
+/**
+ * The transforms of the eight octants.
+ *
+ * Octant i maps a scan position (dx, dy) to the map offset
+ * (dx*XX[i] + dy*XY[i], dx*YX[i] + dy*YY[i]), in (column, row).
+ */
+static const int OCTANT_XX[] = { 1,  0,  0, -1, -1,  0,  0,  1 };
+static const int OCTANT_XY[] = { 0,  1, -1,  0,  0, -1,  1,  0 };
+static const int OCTANT_YX[] = { 0,  1,  1,  0,  0, -1, -1,  0 };
+static const int OCTANT_YY[] = { 1,  0,  0,  1, -1,  0,  0, -1 };
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Initializes the controller for a map.
+ */
+bool VisionController::init(const TileGrid& grid, int range) {
+    if (range <= 0) {
+        return false;
+    }
+    _grid = &grid;
+    _range = range;
+    clear();
+    return true;
+}
+
+/**
+ * Drops every view.
+ */
+void VisionController::clear() {
+    _words = _grid == nullptr ? 0 : (_grid->size()+TILE_WORD_BITS-1)/TILE_WORD_BITS;
+    _revision = _grid == nullptr ? 0 : _grid->getRevision();
+    _views.clear();
+    _cells.clear();
+    _facings.clear();
+    _seen.assign(_words, 0);
+}
+
+#pragma mark -
+#pragma mark Updates
+/**
+ * Brings the views up to date with the guards.
+ */
+size_t VisionController::update(const std::vector<Guard>& guards) {
+    if (_grid == nullptr) {
+        return 0;
+    }
+    // New walls (or a new map) make every view stale
+    if (_revision != _grid->getRevision() || _words != (_grid->size()+TILE_WORD_BITS-1)/TILE_WORD_BITS) {
+        clear();
+    }
+    bool resized = guards.size() != _cells.size();
+    if (resized) {
+        _views.resize(guards.size()*_words, 0);
+        _cells.resize(guards.size(), -1);
+        _facings.resize(guards.size(), Direction::None);
+    }
+
+    size_t computed = 0;
+    for (size_t ii = 0; ii < guards.size(); ii++) {
+        const Guard& guard = guards[ii];
+        if (guard.getCell() != _cells[ii] || guard.getFacing() != _facings[ii]) {
+            compute(ii, guard.getCell(), guard.getFacing());
+            computed++;
+        }
+    }
+
+    if (computed > 0 || resized) {
+        std::fill(_seen.begin(), _seen.end(), 0);
+        for (size_t ii = 0; ii < guards.size(); ii++) {
+            const Uint64* view = _views.data()+ii*_words;
+            for (size_t word = 0; word < _words; word++) {
+                _seen[word] |= view[word];
+            }
+        }
+    }
+    _recomputes += computed;
+    return computed;
+}
+
+/**
+ * Computes the view of one guard.
+ */
+void VisionController::compute(size_t guard, int cell, Direction facing) {
+    Uint64* bits = _views.data()+guard*_words;
+    std::fill(bits, bits+_words, 0);
+    _cells[guard] = cell;
+    _facings[guard] = facing;
+    if (cell < 0 || cell >= (int)_grid->size()) {
+        return;
+    }
+    setTileBit(bits, (size_t)cell, true);
+
+    int fx = facing == Direction::Right ? 1 : (facing == Direction::Left ? -1 : 0);
+    int fy = facing == Direction::Up ? 1 : (facing == Direction::Down ? -1 : 0);
+    int row = cell/_grid->getCols();
+    int col = cell%_grid->getCols();
+    for (int oct = 0; oct < 8; oct++) {
+        // The octant looks along (-XY, -YY); keep the two around the facing
+        if (facing != Direction::None && (-OCTANT_XY[oct] != fx || -OCTANT_YY[oct] != fy)) {
+            continue;
+        }
+        castLight(bits, row, col, 1, 1.0f, 0.0f,
+                  OCTANT_XX[oct], OCTANT_XY[oct], OCTANT_YX[oct], OCTANT_YY[oct]);
+    }
+}
+
+/**
+ * Lights one octant of a view, recursing around the walls.
+ */
+void VisionController::castLight(Uint64* bits, int row, int col, int depth, float start, float end,
+                                 int xx, int xy, int yx, int yy) const {
+    if (start < end) {
+        return;
+    }
+    int radius2 = _range*_range;
+    float nextStart = start;
+    for (int jj = depth; jj <= _range; jj++) {
+        int dy = -jj;
+        bool blocked = false;
+        for (int dx = -jj; dx <= 0; dx++) {
+            float leftSlope = (dx-0.5f)/(dy+0.5f);
+            float rightSlope = (dx+0.5f)/(dy-0.5f);
+            if (start < rightSlope) {
+                continue;
+            } else if (end > leftSlope) {
+                break;
+            }
+
+            int c = col+dx*xx+dy*xy;
+            int r = row+dx*yx+dy*yy;
+            bool inside = (unsigned)r < (unsigned)_grid->getRows() && (unsigned)c < (unsigned)_grid->getCols();
+            if (inside && dx*dx+dy*dy <= radius2) {
+                setTileBit(bits, _grid->toIndex(r, c), true);
+            }
+
+            // Walls (and the edge of the map) block the light behind them
+            bool opaque = !inside || !_grid->isWalkable(r, c);
+            if (blocked) {
+                if (opaque) {
+                    nextStart = rightSlope;
+                } else {
+                    blocked = false;
+                    start = nextStart;
+                }
+            } else if (opaque && jj < _range) {
+                blocked = true;
+                castLight(bits, row, col, jj+1, start, leftSlope, xx, xy, yx, yy);
+                nextStart = rightSlope;
+            }
+        }
+        if (blocked) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,159 @@
+//
+//  VisionController.h
+//  Demo
+//
+//  This class tracks what the guards can see. The field of view of each
+//  guard is a bitset over the tile grid, computed with recursive
+//  shadowcasting (walls cast shadows, everything else is see-through). The
+//  union of all the views is kept as one more bitset, so asking whether a
+//  player is seen by anyone is a single bit test on the player's cell.
+//
+//  Notes:
+//  - A view is only recomputed when its guard moves or turns, or when the
+//    walls change; this is meant to run on beat ticks, not every frame
+//  - A guard sees a 90 degree cone (the two octants around its facing)
+//    out to the vision range, plus its own cell
+//  - The views are stored back to back in one array, a row of words per
+//    guard, so the union is a straight pass over memory
+//
+#ifndef __VISION_CONTROLLER_H__
+#define __VISION_CONTROLLER_H__
+#include <cugl/cugl.h>
+#include <vector>
+#include "Direction.h"
+#include "TileGrid.h"
+#include "Guard.h"
+
+/**
+ * The guard line-of-sight controller.
+ */
+class VisionController {
+private:
+    /** The tile map */
+    const TileGrid* _grid;
+    /** The vision range in tiles */
+    int _range;
+    /** The tile revision the views were computed for */
+    Uint32 _revision;
+    /** The number of words in one bitset */
+    size_t _words;
+    /** The view of each guard, _words per guard */
+    std::vector<Uint64> _views;
+    /** The cell each view was computed from (-1 if never computed) */
+    std::vector<int> _cells;
+    /** The facing each view was computed for */
+    std::vector<Direction> _facings;
+    /** The cells seen by any guard */
+    std::vector<Uint64> _seen;
+    /** The number of views computed so far */
+    Uint64 _recomputes;
+
+    /**
+     * Computes the view of one guard.
+     *
+     * @param guard     The guard index
+     * @param cell      The cell of the guard
+     * @param facing    The facing of the guard
+     */
+    void compute(size_t guard, int cell, Direction facing);
+
+    /**
+     * Lights one octant of a view, recursing around the walls.
+     *
+     * This is the recursive shadowcasting scan: it walks the rows of the
+     * octant from near to far, keeping the slopes between which light still
+     * gets through.
+     *
+     * @param bits      The view bitset
+     * @param row       The row of the guard
+     * @param col       The column of the guard
+     * @param depth     The first row of the octant to scan
+     * @param start     The slope where the light starts
+     * @param end       The slope where the light ends
+     * @param xx        The octant transform
+     * @param xy        The octant transform
+     * @param yx        The octant transform
+     * @param yy        The octant transform
+     */
+    void castLight(Uint64* bits, int row, int col, int depth, float start, float end,
+                   int xx, int xy, int yx, int yy) const;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates a controller with no map.
+     */
+    VisionController() : _grid(nullptr), _range(0), _revision(0), _words(0), _recomputes(0) {}
+
+    /**
+     * Initializes the controller for a map.
+     *
+     * @param grid  The tile map (which must outlive the controller)
+     * @param range The vision range in tiles
+     *
+     * @return true if initialization was successful
+     */
+    bool init(const TileGrid& grid, int range);
+
+    /**
+     * Drops every view.
+     */
+    void clear();
+
+#pragma mark -
+#pragma mark Updates
+    /**
+     * Brings the views up to date with the guards.
+     *
+     * Only the guards that moved or turned (or every guard, if the walls
+     * changed) are recomputed, and the union only if one of them was.
+     *
+     * @param guards    The guards of the level
+     *
+     * @return the number of views recomputed
+     */
+    size_t update(const std::vector<Guard>& guards);
+
+#pragma mark -
+#pragma mark Queries
+    /**
+     * Returns true if a guard can see a cell.
+     *
+     * @param guard The guard index
+     * @param cell  The cell index
+     *
+     * @return true if a guard can see a cell
+     */
+    bool canSee(size_t guard, int cell) const {
+        return guard < _cells.size() && (unsigned)cell < (unsigned)(_words*TILE_WORD_BITS) &&
+               testTileBit(_views.data()+guard*_words, (size_t)cell);
+    }
+
+    /**
+     * Returns true if any guard can see a cell.
+     *
+     * @param cell  The cell index
+     *
+     * @return true if any guard can see a cell
+     */
+    bool isSeen(int cell) const {
+        return (unsigned)cell < (unsigned)(_words*TILE_WORD_BITS) && testTileBit(_seen.data(), (size_t)cell);
+    }
+
+    /**
+     * Returns the vision range in tiles.
+     *
+     * @return the vision range in tiles
+     */
+    int getRange() const { return _range; }
+
+    /**
+     * Returns the number of views computed so far.
+     *
+     * @return the number of views computed so far
+     */
+    Uint64 getRecomputes() const { return _recomputes; }
+};
+
+#endif /* __VISION_CONTROLLER_H__ */
@@ -0,0 +1,75 @@
+//
+//  BenchMain.h
+//  Demo tests
+//
+//  A minimal benchmark harness. Each BENCH registers a function, and
+//  runBenchmarks runs every benchmark (or only the ones named on the
+//  command line). The benchmarks print their own numbers.
+//
+#ifndef __BENCH_MAIN_H__
+#define __BENCH_MAIN_H__
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/** A registered benchmark */
+struct BenchCase {
+    /** The name of the benchmark */
+    const char* name;
+    /** The benchmark function */
+    void (*run)();
+};
+
+/** Returns every registered benchmark */
+inline std::vector<BenchCase>& benchCases() {
+    static std::vector<BenchCase> cases;
+    return cases;
+}
+
+/** Registers a benchmark when the program starts */
+struct BenchRegistrar {
+    BenchRegistrar(const char* name, void (*run)()) { benchCases().push_back({name, run}); }
+};
+
+#define BENCH(name) \
+    static void bench_##name(); \
+    static BenchRegistrar register_##name(#name, bench_##name); \
+    static void bench_##name()
+
+/**
+ * Returns the time a function takes, in milliseconds.
+ *
+ * @param func  The function to time
+ *
+ * @return the time the function takes, in milliseconds
+ */
+template <typename F>
+double timeMillis(F&& func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+
+/**
+ * Runs the benchmarks named on the command line, or all of them.
+ *
+ * @return 0 if every name was found, and 1 otherwise
+ */
+inline int runBenchmarks(int argc, char** argv) {
+    int found = 0;
+    for (const BenchCase& bench : benchCases()) {
+        bool wanted = argc <= 1;
+        for (int ii = 1; ii < argc; ii++) {
+            wanted = wanted || std::strcmp(argv[ii], bench.name) == 0;
+        }
+        if (wanted) {
+            std::printf("== %s\n", bench.name);
+            bench.run();
+            found++;
+        }
+    }
+    return argc <= 1 || found == argc-1 ? 0 : 1;
+}
+
+#endif /* __BENCH_MAIN_H__ */
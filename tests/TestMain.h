@@ -0,0 +1,66 @@
+//
+//  TestMain.h
+//  Demo tests
+//
+//  A minimal test harness. Each TEST registers a function, each CHECK that
+//  fails is reported with its line, and runTests runs every test and
+//  returns the exit code for CTest.
+//
+#ifndef __TEST_MAIN_H__
+#define __TEST_MAIN_H__
+#include <cstdio>
+#include <vector>
+
+/** A registered test */
+struct TestCase {
+    /** The name of the test */
+    const char* name;
+    /** The test function */
+    void (*run)();
+};
+
+/** Returns every registered test */
+inline std::vector<TestCase>& testCases() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+/** Returns the number of failed checks so far */
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+/** Registers a test when the program starts */
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*run)()) { testCases().push_back({name, run}); }
+};
+
+#define TEST(name) \
+    static void test_##name(); \
+    static TestRegistrar register_##name(#name, test_##name); \
+    static void test_##name()
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            testFailures()++; \
+        } \
+    } while (0)
+
+/**
+ * Runs every registered test.
+ *
+ * @return 0 if every check passed, and 1 otherwise
+ */
+inline int runTests() {
+    for (const TestCase& test : testCases()) {
+        int before = testFailures();
+        test.run();
+        std::printf("%s %s\n", testFailures() == before ? "PASS" : "FAIL", test.name);
+    }
+    return testFailures() == 0 ? 0 : 1;
+}
+
+#endif /* __TEST_MAIN_H__ */
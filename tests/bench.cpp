@@ -0,0 +1,415 @@
+//
+//  bench.cpp
+//  Demo tests
+//
+//  Benchmarks for the headless game logic, on maps and entity counts well
+//  beyond a real level. Run with the names of the benchmarks to run, or
+//  with no arguments to run them all.
+//
+#include <cugl/cugl.h>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include "BenchMain.h"
+#include "GameSimulation.h"
+#include "GestureRecognizer.h"
+#include "Guard.h"
+#include "InputRecording.h"
+#include "NavigationController.h"
+#include "NoiseField.h"
+#include "TempoMap.h"
+#include "VisionController.h"
+#include "TileGrid.h"
+#include "ValuableSet.h"
+
+using namespace cugl;
+
+/** The side of the benchmark maps, in tiles */
+#define BENCH_MAP   256
+
+/** Returns a benchmark map with random walls */
+static void randomMap(TileGrid& grid, int walls) {
+    grid.init(BENCH_MAP, BENCH_MAP, 1.0f);
+    for (int ii = 0; ii < walls; ii++) {
+        grid.setType(rand() % BENCH_MAP, rand() % BENCH_MAP, TileType::WALL);
+    }
+}
+
+/** Returns a random open cell of a map */
+static int randomCell(const TileGrid& grid) {
+    int cell;
+    do {
+        cell = rand() % (int)grid.size();
+    } while (!grid.isWalkable((size_t)cell));
+    return cell;
+}
+
+/** Returns a random position on a benchmark map */
+static Vec2 randomPosition() {
+    return Vec2((float)(rand() % (BENCH_MAP*100))/100.0f, (float)(rand() % (BENCH_MAP*100))/100.0f);
+}
+
+BENCH(pickups) {
+    // 10000 valuables, looked up by cell and by a scan of every valuable
+    const int count = 10000;
+    const int lookups = 100000;
+    srand(1);
+    TileGrid grid;
+    grid.init(BENCH_MAP, BENCH_MAP, 1.0f);
+    ValuableSet valuables;
+    valuables.init(std::make_shared<JsonValue>(), grid);
+    std::vector<ValuableId> ids;
+    std::vector<Vec2> positions;
+    for (int ii = 0; ii < count; ii++) {
+        positions.push_back(randomPosition());
+        ids.push_back(valuables.spawnValuable(positions.back(), 1+ii%2));
+    }
+    std::vector<Vec2> queries;
+    for (int ii = 0; ii < lookups; ii++) {
+        queries.push_back(randomPosition());
+    }
+
+    size_t hits = 0;
+    double indexed = timeMillis([&]() {
+        for (const Vec2& query : queries) {
+            hits += valuables.findFree(query) != NO_VALUABLE;
+        }
+    });
+    size_t scanHits = 0;
+    double scanned = timeMillis([&]() {
+        for (const Vec2& query : queries) {
+            int cell = grid.toCell(query);
+            for (const Vec2& pos : positions) {
+                if (grid.toCell(pos) == cell) {
+                    scanHits++;
+                    break;
+                }
+            }
+        }
+    });
+    std::printf("findFree: %.1f ns per lookup (%zu hits), scan: %.1f ns (%zu hits)\n",
+                indexed*1e6/lookups, hits, scanned*1e6/lookups, scanHits);
+
+    // Pick up and drop in place, as a player does
+    double cycled = timeMillis([&]() {
+        for (int ii = 0; ii < lookups; ii++) {
+            ValuableId id = ids[ii % count];
+            valuables.set_val_carried(id, 0);
+            valuables.set_val_dropped(id);
+        }
+    });
+    std::printf("carry and drop: %.1f ns per pair\n", cycled*1e6/lookups);
+}
+
+BENCH(valuables) {
+    // 10000 valuables, a tenth of them carried by 4 players
+    const int count = 10000;
+    const int updates = 10000;
+    srand(2);
+    TileGrid grid;
+    grid.init(BENCH_MAP, BENCH_MAP, 1.0f);
+    ValuableSet valuables;
+    valuables.init(std::make_shared<JsonValue>(), grid);
+    std::vector<ValuableId> ids;
+    for (int ii = 0; ii < count; ii++) {
+        ids.push_back(valuables.spawnValuable(randomPosition(), 1+ii%2));
+        if (ii % 10 == 0) {
+            valuables.set_val_carried(ids.back(), ii % 4);
+        }
+    }
+    std::vector<Vec2> players(4);
+
+    double packed = timeMillis([&]() {
+        for (int ii = 0; ii < updates; ii++) {
+            players[ii % 4] = randomPosition();
+            valuables.update(players);
+        }
+    });
+
+    // The same update over one shared_ptr per valuable, copying each pointer
+    // as the loop did before the set was packed
+    struct Valuable {
+        Vec2 position;
+        int carrier;
+    };
+    std::vector<std::shared_ptr<Valuable>> pointers;
+    for (int ii = 0; ii < count; ii++) {
+        pointers.push_back(std::make_shared<Valuable>(Valuable{randomPosition(), ii % 10 == 0 ? ii % 4 : -1}));
+    }
+    double pointed = timeMillis([&]() {
+        for (int ii = 0; ii < updates; ii++) {
+            players[ii % 4] = randomPosition();
+            for (auto it = pointers.begin(); it != pointers.end(); ++it) {
+                std::shared_ptr<Valuable> valuable = *it;
+                if (valuable->carrier >= 0) {
+                    valuable->position = players[valuable->carrier];
+                }
+            }
+        }
+    });
+    std::printf("update: %.1f us packed, %.1f us through shared_ptr\n",
+                packed*1e3/updates, pointed*1e3/updates);
+
+    // Remove and respawn, as a level that changes its valuables would
+    double churned = timeMillis([&]() {
+        for (int ii = 0; ii < updates; ii++) {
+            int index = rand() % count;
+            valuables.removeValuable(ids[index]);
+            ids[index] = valuables.spawnValuable(randomPosition(), 1);
+        }
+    });
+    std::printf("remove and spawn: %.1f ns per pair, %zu valuables\n", churned*1e6/updates, valuables.size());
+}
+
+BENCH(navigation) {
+    // 100 guards chasing one target through random walls
+    const int beats = 1000;
+    srand(3);
+    TileGrid grid;
+    randomMap(grid, 8000);
+    NavigationController nav;
+    nav.init(grid, true);
+    std::vector<Guard> guards;
+    for (int ii = 0; ii < 100; ii++) {
+        guards.emplace_back(ii, randomCell(grid), std::vector<int>());
+    }
+    int target = randomCell(grid);
+    for (Guard& guard : guards) {
+        guard.chase(target);
+    }
+
+    long steps = 0;
+    double elapsed = timeMillis([&]() {
+        for (int beat = 0; beat < beats; beat++) {
+            for (Guard& guard : guards) {
+                Direction dir = guard.steer(nav);
+                if (dir != Direction::None) {
+                    guard.moveTo(grid.neighbor(guard.getCell(), dir), grid);
+                    steps++;
+                }
+            }
+        }
+    });
+    std::printf("steering: %.2f us per beat, %ld steps, %llu field builds\n",
+                elapsed*1e3/beats, steps, (unsigned long long)nav.getRebuilds());
+}
+
+BENCH(vision) {
+    // 200 guards taking random steps, with their views and the union
+    const int beats = 200;
+    srand(1);
+    TileGrid grid;
+    randomMap(grid, 6000);
+    VisionController vision;
+    vision.init(grid, 8);
+    std::vector<Guard> guards;
+    for (int ii = 0; ii < 200; ii++) {
+        guards.emplace_back(ii, randomCell(grid), std::vector<int>());
+    }
+
+    size_t views = 0;
+    double elapsed = timeMillis([&]() {
+        for (int beat = 0; beat < beats; beat++) {
+            for (Guard& guard : guards) {
+                int next = grid.neighbor(guard.getCell(), (Direction)(rand() % 4));
+                if (next != -1 && grid.isWalkable((size_t)next)) {
+                    guard.moveTo(next, grid);
+                }
+            }
+            views += vision.update(guards);
+        }
+    });
+    std::printf("views: %.3f ms per beat, %zu views computed\n", elapsed/beats, views);
+}
+
+BENCH(noise) {
+    // 20 noises a beat through random walls, with the default budget
+    const int beats = 1000;
+    srand(2);
+    TileGrid grid;
+    randomMap(grid, 6000);
+    NoiseField noise;
+    noise.init(grid, 0.7f, 3, 4096);
+
+    size_t most = 0;
+    double elapsed = timeMillis([&]() {
+        for (int beat = 0; beat < beats; beat++) {
+            for (int ii = 0; ii < 20; ii++) {
+                noise.emit(rand() % (int)grid.size(), 2+rand() % 10);
+            }
+            most = std::max(most, noise.step());
+        }
+    });
+    std::printf("spreading: %.3f ms per beat, at most %zu of %zu cells, %zu waiting\n",
+                elapsed/beats, most, noise.getBudget(), noise.getPending());
+}
+
+BENCH(replay) {
+    // A recorded session of three minutes at 120 BPM, replayed at 60 steps
+    // a second through GameSimulation (what GameScene::replay runs): a
+    // judged swipe on every beat, and 20 guards that steer, see and hear.
+    const SongTime length = SongTime::fromSeconds(180);
+    const SongTime step = SongTime::fromSeconds(1.0/60);
+    srand(4);
+    TempoMap tempo;
+    tempo.init(SongTime::fromBPM(120));
+    TileGrid grid;
+    grid.init(64, 64, 1.0f);
+    for (int ii = 0; ii < 300; ii++) {
+        grid.setType(rand() % 64, rand() % 64, TileType::WALL);
+    }
+    std::vector<Guard> guards;
+    for (int ii = 0; ii < 20; ii++) {
+        guards.emplace_back(ii, randomCell(grid), std::vector<int>());
+    }
+    ValuableSet valuables;
+    valuables.init(std::make_shared<JsonValue>(), grid);
+    int start = randomCell(grid);
+    GameSimulation sim;
+    sim.init(std::make_shared<JsonValue>(), grid, tempo, "");
+    sim.setStart(0, grid.toWorld(start/64, start%64), guards, valuables);
+
+    // The recorded swipes, a little off every beat and decided 80 ms later
+    InputRecording recording;
+    recording.start(4, SongTime());
+    for (Sint64 beat = 0; tempo.getBeatTime(beat) < length; beat++) {
+        Gesture gesture;
+        gesture.type = (GestureType)((int)GestureType::Up+rand() % 4);
+        gesture.start.touch = 0;
+        gesture.startTime = tempo.getBeatTime(beat)+SongTime::fromMillis(rand() % 60-30);
+        gesture.endTime = gesture.startTime+SongTime::fromMillis(80);
+        recording.addGesture(gesture);
+    }
+
+    double elapsed = timeMillis([&]() {
+        sim.replay(recording, step);
+    });
+    std::printf("three minutes: %.2f ms, %d inputs judged, score %llu, player in cell %d\n",
+                elapsed, sim.getStats().getCount(), (unsigned long long)sim.getJudge().getScore(),
+                sim.getCell());
+}
+
+/** One sample of a synthetic touch */
+struct TouchSample {
+    /** The touch position in screen coordinates */
+    Vec2 position;
+    /** The time of the sample */
+    Timestamp stamp;
+    /** The time of the sample after touch-down, in milliseconds */
+    Uint64 millis;
+};
+
+/**
+ * Returns a synthetic touch sampled at 125 Hz, from touch-down to release.
+ *
+ * A third are taps (a little jitter, under 150 ms), and the rest are
+ * swipes of 60 to 300 pixels over 80 to 250 ms, easing out as a finger
+ * does, in a random direction and with some drift off the axis.
+ */
+static std::vector<TouchSample> randomTrace(const Timestamp& zero) {
+    bool tap = rand() % 3 == 0;
+    int duration = tap ? 40+rand() % 100 : 80+rand() % 170;
+    float length = tap ? 0.0f : (float)(60+rand() % 240);
+    Vec2 axis = rand() % 2 == 0 ? Vec2(rand() % 2 == 0 ? 1.0f : -1.0f, 0.0f) : Vec2(0.0f, rand() % 2 == 0 ? 1.0f : -1.0f);
+    Vec2 drift(axis.y, axis.x);
+    float off = tap ? 0.0f : (float)(rand() % 41-20)/100.0f;
+    Vec2 origin((float)(rand() % 1000), (float)(rand() % 1000));
+
+    std::vector<TouchSample> trace;
+    for (int millis = 0; ; millis += 8) {
+        millis = std::min(millis, duration);
+        float progress = (float)millis/duration;
+        float eased = 1.0f-(1.0f-progress)*(1.0f-progress);
+        Vec2 jitter((float)(rand() % 5-2), (float)(rand() % 5-2));
+        TouchSample sample;
+        sample.position = origin+(axis+drift*off)*(length*eased)+jitter;
+        sample.stamp = zero;
+        sample.stamp += (Uint64)millis;
+        sample.millis = (Uint64)millis;
+        trace.push_back(sample);
+        if (millis == duration) {
+            break;
+        }
+    }
+    return trace;
+}
+
+/**
+ * Returns the gesture of a touch by the rule used before the recognizer.
+ *
+ * Only the touch-down and release points were compared: a tap within
+ * 15 pixels, and otherwise a swipe along the larger axis.
+ */
+static GestureType releaseRule(const Vec2& first, const Vec2& last) {
+    if (first.distanceSquared(last) <= 225) {
+        return GestureType::Tap;
+    }
+    Vec2 offset = last-first;
+    if (std::abs(offset.x) > std::abs(offset.y)) {
+        return offset.x >= 0 ? GestureType::Right : GestureType::Left;
+    }
+    return offset.y <= 0 ? GestureType::Up : GestureType::Down;
+}
+
+BENCH(gestures) {
+    // 20000 synthetic touches through both classifiers, with every sample
+    const int count = 20000;
+    srand(5);
+    Timestamp zero;
+    std::vector<std::vector<TouchSample>> traces;
+    for (int ii = 0; ii < count; ii++) {
+        traces.push_back(randomTrace(zero));
+    }
+
+    // The release rule decides on the release, whatever the samples were
+    std::vector<GestureType> before(count);
+    Uint64 beforeLatency = 0;
+    double beforeTime = timeMillis([&]() {
+        for (int ii = 0; ii < count; ii++) {
+            const std::vector<TouchSample>& trace = traces[ii];
+            before[ii] = releaseRule(trace.front().position, trace.back().position);
+            beforeLatency += trace.back().millis;
+        }
+    });
+
+    // The recognizer sees every sample, and may decide before the release
+    std::vector<GestureType> after(count);
+    Uint64 afterLatency = 0;
+    double afterTime = timeMillis([&]() {
+        GestureRecognizer recognizer;
+        for (int ii = 0; ii < count; ii++) {
+            const std::vector<TouchSample>& trace = traces[ii];
+            recognizer.begin(trace.front().position, trace.front().stamp);
+            GestureType type = GestureType::Undecided;
+            size_t jj = 1;
+            for (; jj+1 < trace.size() && type == GestureType::Undecided; jj++) {
+                type = recognizer.hold(trace[jj].stamp);
+                if (type == GestureType::Undecided) {
+                    type = recognizer.move(trace[jj].position, trace[jj].stamp);
+                }
+            }
+            if (type == GestureType::Undecided) {
+                type = recognizer.end(trace.back().position);
+                jj = trace.size();
+            } else {
+                recognizer.end(trace.back().position);
+            }
+            after[ii] = type;
+            afterLatency += trace[jj-1].millis;
+        }
+    });
+
+    int agree = 0;
+    for (int ii = 0; ii < count; ii++) {
+        agree += before[ii] == after[ii];
+    }
+    std::printf("release rule: %.1f ns per gesture, decided %.1f ms after touch-down\n",
+                beforeTime*1e6/count, (double)beforeLatency/count);
+    std::printf("recognizer:   %.1f ns per gesture, decided %.1f ms after touch-down\n",
+                afterTime*1e6/count, (double)afterLatency/count);
+    std::printf("same gesture for %d of %d touches\n", agree, count);
+}
+
+int main(int argc, char** argv) {
+    return runBenchmarks(argc, argv);
+}
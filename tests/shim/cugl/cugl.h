@@ -0,0 +1,169 @@
+//
+//  cugl.h
+//  Demo tests
+//
+//  A stand-in for the parts of CUGL that the game logic uses, so that the
+//  tests and benchmarks build on a machine without CUGL. Only the headless
+//  classes (the ones with no window, audio or input device) are built
+//  against this header; anything that draws is a no-op here.
+//
+//  Notes:
+//  - Timestamp is real (on the steady clock), as the tests time things
+//  - JsonValue is always empty, so the initializers that read JSON take
+//    their defaults
+//  - BinaryReader reads plain files, so recordings round-trip on disk
+//
+#ifndef __CUGL_SHIM_H__
+#define __CUGL_SHIM_H__
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef uint8_t  Uint8;
+typedef uint16_t Uint16;
+typedef uint32_t Uint32;
+typedef uint64_t Uint64;
+typedef int8_t   Sint8;
+typedef int16_t  Sint16;
+typedef int32_t  Sint32;
+typedef int64_t  Sint64;
+
+#define CULog(...)              ((void)0)
+#define CUAssertLog(cond, ...)  ((void)0)
+
+namespace cugl {
+
+/** A 2d vector, with only the operations the game logic uses */
+struct Vec2 {
+    float x, y;
+    static const Vec2 ZERO;
+
+    Vec2() : x(0), y(0) {}
+    Vec2(float x, float y) : x(x), y(y) {}
+
+    Vec2 operator+(const Vec2& v) const { return Vec2(x+v.x, y+v.y); }
+    Vec2 operator-(const Vec2& v) const { return Vec2(x-v.x, y-v.y); }
+    Vec2 operator*(float s) const { return Vec2(x*s, y*s); }
+    Vec2& operator+=(const Vec2& v) { x += v.x; y += v.y; return *this; }
+    Vec2& operator*=(float s) { x *= s; y *= s; return *this; }
+    bool operator==(const Vec2& v) const { return x == v.x && y == v.y; }
+    bool operator!=(const Vec2& v) const { return !(*this == v); }
+
+    float lengthSquared() const { return x*x+y*y; }
+    float length() const { return std::sqrt(lengthSquared()); }
+    float distanceSquared(const Vec2& v) const { return (*this-v).lengthSquared(); }
+};
+inline const Vec2 Vec2::ZERO;
+
+/** A 2d size */
+struct Size {
+    float width, height;
+    Size() : width(0), height(0) {}
+    Size(float width, float height) : width(width), height(height) {}
+};
+
+/** A 2d transform (drawing is a no-op, so this is never applied) */
+struct Affine2 {
+    void scale(float) {}
+    void translate(const Vec2&) {}
+};
+
+/** A color (drawing is a no-op, so this is never used) */
+struct Color4 {
+    static const Color4 RED;
+};
+inline const Color4 Color4::RED;
+
+/** A point in time on the steady clock */
+class Timestamp {
+private:
+    std::chrono::steady_clock::time_point _time;
+
+public:
+    Timestamp() { mark(); }
+    void mark() { _time = std::chrono::steady_clock::now(); }
+
+    Timestamp& operator+=(Uint64 millis) { _time += std::chrono::milliseconds(millis); return *this; }
+    Timestamp& operator-=(Uint64 millis) { _time -= std::chrono::milliseconds(millis); return *this; }
+
+    static Uint64 ellapsedNanos(const Timestamp& start, const Timestamp& end) {
+        return (Uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(end._time-start._time).count();
+    }
+    static Uint64 ellapsedMicros(const Timestamp& start, const Timestamp& end) {
+        return ellapsedNanos(start, end)/1000;
+    }
+    static Uint64 ellapsedMillis(const Timestamp& start, const Timestamp& end) {
+        return ellapsedNanos(start, end)/1000000;
+    }
+};
+
+typedef Sint64 TouchID;
+
+/** A touch sample */
+struct TouchEvent {
+    Timestamp timestamp;
+    TouchID touch;
+    Vec2 position;
+    float pressure;
+};
+
+/** A JSON value that is always empty */
+class JsonValue {
+public:
+    std::shared_ptr<JsonValue> get(const std::string&) const { return nullptr; }
+    std::shared_ptr<JsonValue> get(int) const { return nullptr; }
+    std::vector<std::shared_ptr<JsonValue>> children() const { return {}; }
+    size_t size() const { return 0; }
+    bool asBool(bool value = false) const { return value; }
+    int asInt(int value = 0) const { return value; }
+    float asFloat(float value = 0) const { return value; }
+    std::string asString(const std::string& value = "") const { return value; }
+    bool getBool(const std::string&, bool value = false) const { return value; }
+    int getInt(const std::string&, int value = 0) const { return value; }
+    float getFloat(const std::string&, float value = 0) const { return value; }
+    std::string getString(const std::string&, const std::string& value = "") const { return value; }
+};
+
+/** A file reader over a plain binary file */
+class BinaryReader {
+private:
+    std::ifstream _file;
+
+public:
+    static std::shared_ptr<BinaryReader> alloc(const std::string& path) {
+        auto result = std::make_shared<BinaryReader>();
+        result->_file.open(path, std::ios::binary);
+        return result->_file.is_open() ? result : nullptr;
+    }
+    size_t read(char* buffer, size_t maximum) {
+        _file.read(buffer, (std::streamsize)maximum);
+        return (size_t)_file.gcount();
+    }
+    void close() { _file.close(); }
+};
+
+namespace graphics {
+    /** A texture with no image */
+    class Texture {
+    public:
+        Size getSize() const { return Size(); }
+    };
+
+    /** A sprite batch that draws nothing */
+    class SpriteBatch {
+    public:
+        void draw(const std::shared_ptr<Texture>&, const Vec2&, const Affine2&) {}
+        void draw(const std::shared_ptr<Texture>&, const Color4&, const Vec2&, const Affine2&) {}
+    };
+}
+
+namespace audio {}
+
+}
+
+#endif /* __CUGL_SHIM_H__ */
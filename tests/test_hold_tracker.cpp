@@ -0,0 +1,151 @@
+//
+//  test_hold_tracker.cpp
+//  Demo tests
+//
+//  Tests for HoldTracker, driven by synthetic song times: holds across beat
+//  boundaries, across a tempo change, restarted holds, and the limits.
+//
+#include <cugl/cugl.h>
+#include <utility>
+#include <vector>
+#include "HoldTracker.h"
+#include "TestMain.h"
+
+using namespace cugl;
+
+/** The ticks reported by an update, as (touch, beat) pairs */
+typedef std::vector<std::pair<TouchID, Sint64>> Ticks;
+
+/** Updates a tracker and returns the ticks it reported */
+static Ticks update(HoldTracker& holds, SongTime now, const TempoMap& tempo) {
+    Ticks ticks;
+    holds.update(now, tempo, [&ticks](TouchID touch, Sint64 beat) {
+        ticks.push_back({touch, beat});
+    });
+    return ticks;
+}
+
+TEST(beat_boundaries) {
+    TempoMap tempo;
+    tempo.init(SongTime::fromMillis(500));
+    HoldTracker holds;
+    CHECK(holds.begin(1, SongTime::fromMillis(10), tempo));
+    CHECK(holds.getCount() == 1);
+
+    // Nothing until the beat after the press
+    CHECK(update(holds, SongTime::fromMillis(499), tempo).empty());
+    Ticks ticks = update(holds, SongTime::fromMillis(500), tempo);
+    CHECK(ticks.size() == 1 && ticks[0] == std::make_pair((TouchID)1, (Sint64)1));
+
+    // Several beats in one update come in order
+    ticks = update(holds, SongTime::fromMillis(1750), tempo);
+    CHECK(ticks.size() == 2 && ticks[0].second == 2 && ticks[1].second == 3);
+    CHECK(update(holds, SongTime::fromMillis(1750), tempo).empty());
+
+    SongTime start;
+    Sint64 count = -1;
+    CHECK(holds.end(1, start, count));
+    CHECK(start == SongTime::fromMillis(10) && count == 3);
+    CHECK(holds.getCount() == 0);
+}
+
+TEST(press_before_beat) {
+    TempoMap tempo;
+    tempo.init(SongTime::fromMillis(500));
+    HoldTracker holds;
+
+    // The press is judged against beat 1, so beat 1 is not ticked again
+    CHECK(holds.begin(1, SongTime::fromMillis(480), tempo));
+    CHECK(update(holds, SongTime::fromMillis(999), tempo).empty());
+    Ticks ticks = update(holds, SongTime::fromMillis(1000), tempo);
+    CHECK(ticks.size() == 1 && ticks[0].second == 2);
+}
+
+TEST(tempo_change) {
+    // Twice as fast from beat 4 (at 2000 ms)
+    TempoMap tempo;
+    tempo.init(SongTime::fromMillis(500));
+    CHECK(tempo.addChange(4, SongTime::fromMillis(250), 4, 4));
+    HoldTracker holds;
+    CHECK(holds.begin(1, SongTime(), tempo));
+
+    CHECK(update(holds, SongTime::fromMillis(2000), tempo).size() == 4);
+    CHECK(update(holds, SongTime::fromMillis(2249), tempo).empty());
+    Ticks ticks = update(holds, SongTime::fromMillis(2500), tempo);
+    CHECK(ticks.size() == 2 && ticks[0].second == 5 && ticks[1].second == 6);
+
+    SongTime start;
+    Sint64 count = 0;
+    CHECK(holds.end(1, start, count) && count == 6);
+}
+
+TEST(restarted_hold) {
+    TempoMap tempo;
+    tempo.init(SongTime::fromMillis(500));
+    HoldTracker holds;
+    CHECK(holds.begin(1, SongTime(), tempo));
+    CHECK(update(holds, SongTime::fromMillis(1000), tempo).size() == 2);
+
+    // A second press of the same finger starts over at its own beat
+    CHECK(holds.begin(1, SongTime::fromMillis(1200), tempo));
+    CHECK(holds.getCount() == 1);
+    CHECK(update(holds, SongTime::fromMillis(1499), tempo).empty());
+    Ticks ticks = update(holds, SongTime::fromMillis(1500), tempo);
+    CHECK(ticks.size() == 1 && ticks[0].second == 3);
+
+    SongTime start;
+    Sint64 count = 0;
+    CHECK(holds.end(1, start, count));
+    CHECK(start == SongTime::fromMillis(1200) && count == 1);
+}
+
+TEST(separate_fingers) {
+    TempoMap tempo;
+    tempo.init(SongTime::fromMillis(500));
+    HoldTracker holds;
+    CHECK(holds.begin(1, SongTime(), tempo));
+    CHECK(holds.begin(2, SongTime::fromMillis(1000), tempo));
+    CHECK(holds.getCount() == 2);
+
+    Ticks ticks = update(holds, SongTime::fromMillis(1500), tempo);
+    int first = 0;
+    int second = 0;
+    for (auto& tick : ticks) {
+        first  += tick.first == 1;
+        second += tick.first == 2 && tick.second == 3;
+    }
+    CHECK(first == 3 && second == 1);
+
+    // Ending one finger leaves the other holding
+    SongTime start;
+    Sint64 count = 0;
+    CHECK(holds.end(1, start, count) && count == 3);
+    CHECK(holds.getCount() == 1);
+    CHECK(update(holds, SongTime::fromMillis(2000), tempo).size() == 1);
+}
+
+TEST(limits) {
+    TempoMap tempo;
+    tempo.init(SongTime::fromMillis(500));
+    HoldTracker holds;
+    for (int ii = 0; ii < MAX_HOLDS; ii++) {
+        CHECK(holds.begin(ii, SongTime(), tempo));
+    }
+    CHECK(!holds.begin(MAX_HOLDS, SongTime(), tempo));
+    CHECK(holds.getCount() == MAX_HOLDS);
+
+    // A finger that is not holding leaves the arguments alone
+    SongTime start = SongTime::fromMillis(7);
+    Sint64 count = 7;
+    CHECK(!holds.end(MAX_HOLDS, start, count));
+    CHECK(start == SongTime::fromMillis(7) && count == 7);
+
+    holds.reset();
+    CHECK(holds.getCount() == 0);
+    CHECK(!holds.end(0, start, count));
+    CHECK(update(holds, SongTime::fromSeconds(10), tempo).empty());
+}
+
+int main() {
+    return runTests();
+}
@@ -0,0 +1,221 @@
+//
+//  test_replay.cpp
+//  Demo tests
+//
+//  Tests for GameSimulation replays: a scripted session is played the way
+//  GameScene plays it live (recording every input it feeds), saved, loaded
+//  back and replayed, and the replay must end in the same state.
+//
+#include <cugl/cugl.h>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "GameSimulation.h"
+#include "InputRecording.h"
+#include "TestMain.h"
+
+using namespace cugl;
+
+/** The length of one simulation step */
+static const SongTime STEP = SongTime::fromSeconds(1.0/60);
+/** The number of scripted measures */
+#define SESSION_MEASURES    24
+/** The overlay is toggled every this many measures */
+#define OVERLAY_MEASURES    3
+
+/** A 8x8 room with a short wall */
+static void buildGrid(TileGrid& grid) {
+    grid.init(8, 8, 1.0f);
+    for (int row = 2; row < 6; row++) {
+        grid.setType(row, 4, TileType::WALL);
+    }
+}
+
+/** Sets up a simulation of the test level */
+static void buildLevel(GameSimulation& sim, const TileGrid& grid, const TempoMap& tempo) {
+    sim.init(std::make_shared<JsonValue>(), grid, tempo, "");
+    std::vector<Guard> guards;
+    guards.emplace_back(0, grid.toCell(6, 6), std::vector<int>{grid.toCell(6, 1), grid.toCell(1, 6)});
+    guards.emplace_back(1, grid.toCell(1, 7), std::vector<int>{grid.toCell(7, 7), grid.toCell(1, 1)});
+    ValuableSet valuables;
+    valuables.init(std::make_shared<JsonValue>(), grid);
+    for (int row = 0; row < 8; row += 2) {
+        for (int col = 0; col < 8; col += 3) {
+            valuables.spawnValuable(Vec2(col+0.5f, row+0.5f), 1+(row+col)%2);
+        }
+    }
+    sim.setStart(0, Vec2(2.5f, 2.5f), guards, valuables);
+}
+
+/** Returns a gesture made at the given song times */
+static Gesture makeGesture(GestureType type, TouchID touch, SongTime start, SongTime end) {
+    Gesture gesture;
+    gesture.type = type;
+    gesture.start.touch = touch;
+    gesture.start.position = Vec2::ZERO;
+    gesture.start.pressure = 1;
+    gesture.end = gesture.start;
+    gesture.startTime = start;
+    gesture.endTime = end;
+    gesture.stamped = true;
+    return gesture;
+}
+
+/**
+ * Returns a scripted session, in the order the gestures are decided.
+ *
+ * Each measure repeats a swipe, a tap or a hold on its input beats (a
+ * little off the beat), and sometimes swipes on its output beats too.
+ */
+static std::vector<Gesture> script(const TempoMap& tempo) {
+    std::mt19937 random(2);
+    auto jitter = [&random]() { return SongTime::fromMillis((int)(random() % 80)-40); };
+    const GestureType swipes[] = {GestureType::Up, GestureType::Down, GestureType::Left, GestureType::Right};
+    std::vector<Gesture> gestures;
+    for (Sint64 measure = 1; measure <= SESSION_MEASURES; measure++) {
+        Sint64 first = measure*4;
+        int action = random() % 6;
+        for (Sint64 beat = first; beat < first+2; beat++) {
+            SongTime press = tempo.getBeatTime(beat)+jitter();
+            if (action < 4) {
+                gestures.push_back(makeGesture(swipes[action], 0, press, press+SongTime::fromMillis(60)));
+            } else if (action == 4) {
+                gestures.push_back(makeGesture(GestureType::Tap, 0, press, press+SongTime::fromMillis(90)));
+            } else if (beat == first) {
+                // Held through the next beat
+                gestures.push_back(makeGesture(GestureType::Hold, 1, press, press+SongTime::fromMillis(300)));
+                gestures.push_back(makeGesture(GestureType::HoldEnd, 1, press, press+SongTime::fromMillis(800)));
+            }
+        }
+        if (random() % 2) {
+            SongTime press = tempo.getBeatTime(first+2+random()%2)+jitter();
+            gestures.push_back(makeGesture(swipes[random()%4], 0, press, press+SongTime::fromMillis(60)));
+        }
+    }
+    std::stable_sort(gestures.begin(), gestures.end(), [](const Gesture& a, const Gesture& b) {
+        return a.endTime < b.endTime;
+    });
+    return gestures;
+}
+
+TEST(record_save_load_replay) {
+    TempoMap tempo;
+    tempo.init(SongTime::fromBPM(120));
+    TileGrid grid;
+    buildGrid(grid);
+    std::vector<Gesture> gestures = script(tempo);
+    std::vector<SongTime> overlays;
+    for (Sint64 measure = OVERLAY_MEASURES; measure <= SESSION_MEASURES; measure += OVERLAY_MEASURES) {
+        overlays.push_back(tempo.getBeatTime(measure*4+3));
+    }
+
+    // Play the session live, feeding each input to the step that is due
+    GameSimulation live;
+    buildLevel(live, grid, tempo);
+    int judged = 0;
+    live.setJudgeListener([&judged](const Gesture&, Judgement) { judged++; });
+    const Uint32 seed = 1234;
+    InputRecording recording;
+    recording.start(seed, SongTime());
+    live.scheduleBeats(SongTime());
+    live.reset(seed, SongTime());
+
+    SongTime time;
+    size_t next = 0;
+    size_t toggled = 0;
+    int startCell = live.getCell();
+    bool moved = false;
+    auto advance = [&]() {
+        time += STEP;
+        while (next < gestures.size() && gestures[next].endTime <= time) {
+            live.addGesture(gestures[next]);
+            recording.addGesture(gestures[next]);
+            next++;
+        }
+        if (toggled < overlays.size() && overlays[toggled] <= time) {
+            live.toggleOverlay();
+            recording.addOverlay(time);
+            toggled++;
+        }
+        live.step(time);
+        moved = moved || live.getCell() != startCell;
+    };
+    while (next < gestures.size() || toggled < overlays.size()) {
+        advance();
+    }
+    SongTime end = live.getReplayEnd(recording);
+    while (time+STEP <= end) {
+        advance();
+    }
+    CHECK(live.getStats().getCount() > 0);
+    CHECK(judged > 0);
+    CHECK(moved);
+
+    // Save and load it back
+    std::string path = "test_replay.bin";
+    CHECK(recording.save(path));
+    InputRecording loaded;
+    CHECK(loaded.load(path));
+    std::remove(path.c_str());
+    CHECK(loaded.getSeed() == seed && loaded.getStart() == SongTime());
+    CHECK(loaded.size() == gestures.size()+overlays.size());
+
+    // The replay judges the same and ends in the same cells
+    GameSimulation replayed;
+    buildLevel(replayed, grid, tempo);
+    int replayJudged = 0;
+    replayed.setJudgeListener([&replayJudged](const Gesture&, Judgement) { replayJudged++; });
+    replayed.replay(loaded, STEP);
+    CHECK(replayJudged == 0);
+    CHECK(replayed.getTime() == time);
+
+    const HitStats& expected = live.getStats();
+    const HitStats& actual = replayed.getStats();
+    CHECK(actual.getCount() == expected.getCount());
+    for (int ii = 0; ii < JUDGEMENT_COUNT; ii++) {
+        CHECK(actual.getCount((Judgement)ii) == expected.getCount((Judgement)ii));
+    }
+    for (int ii = 0; ii < DIRECTION_COUNT; ii++) {
+        CHECK(actual.getCount((Direction)ii) == expected.getCount((Direction)ii));
+    }
+    CHECK(actual.getMean() == expected.getMean());
+    CHECK(actual.getP95() == expected.getP95());
+    CHECK(replayed.getJudge().getScore() == live.getJudge().getScore());
+    CHECK(replayed.getJudge().getMaxCombo() == live.getJudge().getMaxCombo());
+
+    CHECK(replayed.getCell() == live.getCell());
+    CHECK(replayed.getCarried() == live.getCarried());
+    CHECK(replayed.getGuards().size() == live.getGuards().size());
+    for (size_t ii = 0; ii < live.getGuards().size(); ii++) {
+        CHECK(replayed.getGuards()[ii].getCell() == live.getGuards()[ii].getCell());
+    }
+}
+
+TEST(truncated_recording) {
+    InputRecording recording;
+    recording.start(1, SongTime());
+    recording.addGesture(makeGesture(GestureType::Tap, 0, SongTime::fromMillis(10), SongTime::fromMillis(90)));
+    std::string path = "test_replay_truncated.bin";
+    CHECK(recording.save(path));
+    std::FILE* file = std::fopen(path.c_str(), "r+b");
+    CHECK(file != nullptr);
+    if (file != nullptr) {
+        // Claim far more records than the file has
+        ReplayHeader header;
+        CHECK(std::fread(&header, sizeof(header), 1, file) == 1);
+        header.count = 0xFFFFFFFF;
+        std::fseek(file, 0, SEEK_SET);
+        std::fwrite(&header, sizeof(header), 1, file);
+        std::fclose(file);
+    }
+    InputRecording loaded;
+    CHECK(!loaded.load(path));
+    CHECK(loaded.size() == 0);
+    std::remove(path.c_str());
+}
+
+int main() {
+    return runTests();
+}
@@ -0,0 +1,149 @@
+//
+//  test_spsc_ring.cpp
+//  Demo tests
+//
+//  Tests for SpscRing, with a producer and a consumer thread passing
+//  synthetic gestures the way InputController does: the producer never
+//  blocks, and the consumer peeks at a gesture (stamping it in place)
+//  before popping it.
+//
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "SpscRing.h"
+#include "TestMain.h"
+
+/** The capacity of the ring (the same as the gesture queue) */
+#define RING_SIZE   64
+
+/** A record shaped like a Gesture, with every field derived from its number */
+struct Record {
+    /** The position of the record in the stream */
+    long sequence;
+    /** The finger of the gesture */
+    long touch;
+    /** The press time */
+    long start;
+    /** The decision time */
+    long end;
+    /** Whether the consumer has stamped the record */
+    bool stamped;
+};
+
+/** Returns the record with the given number */
+static Record makeRecord(long sequence) {
+    return {sequence, sequence % 10, sequence*3, sequence*3+1, false};
+}
+
+/** Returns true if a record is the one with the given number, whole */
+static bool isRecord(const Record& record, long sequence) {
+    Record expected = makeRecord(sequence);
+    return record.sequence == expected.sequence && record.touch == expected.touch &&
+           record.start == expected.start && record.end == expected.end;
+}
+
+/**
+ * Passes records from a producer thread to this thread.
+ *
+ * The producer sends count records, rate per second (or as fast as it can
+ * if rate is 0), waiting whenever the ring is full. A test cannot promise
+ * the consumer is never preempted for longer than the ring lasts, so the
+ * waits are counted rather than failed. The consumer checks every record
+ * in order.
+ *
+ * @return the number of times the producer found the ring full
+ */
+static long stream(long count, long rate, long& received, bool& ordered) {
+    static SpscRing<Record, RING_SIZE> ring;
+    std::atomic<bool> done(false);
+    long waits = 0;
+
+    std::thread producer([&]() {
+        auto began = std::chrono::steady_clock::now();
+        for (long ii = 0; ii < count; ii++) {
+            if (rate > 0) {
+                std::this_thread::sleep_until(began+std::chrono::microseconds(ii*1000000/rate));
+            }
+            while (!ring.push(makeRecord(ii))) {
+                waits++;
+                std::this_thread::yield();
+            }
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    received = 0;
+    ordered = true;
+    long last = -1;
+    while (true) {
+        Record* record = ring.peek();
+        if (record == nullptr) {
+            // The producer may have pushed between the peek and the flag
+            if (done.load(std::memory_order_acquire) && ring.isEmpty()) {
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        record->stamped = true;
+        Record item;
+        if (!ring.pop(item)) {
+            // Cannot happen after a successful peek
+            ordered = false;
+            continue;
+        }
+        if (item.sequence != last+1 || !item.stamped || !isRecord(item, item.sequence)) {
+            ordered = false;
+        }
+        last = item.sequence;
+        received++;
+    }
+    producer.join();
+    return waits;
+}
+
+TEST(single_thread) {
+    SpscRing<Record, 4> ring;
+    CHECK(ring.isEmpty() && ring.capacity() == 4);
+    for (long ii = 0; ii < 4; ii++) {
+        CHECK(ring.push(makeRecord(ii)));
+    }
+    CHECK(!ring.push(makeRecord(4)));
+    CHECK(ring.size() == 4);
+    CHECK(ring.peek(3) != nullptr && isRecord(*ring.peek(3), 3));
+    CHECK(ring.peek(4) == nullptr);
+
+    // Wrap around several times
+    Record item;
+    for (long ii = 0; ii < 20; ii++) {
+        CHECK(ring.pop(item) && isRecord(item, ii));
+        CHECK(ring.push(makeRecord(ii+4)));
+    }
+    CHECK(ring.size() == 4);
+}
+
+TEST(paced_gestures) {
+    // Far more gestures than fingers can make, as a game would see them
+    long received = 0;
+    bool ordered = false;
+    long waits = stream(4000, 8000, received, ordered);
+    std::printf("paced: %ld received, ring full %ld times\n", received, waits);
+    CHECK(received == 4000);
+    CHECK(ordered);
+}
+
+TEST(flooded_gestures) {
+    // As fast as possible, with the producer waiting for room
+    long received = 0;
+    bool ordered = false;
+    auto began = std::chrono::steady_clock::now();
+    stream(1000000, 0, received, ordered);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-began).count();
+    std::printf("flooded: %ld received in %.3f s\n", received, seconds);
+    CHECK(received == 1000000);
+    CHECK(ordered);
+}
+
+int main() {
+    return runTests();
+}